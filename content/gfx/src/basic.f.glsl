@@ -2,8 +2,12 @@
 
 out vec4 frag_out;
 
+#include "gfx/src/lod_dither.glsl"
+
 void main()
 {
+    if (lod_dithered()) discard;
+
     // if (distance(gl_FragCoord.xyz / gl_FragCoord.w, pos) > 20.0f) discard;
 
     // if (distance(gl_PointCoord, vec2(0.5f, 0.5f)) > 0.5f) discard;
@@ -2,12 +2,9 @@
 
 uniform sampler2D font;
 
-uniform vec3 fgcolor;
-uniform vec3 bgcolor;
-
-uniform int index;
-
 in vec2 st;
+flat in uint charindex;
+flat in vec4 fgcolor;
 
 out vec4 frag_out;
 
@@ -20,6 +17,7 @@ void main()
     float charwidth = 1.0 / 16;
     float charheight = 1.0 / 8;
 
+    int index = int(charindex);
     int x = index % 16;
     int y = (8 - 1) - (index / 16); // flip for opengl texture coordinates
 
@@ -32,5 +30,5 @@ void main()
     {
         discard;
     }
-    else frag_out = pixel * vec4(fgcolor, 1.0); 
+    else frag_out = pixel * fgcolor; 
 }
\ No newline at end of file
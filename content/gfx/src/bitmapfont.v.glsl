@@ -2,13 +2,23 @@
 
 layout (location = 0) in vec4 position;
 
-uniform mat4 model;
+// per glyph
+layout (location = 1) in vec2 offset;
+layout (location = 2) in float scale;
+layout (location = 3) in uint index;
+layout (location = 4) in vec4 color;
+
 uniform mat4 projection;
+uniform vec2 charsize;
 
 out vec2 st;
+flat out uint charindex;
+flat out vec4 fgcolor;
 
 void main()
 {
     st = position.zw;
-    gl_Position = projection * model * vec4(position.xy, 0.0, 1.0);
+    charindex = index;
+    fgcolor = color;
+    gl_Position = projection * vec4(offset + position.xy * charsize * scale, 0.0, 1.0);
 }
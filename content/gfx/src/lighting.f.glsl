@@ -1,42 +1,72 @@
-#version 410 core
+#version 400 core
 
-#define MAX_TOTAL_LIGHTS 100
-#define MAX_CLUSTERS 1000
-#define MAX_CLUSTER_LIGHTS 50 
+// clustered forward lighting, see src/lolita.h. the cpu sorts the lights into a grid of
+// view space clusters, every fragment only walks the lights of the cluster its in.
 
-struct light_t
-{
-    int type;
-    vec4 position;
-    float strength;
-};
+out vec4 frag_out;
 
-struct light_reference_t
-{
-    int offset;
-    int count;
-};
+in vec2 st;
+in vec3 world_position;
+
+uniform sampler2D texture0;
 
 layout (std140) uniform lighting
 {
-    light_t global_light_list[MAX_TOTAL_LIGHTS];
-    uint global_light_indices[MAX_CLUSTERS * MAX_CLUSTER_LIGHTS];
-    light_reference_t light_references[MAX_CLUSTERS];
+    ivec4 cluster_grid; // horizontal, vertical, depth slices, light count
+    vec4 cluster_tile; // pixels per tile
+    vec4 cluster_depth; // near, far, slice scale, slice bias
+    vec4 ambient;
 };
 
-uint find_this_cluster(vec3 coordinates){
-    return 0; // cluster index
+uniform samplerBuffer lights; // 2 per light: position + radius, color + type
+uniform isamplerBuffer cluster_lights; // offset, count into light_indices
+uniform usamplerBuffer light_indices;
+
+#include "gfx/src/lod_dither.glsl"
+
+// same layout as the cpu grid: x + y * horizontal + z * horizontal * vertical, tiles from the bottom left
+uint find_this_cluster(vec3 coordinates)
+{
+    float depth_near = cluster_depth.x, depth_far = cluster_depth.y;
+    float view_depth = 2.0 * depth_near * depth_far / (depth_far + depth_near - (coordinates.z * 2.0 - 1.0) * (depth_far - depth_near));
+
+    uint slice = uint(clamp(log(view_depth) * cluster_depth.z - cluster_depth.w, 0.0, float(cluster_grid.z - 1)));
+    uvec2 tile = uvec2(clamp(coordinates.xy / cluster_tile.xy, vec2(0.0), vec2(cluster_grid.xy - 1)));
+
+    return tile.x + tile.y * uint(cluster_grid.x) + slice * uint(cluster_grid.x * cluster_grid.y);
 }
 
-vec4 calculate_lighting_additive()
+vec3 calculate_lighting_additive(vec3 normal)
 {
-    uint cluster = find_this_cluster(gl_FragCoord.xyz);
+    ivec2 reference = texelFetch(cluster_lights, int(find_this_cluster(gl_FragCoord.xyz))).xy;
+    vec3 total = vec3(0.0);
 
-    for (int i = 0; i < light_references[cluster].count; i++)
+    for (int i = 0; i < reference.y; i++)
     {
-        // APPLY POINT LIGHT
-        // +++++ surfaces should only be lit by a surface if that normal is facing towards this light
-        //       aka how much a light affects a given surface should be dictated by the angle between
-        //       the normal and the vector from the light to the vertex.
+        int light = int(texelFetch(light_indices, reference.x + i).r);
+        vec4 position = texelFetch(lights, light * 2);
+        vec4 color = texelFetch(lights, light * 2 + 1);
+
+        // surfaces only get lit by the lights they face, windowed so its 0 at the radius
+        // (the clusters were picked with that radius)
+        vec3 to_light = position.xyz - world_position;
+        float distance = length(to_light);
+        float window = clamp(1.0 - pow(distance / position.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+
+        total += color.rgb * attenuation * max(dot(normal, to_light / max(distance, 0.0001)), 0.0);
     }
-}
\ No newline at end of file
+
+    return total;
+}
+
+void main()
+{
+    if (lod_dithered()) discard;
+
+    // flat normal from the position derivatives, faces the camera
+    vec3 normal = normalize(cross(dFdx(world_position), dFdy(world_position)));
+
+    vec4 albedo = texture(texture0, st);
+    frag_out = vec4(albedo.rgb * (ambient.rgb + calculate_lighting_additive(normal)), albedo.a);
+}
@@ -0,0 +1,33 @@
+#version 400 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 texc;
+layout (location = 8) in mat4 instance_model; // identity unless drawn instanced
+
+layout (std140) uniform mvp
+{
+    mat4 model;
+    vec4 position_scale; // quantized positions, w = lod fade
+    vec4 position_bias;
+};
+
+layout (std140) uniform viewprojection
+{
+    mat4 view;
+    mat4 projection;
+};
+
+out vec2 st;
+out vec3 world_position; // lights are in world space
+
+flat out float lod_fade;
+
+void main()
+{
+    lod_fade = position_scale.w;
+    st = texc;
+
+    vec4 world = model * instance_model * vec4(position * position_scale.xyz + position_bias.xyz, 1.0);
+    world_position = world.xyz;
+    gl_Position = projection * view * world;
+}
@@ -0,0 +1,13 @@
+// shared by every fragment shader that draws lodded geometry, pulled in with
+// #include "gfx/src/lod_dither.glsl" (program_load_from_files splices it in)
+
+flat in float lod_fade; // 0, or which half of a lod transition this draw is
+
+// 4x4 bayer, levels in a transition keep complementary pixels
+bool lod_dithered()
+{
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    float threshold = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+    return lod_fade > 0.0 ? threshold >= lod_fade : lod_fade < 0.0 && threshold < -lod_fade;
+}
@@ -6,6 +6,10 @@ out vec3 texture_coordinates;
 layout (std140) uniform mvp
 {
     mat4 model;
+};
+
+layout (std140) uniform viewprojection
+{
     mat4 view;
     mat4 projection;
 };
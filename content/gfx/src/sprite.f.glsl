@@ -0,0 +1,13 @@
+#version 400 core
+
+uniform sampler2D atlas;
+
+in vec2 st;
+flat in vec4 color;
+
+out vec4 frag_out;
+
+void main()
+{
+    frag_out = texture(atlas, st) * color;
+}
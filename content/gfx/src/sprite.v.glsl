@@ -0,0 +1,27 @@
+#version 400 core
+
+layout (location = 0) in vec4 position;
+
+// per sprite
+layout (location = 1) in vec4 rect; // top left xy, size zw
+layout (location = 2) in float rotation;
+layout (location = 3) in vec4 uv; // min xy, max zw
+layout (location = 4) in vec4 tint;
+
+uniform mat4 projection;
+
+out vec2 st;
+flat out vec4 color;
+
+void main()
+{
+    // rotate around the center
+    vec2 local = (position.xy - 0.5) * rect.zw;
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 rotated = vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    st = mix(uv.xy, uv.zw, position.zw);
+    color = tint;
+    gl_Position = projection * vec4(rect.xy + rect.zw * 0.5 + rotated, 0.0, 1.0);
+}
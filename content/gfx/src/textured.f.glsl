@@ -6,7 +6,11 @@ in vec2 st;
 
 uniform sampler2D texture0;
 
+#include "gfx/src/lod_dither.glsl"
+
 void main()
 {
+    if (lod_dithered()) discard;
+
     frag_out = texture(texture0, st);
 }
\ No newline at end of file
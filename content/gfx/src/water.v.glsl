@@ -2,10 +2,17 @@
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 texture;
+layout (location = 8) in mat4 instance_model; // identity unless drawn instanced
 
 layout (std140) uniform mvp
 {
     mat4 model;
+    vec4 position_scale; // quantized positions, w = lod fade
+    vec4 position_bias;
+};
+
+layout (std140) uniform viewprojection
+{
     mat4 view;
     mat4 projection;
 };
@@ -15,5 +22,5 @@ out vec2 st;
 void main()
 {
     st = texture;
-    gl_Position = projection * view * model * vec4(position, 1.0);
+    gl_Position = projection * view * model * instance_model * vec4(position * position_scale.xyz + position_bias.xyz, 1.0);
 }
\ No newline at end of file
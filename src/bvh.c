@@ -0,0 +1,467 @@
+#include "bvh.h"
+#include "jobs.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+// BUILDING
+// --------
+typedef struct bvh_build_s
+{
+    bvh_t* bvh;
+    vec3_t* centroids;
+    int node_cursor; // next free node, bumped atomically since subtrees build in parallel
+} bvh_build_t;
+
+typedef struct bvh_task_s
+{
+    bvh_build_t* build;
+    int node, first, count, depth;
+} bvh_task_t;
+
+static float _half_area(vec3_t min, vec3_t max)
+{
+    vec3_t d = HMM_SubtractVec3(max, min);
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static void _grow(vec3_t* min, vec3_t* max, vec3_t other_min, vec3_t other_max)
+{
+    *min = HMM_Vec3(HMM_MIN(min->x, other_min.x), HMM_MIN(min->y, other_min.y), HMM_MIN(min->z, other_min.z));
+    *max = HMM_Vec3(HMM_MAX(max->x, other_max.x), HMM_MAX(max->y, other_max.y), HMM_MAX(max->z, other_max.z));
+}
+
+static int _bin_of(float value, float min, float scale)
+{
+    int bin = (int) ((value - min) * scale);
+    return bin < 0 ? 0 : bin >= BVH_BINS ? BVH_BINS - 1 : bin;
+}
+
+static void _build_node(bvh_build_t* build, int node_index, int first, int count, int depth);
+
+static void _build_worker(void* arg, int first, int count)
+{
+    bvh_task_t* task = arg;
+    _build_node(task->build, task->node, task->first, task->count, task->depth);
+}
+
+static void _build_node(bvh_build_t* build, int node_index, int first, int count, int depth)
+{
+    bvh_t* bvh = build->bvh;
+    bvh_node_t* node = &bvh->nodes[node_index];
+    int* indices = bvh->indices;
+
+    vec3_t min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX), max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    vec3_t centroid_min = min, centroid_max = max;
+    for (int i = first; i < first + count; i++)
+    {
+        _grow(&min, &max, bvh->bounds[indices[i]].min, bvh->bounds[indices[i]].max);
+        _grow(&centroid_min, &centroid_max, build->centroids[indices[i]], build->centroids[indices[i]]);
+    }
+
+    node->min = min;
+    node->max = max;
+    node->first = first;
+    node->count = count;
+
+    if (count <= 2 || depth >= BVH_MAX_DEPTH - 1) return;
+
+    // sah over BVH_BINS buckets per axis
+    float best_cost = FLT_MAX;
+    int best_axis = -1, best_split = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float extent = centroid_max.elements[axis] - centroid_min.elements[axis];
+        if (extent <= 0.0f) continue;
+        float scale = BVH_BINS / extent;
+
+        int bin_count[BVH_BINS] = { 0 };
+        vec3_t bin_min[BVH_BINS], bin_max[BVH_BINS];
+        for (int b = 0; b < BVH_BINS; b++)
+        {
+            bin_min[b] = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+            bin_max[b] = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        }
+
+        for (int i = first; i < first + count; i++)
+        {
+            int item = indices[i];
+            int b = _bin_of(build->centroids[item].elements[axis], centroid_min.elements[axis], scale);
+            bin_count[b]++;
+            _grow(&bin_min[b], &bin_max[b], bvh->bounds[item].min, bvh->bounds[item].max);
+        }
+
+        // right to left sweep first, then evaluate every split on the way back
+        float right_area[BVH_BINS];
+        int right_count[BVH_BINS];
+        vec3_t sweep_min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX), sweep_max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        int sweep_count = 0;
+        for (int b = BVH_BINS - 1; b > 0; b--)
+        {
+            _grow(&sweep_min, &sweep_max, bin_min[b], bin_max[b]);
+            sweep_count += bin_count[b];
+            right_area[b] = sweep_count ? _half_area(sweep_min, sweep_max) : 0.0f;
+            right_count[b] = sweep_count;
+        }
+
+        sweep_min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+        sweep_max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        sweep_count = 0;
+        for (int b = 1; b < BVH_BINS; b++)
+        {
+            _grow(&sweep_min, &sweep_max, bin_min[b - 1], bin_max[b - 1]);
+            sweep_count += bin_count[b - 1];
+            if (!sweep_count || !right_count[b]) continue;
+
+            float cost = _half_area(sweep_min, sweep_max) * sweep_count + right_area[b] * right_count[b];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = b;
+            }
+        }
+    }
+
+    // traversal is about as expensive as one item test
+    float leaf_cost = (float) count;
+    float area = _half_area(min, max);
+    best_cost = area > 0.0f ? 1.0f + best_cost / area : FLT_MAX;
+
+    int middle;
+    if (best_axis >= 0 && (best_cost < leaf_cost || count > BVH_MAX_LEAF))
+    {
+        float scale = BVH_BINS / (centroid_max.elements[best_axis] - centroid_min.elements[best_axis]);
+        int i = first, j = first + count - 1;
+        while (i <= j)
+        {
+            if (_bin_of(build->centroids[indices[i]].elements[best_axis], centroid_min.elements[best_axis], scale) < best_split) i++;
+            else
+            {
+                int swap = indices[i];
+                indices[i] = indices[j];
+                indices[j--] = swap;
+            }
+        }
+        middle = i;
+    }
+    else if (count > BVH_MAX_LEAF)
+    {
+        middle = first + count / 2; // all centroids on top of each other, any split is as good
+    }
+    else return; // stays a leaf
+
+    int left = __atomic_fetch_add(&build->node_cursor, 2, __ATOMIC_RELAXED);
+    node->first = left;
+    node->count = 0;
+
+    // the left half goes to the job system while we do the right one, then we help until its done
+    bvh_task_t task = { build, left, first, middle - first, depth + 1 };
+    job_counter_t done = { 0 };
+    if (count > BVH_PARALLEL_THRESHOLD) job_submit(_build_worker, &task, &done);
+    else _build_worker(&task, 0, 1);
+
+    _build_node(build, left + 1, middle, first + count - middle, depth + 1);
+    job_wait(&done);
+}
+
+void bvh_build(bvh_t* this, const bvh_bounds_t* bounds, int count)
+{
+    memset(this, 0, sizeof(*this));
+    this->count = count;
+    if (!count) return;
+
+    this->bounds = malloc(sizeof(bvh_bounds_t) * count);
+    this->indices = malloc(sizeof(int) * count);
+    this->nodes = malloc(sizeof(bvh_node_t) * (2 * count - 1)); // never more than that for a binary tree
+
+    vec3_t* centroids = malloc(sizeof(vec3_t) * count);
+    memcpy(this->bounds, bounds, sizeof(bvh_bounds_t) * count);
+    for (int i = 0; i < count; i++)
+    {
+        this->indices[i] = i;
+        centroids[i] = HMM_MultiplyVec3f(HMM_AddVec3(bounds[i].min, bounds[i].max), 0.5f);
+    }
+
+    bvh_build_t build = { this, centroids, 1 };
+    _build_node(&build, 0, 0, count, 0);
+    this->node_count = build.node_cursor;
+
+    free(centroids);
+}
+
+void bvh_refit(bvh_t* this, const bvh_bounds_t* bounds)
+{
+    memcpy(this->bounds, bounds, sizeof(bvh_bounds_t) * this->count);
+
+    // children always come after their parent
+    for (int n = this->node_count - 1; n >= 0; n--)
+    {
+        bvh_node_t* node = &this->nodes[n];
+        vec3_t min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX), max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+        if (node->count)
+        {
+            for (int i = node->first; i < node->first + node->count; i++) _grow(&min, &max, this->bounds[this->indices[i]].min, this->bounds[this->indices[i]].max);
+        }
+        else
+        {
+            _grow(&min, &max, this->nodes[node->first].min, this->nodes[node->first].max);
+            _grow(&min, &max, this->nodes[node->first + 1].min, this->nodes[node->first + 1].max);
+        }
+
+        node->min = min;
+        node->max = max;
+    }
+}
+
+void bvh_free(bvh_t* this)
+{
+    free(this->nodes);
+    free(this->indices);
+    free(this->bounds);
+    memset(this, 0, sizeof(*this));
+}
+
+// QUERIES
+// -------
+static void _emit(int* out, int max_out, int* found, int item)
+{
+    if (*found < max_out) out[*found] = item;
+    (*found)++;
+}
+
+static void _emit_subtree(const bvh_t* this, int node_index, int* out, int max_out, int* found)
+{
+    int stack[BVH_MAX_DEPTH * 2], top = 0;
+    stack[top++] = node_index;
+
+    while (top)
+    {
+        const bvh_node_t* node = &this->nodes[stack[--top]];
+        if (node->count)
+        {
+            for (int i = node->first; i < node->first + node->count; i++) _emit(out, max_out, found, this->indices[i]);
+            continue;
+        }
+
+        stack[top++] = node->first + 1;
+        stack[top++] = node->first;
+    }
+}
+
+int bvh_query_frustum(const bvh_t* this, const frustum_t* frustum, int* out, int max_out)
+{
+    if (!this->count) return 0;
+
+    int stack[BVH_MAX_DEPTH * 2], top = 0, found = 0;
+    stack[top++] = 0;
+
+    while (top)
+    {
+        int node_index = stack[--top];
+        const bvh_node_t* node = &this->nodes[node_index];
+
+        vec3_t center = HMM_MultiplyVec3f(HMM_AddVec3(node->min, node->max), 0.5f);
+        vec3_t extent = HMM_MultiplyVec3f(HMM_SubtractVec3(node->max, node->min), 0.5f);
+
+        int outside = 0, inside = 1;
+        for (int p = 0; p < 6; p++)
+        {
+            vec4_t plane = frustum->planes[p];
+            float distance = HMM_DotVec3(plane.xyz, center) + plane.w;
+            float reach = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+
+            if (distance < -reach)
+            {
+                outside = 1;
+                break;
+            }
+            if (distance < reach) inside = 0;
+        }
+
+        if (outside) continue;
+
+        // whole subtree is in, no need to test anything under it
+        if (inside || node->count)
+        {
+            _emit_subtree(this, node_index, out, max_out, &found);
+            continue;
+        }
+
+        stack[top++] = node->first + 1;
+        stack[top++] = node->first;
+    }
+
+    return found;
+}
+
+static int _overlaps(vec3_t a_min, vec3_t a_max, vec3_t b_min, vec3_t b_max)
+{
+    return a_min.x <= b_max.x && a_max.x >= b_min.x && a_min.y <= b_max.y && a_max.y >= b_min.y && a_min.z <= b_max.z && a_max.z >= b_min.z;
+}
+
+int bvh_query_aabb(const bvh_t* this, vec3_t min, vec3_t max, int* out, int max_out)
+{
+    if (!this->count) return 0;
+
+    int stack[BVH_MAX_DEPTH * 2], top = 0, found = 0;
+    stack[top++] = 0;
+
+    while (top)
+    {
+        const bvh_node_t* node = &this->nodes[stack[--top]];
+        if (!_overlaps(node->min, node->max, min, max)) continue;
+
+        if (node->count)
+        {
+            for (int i = node->first; i < node->first + node->count; i++)
+            {
+                const bvh_bounds_t* bounds = &this->bounds[this->indices[i]];
+                if (_overlaps(bounds->min, bounds->max, min, max)) _emit(out, max_out, &found, this->indices[i]);
+            }
+            continue;
+        }
+
+        stack[top++] = node->first + 1;
+        stack[top++] = node->first;
+    }
+
+    return found;
+}
+
+static float _distance_squared(vec3_t point, vec3_t min, vec3_t max)
+{
+    float dx = HMM_MAX(HMM_MAX(min.x - point.x, point.x - max.x), 0.0f);
+    float dy = HMM_MAX(HMM_MAX(min.y - point.y, point.y - max.y), 0.0f);
+    float dz = HMM_MAX(HMM_MAX(min.z - point.z, point.z - max.z), 0.0f);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+int bvh_query_sphere(const bvh_t* this, vec3_t center, float radius, int* out, int max_out)
+{
+    if (!this->count) return 0;
+
+    float radius_squared = radius * radius;
+    int stack[BVH_MAX_DEPTH * 2], top = 0, found = 0;
+    stack[top++] = 0;
+
+    while (top)
+    {
+        const bvh_node_t* node = &this->nodes[stack[--top]];
+        if (_distance_squared(center, node->min, node->max) > radius_squared) continue;
+
+        if (node->count)
+        {
+            for (int i = node->first; i < node->first + node->count; i++)
+            {
+                const bvh_bounds_t* bounds = &this->bounds[this->indices[i]];
+                if (_distance_squared(center, bounds->min, bounds->max) <= radius_squared) _emit(out, max_out, &found, this->indices[i]);
+            }
+            continue;
+        }
+
+        stack[top++] = node->first + 1;
+        stack[top++] = node->first;
+    }
+
+    return found;
+}
+
+// slab test, entry distance or FLT_MAX on a miss
+static float _ray_box(vec3_t origin, vec3_t inverse_direction, float max_distance, vec3_t min, vec3_t max)
+{
+    float tx1 = (min.x - origin.x) * inverse_direction.x, tx2 = (max.x - origin.x) * inverse_direction.x;
+    float ty1 = (min.y - origin.y) * inverse_direction.y, ty2 = (max.y - origin.y) * inverse_direction.y;
+    float tz1 = (min.z - origin.z) * inverse_direction.z, tz2 = (max.z - origin.z) * inverse_direction.z;
+
+    float near = HMM_MAX(HMM_MAX(HMM_MIN(tx1, tx2), HMM_MIN(ty1, ty2)), HMM_MAX(HMM_MIN(tz1, tz2), 0.0f));
+    float far = HMM_MIN(HMM_MIN(HMM_MAX(tx1, tx2), HMM_MAX(ty1, ty2)), HMM_MIN(HMM_MAX(tz1, tz2), max_distance));
+
+    return near <= far ? near : FLT_MAX;
+}
+
+int bvh_raycast(const bvh_t* this, vec3_t origin, vec3_t direction, float max_distance, bvh_ray_test_f test, void* user, float* distance)
+{
+    if (!this->count) return -1;
+
+    // axis aligned rays would give 0 * inf = nan in the slab test when the origin is on a face
+    vec3_t safe = direction;
+    for (int i = 0; i < 3; i++)
+    {
+        if (fabsf(safe.elements[i]) < 1e-20f) safe.elements[i] = copysignf(1e-20f, safe.elements[i]);
+    }
+    vec3_t inverse_direction = HMM_Vec3(1.0f / safe.x, 1.0f / safe.y, 1.0f / safe.z);
+    int hit = -1;
+    float best = max_distance;
+
+    struct bvh_ray_entry_s { int node; float near; } stack[BVH_MAX_DEPTH * 2];
+    int top = 0;
+
+    float root = _ray_box(origin, inverse_direction, best, this->nodes[0].min, this->nodes[0].max);
+    if (root != FLT_MAX) stack[top++] = (struct bvh_ray_entry_s) { 0, root };
+
+    while (top)
+    {
+        top--;
+        if (stack[top].near > best) continue; // something closer was found since it got pushed
+        const bvh_node_t* node = &this->nodes[stack[top].node];
+
+        if (node->count)
+        {
+            for (int i = node->first; i < node->first + node->count; i++)
+            {
+                float t = test(user, this->indices[i], origin, direction, best);
+                if (t >= 0.0f && t < best)
+                {
+                    best = t;
+                    hit = this->indices[i];
+                }
+            }
+            continue;
+        }
+
+        // near child on top so it gets visited first
+        int a = node->first, b = node->first + 1;
+        float ta = _ray_box(origin, inverse_direction, best, this->nodes[a].min, this->nodes[a].max);
+        float tb = _ray_box(origin, inverse_direction, best, this->nodes[b].min, this->nodes[b].max);
+        if (ta > tb)
+        {
+            int swap = a;
+            a = b;
+            b = swap;
+            float swap_t = ta;
+            ta = tb;
+            tb = swap_t;
+        }
+
+        if (tb != FLT_MAX) stack[top++] = (struct bvh_ray_entry_s) { b, tb };
+        if (ta != FLT_MAX) stack[top++] = (struct bvh_ray_entry_s) { a, ta };
+    }
+
+    if (distance) *distance = best;
+    return hit;
+}
+
+float bvh_ray_triangle(vec3_t origin, vec3_t direction, vec3_t a, vec3_t b, vec3_t c)
+{
+    vec3_t ab = HMM_SubtractVec3(b, a), ac = HMM_SubtractVec3(c, a);
+    vec3_t p = HMM_Cross(direction, ac);
+    float determinant = HMM_DotVec3(ab, p);
+    if (fabsf(determinant) < 1e-8f) return -1.0f; // parallel
+
+    float inverse = 1.0f / determinant;
+    vec3_t to_origin = HMM_SubtractVec3(origin, a);
+
+    float u = HMM_DotVec3(to_origin, p) * inverse;
+    if (u < 0.0f || u > 1.0f) return -1.0f;
+
+    vec3_t q = HMM_Cross(to_origin, ab);
+    float v = HMM_DotVec3(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f) return -1.0f;
+
+    return HMM_DotVec3(ac, q) * inverse;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "turan_choks.h"
+#include "upper_graphics.h"
+
+// BOUNDING VOLUME HIERARCHY
+// -------------------------
+// built over plain aabbs (triangles, submeshes, lights, whatever), the queries hand back item
+// indices. sah binned, subtrees above BVH_PARALLEL_THRESHOLD items get built as jobs (jobs.h).
+//
+// nodes are one flat array, children of a node are always next to each other and always after
+// their parent, so refit is a single backwards sweep.
+#define BVH_BINS 16
+#define BVH_MAX_LEAF 8
+#define BVH_PARALLEL_THRESHOLD 65536
+#define BVH_MAX_DEPTH 64
+
+typedef struct bvh_bounds_s
+{
+    vec3_t min, max;
+} bvh_bounds_t;
+
+typedef struct bvh_node_s
+{
+    vec3_t min;
+    int first; // leaf: into bvh_t.indices, inner: left child (right is first + 1)
+    vec3_t max;
+    int count; // 0 for inner nodes
+} bvh_node_t; // 32 bytes, two per cache line
+
+typedef struct bvh_s
+{
+    bvh_node_t* nodes;
+    int node_count;
+
+    int* indices; // item order, leaves point into this
+    bvh_bounds_t* bounds; // per item
+    int count;
+} bvh_t;
+
+// returns the distance along the ray if item hits, < 0 if not. max_distance is the closest hit so far
+typedef float (*bvh_ray_test_f)(void* user, int item, vec3_t origin, vec3_t direction, float max_distance);
+
+extern void bvh_build(bvh_t* this, const bvh_bounds_t* bounds, int count); // bounds are copied
+extern void bvh_refit(bvh_t* this, const bvh_bounds_t* bounds); // same items, new bounds. no rebalancing
+extern void bvh_free(bvh_t* this);
+
+// fill out with up to max_out item indices, return how many there were in total
+extern int bvh_query_frustum(const bvh_t* this, const frustum_t* frustum, int* out, int max_out);
+extern int bvh_query_aabb(const bvh_t* this, vec3_t min, vec3_t max, int* out, int max_out);
+extern int bvh_query_sphere(const bvh_t* this, vec3_t center, float radius, int* out, int max_out);
+
+// closest hit according to test, returns the item or -1. distance gets the hit distance
+extern int bvh_raycast(const bvh_t* this, vec3_t origin, vec3_t direction, float max_distance, bvh_ray_test_f test, void* user, float* distance);
+
+extern float bvh_ray_triangle(vec3_t origin, vec3_t direction, vec3_t a, vec3_t b, vec3_t c); // moller-trumbore, < 0 on miss
@@ -0,0 +1,125 @@
+#pragma once
+
+// COOKED MAPS (.cmap)
+// -------------------
+// written by tooling/mapc.c from the content/map text format, loaded by world_load_map.
+// layout: cmap_header_t, then the blobs at the offsets in the header. no parsing at runtime,
+// vertices/indices go to gl straight out of the file.
+//
+// geometry is grouped per material: each material owns a contiguous run of vertices and
+// indices (relative to its first vertex), and a run of meshes (one per plane) with bounds.
+// vertices are packed per material in the tightest layout mapc could find (see vertex.h),
+// indices are 16 bit whenever the material has few enough vertices. both are already
+// optimized for the vertex cache and fetch (see meshopt.h).
+//
+// after its full detail indices, every material has up to CMAP_LODS simplified levels of the
+// whole material (lod_index_count indices in total), on the same vertices.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "vertex.h"
+
+#define CMAP_MAGIC 0x50414d43 // "CMAP"
+#define CMAP_VERSION 4
+#define CMAP_PATH_SIZE 64
+#define CMAP_LODS 3
+
+typedef struct
+{
+    uint32_t first_index, index_count; // within the material, so first_index >= its index_count
+    float error; // world space distance from full detail
+} cmap_lod_t;
+
+typedef struct
+{
+    char texture[CMAP_PATH_SIZE]; // relative to the content directory, "" for none
+
+    vertex_layout_t layout;
+    vertex_decode_t decode;
+    uint32_t vertex_offset; // bytes into the vertex blob
+
+    uint32_t index_offset; // bytes into the index blob
+    uint32_t index_size; // 2 or 4
+
+    uint32_t first_vertex, vertex_count;
+    uint32_t first_index, index_count;
+    uint32_t first_mesh, mesh_count;
+
+    uint32_t lod_count, lod_index_count;
+    cmap_lod_t lods[CMAP_LODS];
+} cmap_material_t;
+
+typedef struct
+{
+    uint32_t first_index, index_count; // within the material
+    float min[3], max[3];
+} cmap_mesh_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t vertex_count, index_count, material_count, mesh_count;
+    uint32_t vertex_bytes, index_bytes;
+    uint32_t vertex_offset, index_offset, material_offset, mesh_offset; // from the start of the file
+
+    float min[3], max[3];
+} cmap_header_t;
+
+// checks every offset and count against the file size, NULL if anything is off.
+// world_load_map runs this on load, mapc on everything it writes
+static inline const cmap_header_t* cmap_validate(const unsigned char* data, size_t size)
+{
+    const cmap_header_t* header = (const cmap_header_t*) data;
+    if (size < sizeof(*header) || header->magic != CMAP_MAGIC || header->version != CMAP_VERSION) return NULL;
+
+    if ((size_t) header->material_offset + sizeof(cmap_material_t) * header->material_count > size) return NULL;
+    if ((size_t) header->mesh_offset + sizeof(cmap_mesh_t) * header->mesh_count > size) return NULL;
+    if ((size_t) header->vertex_offset + header->vertex_bytes > size) return NULL;
+    if ((size_t) header->index_offset + header->index_bytes > size) return NULL;
+
+    const cmap_material_t* materials = (const cmap_material_t*) (data + header->material_offset);
+    for (uint32_t i = 0; i < header->material_count; i++)
+    {
+        const cmap_material_t* material = &materials[i];
+        if ((uint64_t) material->first_vertex + material->vertex_count > header->vertex_count) return NULL;
+        if ((uint64_t) material->vertex_offset + (uint64_t) vertex_layout_stride(material->layout) * material->vertex_count > header->vertex_bytes) return NULL;
+        for (int a = 0; a < VERTEX_ATTRIBUTES; a++) if (material->layout.formats[a] > VERTEX_FORMAT_UNORM8) return NULL;
+        if (material->index_count + material->lod_index_count && material->index_size != 2 && material->index_size != 4) return NULL; // empty materials are skipped at load
+        if ((uint64_t) material->index_offset + (uint64_t) material->index_size * ((uint64_t) material->index_count + material->lod_index_count) > header->index_bytes) return NULL;
+        if (material->lod_count > CMAP_LODS) return NULL;
+        for (uint32_t l = 0; l < material->lod_count; l++)
+        {
+            const cmap_lod_t* lod = &material->lods[l];
+            if (lod->first_index < material->index_count || (uint64_t) lod->first_index + lod->index_count > (uint64_t) material->index_count + material->lod_index_count) return NULL;
+        }
+        if ((uint64_t) material->first_mesh + material->mesh_count > header->mesh_count) return NULL;
+        if (memchr(material->texture, '\0', CMAP_PATH_SIZE) == NULL) return NULL;
+    }
+
+    return header;
+}
+
+// STREAMED WORLDS (.cworld)
+// -------------------------
+// index of a map split into chunk_size x chunk_size cells on xz, one .cmap per cell.
+// layout: cmap_world_t, then chunk_count cmap_chunk_t.
+#define CMAP_WORLD_MAGIC 0x444c5743 // "CWLD"
+
+typedef struct
+{
+    int32_t x, z; // cell
+    float min[3], max[3];
+    char path[CMAP_PATH_SIZE]; // relative to the .cworld
+} cmap_chunk_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    float chunk_size;
+    uint32_t chunk_count;
+} cmap_world_t;
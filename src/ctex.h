@@ -0,0 +1,50 @@
+#pragma once
+
+// COOKED TEXTURES (.ctex)
+// -----------------------
+// gpu ready texture container written by tooling/texcook.c, webp stays the authoring format.
+// layout: ctex_header_t, then faces * levels ctex_level_t (level major: level 0 face 0..5, level 1 ...),
+// then the pixel data. every level starts on a CTEX_ALIGN boundary so it can be uploaded straight
+// out of an mmapped file. 2d textures are stored bottom up (like the flipped webp decode),
+// cubemap faces top down in +x -x +y -y +z -z order.
+
+#include <stdint.h>
+
+#define CTEX_MAGIC 0x58455443 // "CTEX"
+#define CTEX_VERSION 1
+#define CTEX_ALIGN 16
+#define CTEX_MAX_LEVELS 16
+
+typedef enum
+{
+    CTEX_FORMAT_RGBA8,
+} ctex_format_t;
+
+typedef enum
+{
+    CTEX_TYPE_2D,
+    CTEX_TYPE_CUBEMAP,
+} ctex_type_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t type; // ctex_type_t
+    uint32_t format; // ctex_format_t
+    uint32_t width, height; // of level 0
+    uint32_t faces; // 1 or 6
+    uint32_t levels; // full chain down to 1x1
+} ctex_header_t;
+
+typedef struct
+{
+    uint32_t offset; // from the start of the file
+    uint32_t size;
+} ctex_level_t;
+
+static inline uint32_t ctex_level_dimension(uint32_t size, uint32_t level)
+{
+    size >>= level;
+    return size ? size : 1;
+}
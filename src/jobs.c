@@ -0,0 +1,379 @@
+#include "jobs.h"
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define JOBS_DEQUE_MASK (JOBS_DEQUE_SIZE - 1)
+
+typedef struct job_s
+{
+    job_function_t function;
+    void* data;
+    int first, count;
+    job_counter_t* counter;
+    const job_counter_t* after;
+} job_t;
+
+// chase-lev: the owner pushes and takes at bottom, thieves take from top. slots are read
+// field by field with relaxed atomics since a thief can read one thats being reused, it
+// throws the copy away when its cas on top fails.
+typedef struct job_deque_s
+{
+    int top, bottom;
+    job_t slots[JOBS_DEQUE_SIZE];
+} __attribute__((aligned(64))) job_deque_t;
+
+static struct
+{
+    int running;
+    int worker_count;
+    pthread_t threads[JOBS_MAX_WORKERS];
+
+    job_deque_t deques[JOBS_MAX_WORKERS + 1]; // 0 is the main thread
+
+    // long running stuff (decodes) goes in here instead, only idle workers pick it up so it
+    // never ends up on a thread thats waiting for frame work
+    struct jobs_background_s
+    {
+        job_t items[JOBS_DEQUE_SIZE];
+        int head, count; // under mutex
+    } background;
+
+    int queued; // jobs sitting in any deque or the background queue, idle workers sleep while its 0
+    int sleeping;
+    int quit;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+
+    int executed, stolen;
+} jobs;
+
+static __thread int _jobs_self = -1; // deque index, -1 outside the pool
+static __thread unsigned int _jobs_seed;
+
+// DEQUES
+// ------
+static void _job_store(job_t* slot, const job_t* job)
+{
+    __atomic_store_n(&slot->function, job->function, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->data, job->data, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->first, job->first, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->count, job->count, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->counter, job->counter, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->after, job->after, __ATOMIC_RELAXED);
+}
+
+static void _job_load(job_t* slot, job_t* job)
+{
+    job->function = __atomic_load_n(&slot->function, __ATOMIC_RELAXED);
+    job->data = __atomic_load_n(&slot->data, __ATOMIC_RELAXED);
+    job->first = __atomic_load_n(&slot->first, __ATOMIC_RELAXED);
+    job->count = __atomic_load_n(&slot->count, __ATOMIC_RELAXED);
+    job->counter = __atomic_load_n(&slot->counter, __ATOMIC_RELAXED);
+    job->after = __atomic_load_n(&slot->after, __ATOMIC_RELAXED);
+}
+
+static int _deque_push(job_deque_t* deque, const job_t* job)
+{
+    int bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    int top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (bottom - top >= JOBS_DEQUE_SIZE) return 0;
+
+    _job_store(&deque->slots[bottom & JOBS_DEQUE_MASK], job);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+static int _deque_take(job_deque_t* deque, job_t* job)
+{
+    int bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_SEQ_CST);
+    int top = __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST);
+
+    if (top > bottom)
+    {
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED); // empty
+        return 0;
+    }
+
+    _job_load(&deque->slots[bottom & JOBS_DEQUE_MASK], job);
+    if (top < bottom) return 1;
+
+    // last one, race the thieves for it
+    int won = __atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    return won;
+}
+
+static int _deque_steal(job_deque_t* deque, job_t* job)
+{
+    int top = __atomic_load_n(&deque->top, __ATOMIC_SEQ_CST);
+    int bottom = __atomic_load_n(&deque->bottom, __ATOMIC_SEQ_CST);
+    if (top >= bottom) return 0;
+
+    _job_load(&deque->slots[top & JOBS_DEQUE_MASK], job);
+    return __atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+// SCHEDULING
+// ----------
+// queued already counts the new jobs
+static void _jobs_wake(int count)
+{
+    if (!__atomic_load_n(&jobs.sleeping, __ATOMIC_SEQ_CST)) return;
+
+    pthread_mutex_lock(&jobs.mutex);
+    if (count > 1) pthread_cond_broadcast(&jobs.wake);
+    else pthread_cond_signal(&jobs.wake);
+    pthread_mutex_unlock(&jobs.mutex);
+}
+
+static int _jobs_find(job_t* job, int background)
+{
+    int self = _jobs_self;
+    int found = _deque_take(&jobs.deques[self], job);
+
+    // then everyone else, starting somewhere random so thieves spread out
+    int thread_count = __atomic_load_n(&jobs.worker_count, __ATOMIC_ACQUIRE) + 1;
+    if (!found && thread_count > 1)
+    {
+        _jobs_seed = _jobs_seed * 1664525u + 1013904223u;
+        int start = (_jobs_seed >> 16) % thread_count;
+        for (int i = 0; i < thread_count && !found; i++)
+        {
+            int victim = (start + i) % thread_count;
+            if (victim != self && _deque_steal(&jobs.deques[victim], job))
+            {
+                found = 1;
+                __atomic_add_fetch(&jobs.stolen, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    if (!found && background)
+    {
+        pthread_mutex_lock(&jobs.mutex);
+        if (jobs.background.count)
+        {
+            *job = jobs.background.items[jobs.background.head];
+            jobs.background.head = (jobs.background.head + 1) & JOBS_DEQUE_MASK;
+            jobs.background.count--;
+            found = 1;
+        }
+        pthread_mutex_unlock(&jobs.mutex);
+    }
+
+    if (found) __atomic_sub_fetch(&jobs.queued, 1, __ATOMIC_SEQ_CST);
+    return found;
+}
+
+static void _job_run(const job_t* job)
+{
+    if (job->after) job_wait((job_counter_t*) job->after);
+
+    job->function(job->data, job->first, job->count);
+    __atomic_add_fetch(&jobs.executed, 1, __ATOMIC_RELAXED);
+
+    if (job->counter) __atomic_sub_fetch(&job->counter->remaining, 1, __ATOMIC_RELEASE);
+}
+
+// pushes onto this threads deque, or runs it right away when theres nowhere to put it.
+// queued goes up first so it never dips below 0 when a thief is quick
+static int _job_push(const job_t* job)
+{
+    if (_jobs_self >= 0)
+    {
+        __atomic_add_fetch(&jobs.queued, 1, __ATOMIC_SEQ_CST);
+        if (_deque_push(&jobs.deques[_jobs_self], job)) return 1;
+        __atomic_sub_fetch(&jobs.queued, 1, __ATOMIC_SEQ_CST);
+    }
+
+    _job_run(job);
+    return 0;
+}
+
+static void* _jobs_worker(void* arg)
+{
+    _jobs_self = (int) (intptr_t) arg;
+    _jobs_seed = (unsigned int) _jobs_self * 2654435761u;
+
+    int idle = 0;
+    while (1)
+    {
+        job_t job;
+        if (_jobs_find(&job, 1))
+        {
+            _job_run(&job);
+            idle = 0;
+            continue;
+        }
+
+        if (__atomic_load_n(&jobs.quit, __ATOMIC_ACQUIRE) && !__atomic_load_n(&jobs.queued, __ATOMIC_SEQ_CST)) break;
+
+        if (++idle < JOBS_SPIN)
+        {
+            sched_yield();
+            continue;
+        }
+
+        // sleeping goes up before queued is checked and pushers do the opposite, so one of us sees the other
+        pthread_mutex_lock(&jobs.mutex);
+        __atomic_add_fetch(&jobs.sleeping, 1, __ATOMIC_SEQ_CST);
+        while (!__atomic_load_n(&jobs.queued, __ATOMIC_SEQ_CST) && !jobs.quit) pthread_cond_wait(&jobs.wake, &jobs.mutex);
+        __atomic_sub_fetch(&jobs.sleeping, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&jobs.mutex);
+        idle = 0;
+    }
+
+    return NULL;
+}
+
+// API
+// ---
+void jobs_setup()
+{
+    if (jobs.running) return;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int worker_count = cores > 1 ? (int) cores - 1 : 0;
+    if (worker_count > JOBS_MAX_WORKERS) worker_count = JOBS_MAX_WORKERS;
+
+    pthread_mutex_init(&jobs.mutex, NULL);
+    pthread_cond_init(&jobs.wake, NULL);
+    jobs.queued = jobs.sleeping = jobs.quit = 0;
+    jobs.background.head = jobs.background.count = 0;
+    jobs.executed = jobs.stolen = 0;
+
+    // the caller is the main thread from now on
+    _jobs_self = 0;
+    _jobs_seed = 1;
+    jobs.running = 1;
+
+    // the ones already running steal from the count so far
+    jobs.worker_count = 0;
+    for (int i = 0; i < worker_count; i++)
+    {
+        if (pthread_create(&jobs.threads[i], NULL, _jobs_worker, (void*) (intptr_t) (i + 1))) break;
+        __atomic_store_n(&jobs.worker_count, i + 1, __ATOMIC_RELEASE);
+    }
+}
+
+void jobs_cleanup()
+{
+    if (!jobs.running) return;
+
+    // whatever is still on our deque runs here, the workers drain the rest
+    job_t job;
+    while (__atomic_load_n(&jobs.queued, __ATOMIC_SEQ_CST))
+    {
+        if (_jobs_find(&job, !jobs.worker_count)) _job_run(&job);
+        else sched_yield();
+    }
+
+    pthread_mutex_lock(&jobs.mutex);
+    __atomic_store_n(&jobs.quit, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&jobs.wake);
+    pthread_mutex_unlock(&jobs.mutex);
+
+    for (int i = 0; i < jobs.worker_count; i++)
+    {
+        pthread_join(jobs.threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&jobs.mutex);
+    pthread_cond_destroy(&jobs.wake);
+
+    jobs.running = 0;
+    jobs.worker_count = 0;
+    _jobs_self = -1;
+}
+
+void job_submit(job_function_t function, void* data, job_counter_t* counter)
+{
+    job_submit_after(NULL, function, data, counter);
+}
+
+void job_submit_after(const job_counter_t* dependency, job_function_t function, void* data, job_counter_t* counter)
+{
+    job_t job = { function, data, 0, 1, counter, dependency };
+    if (counter) __atomic_add_fetch(&counter->remaining, 1, __ATOMIC_RELAXED);
+
+    if (_job_push(&job)) _jobs_wake(1);
+}
+
+void job_submit_background(job_function_t function, void* data, job_counter_t* counter)
+{
+    job_t job = { function, data, 0, 1, counter, NULL };
+    if (counter) __atomic_add_fetch(&counter->remaining, 1, __ATOMIC_RELAXED);
+
+    int queued = 0;
+    if (jobs.running && jobs.worker_count)
+    {
+        pthread_mutex_lock(&jobs.mutex);
+        if (jobs.background.count < JOBS_DEQUE_SIZE)
+        {
+            jobs.background.items[(jobs.background.head + jobs.background.count) & JOBS_DEQUE_MASK] = job;
+            jobs.background.count++;
+            __atomic_add_fetch(&jobs.queued, 1, __ATOMIC_SEQ_CST);
+            queued = 1;
+        }
+        pthread_mutex_unlock(&jobs.mutex);
+    }
+
+    if (queued) _jobs_wake(1);
+    else _job_run(&job);
+}
+
+void job_parallel_for(job_function_t function, void* data, int count, int min_chunk, job_counter_t* counter)
+{
+    if (count <= 0) return;
+    if (min_chunk < 1) min_chunk = 1;
+
+    int chunks = jobs_thread_count() * JOBS_CHUNKS_PER_THREAD;
+    int chunk = (count + chunks - 1) / chunks;
+    if (chunk < min_chunk) chunk = min_chunk;
+    chunks = (count + chunk - 1) / chunk;
+
+    if (counter) __atomic_add_fetch(&counter->remaining, chunks, __ATOMIC_RELAXED);
+
+    int pushed = 0;
+    for (int first = 0; first < count; first += chunk)
+    {
+        job_t job = { function, data, first, count - first < chunk ? count - first : chunk, counter, NULL };
+        pushed += _job_push(&job);
+    }
+
+    if (pushed) _jobs_wake(pushed);
+}
+
+void job_wait(job_counter_t* counter)
+{
+    while (__atomic_load_n(&counter->remaining, __ATOMIC_ACQUIRE) > 0)
+    {
+        // lend a hand instead of blocking
+        job_t job;
+        if (_jobs_self >= 0 && _jobs_find(&job, 0)) _job_run(&job);
+        else sched_yield();
+    }
+}
+
+int job_done(const job_counter_t* counter)
+{
+    return __atomic_load_n(&counter->remaining, __ATOMIC_ACQUIRE) <= 0;
+}
+
+int jobs_thread_count()
+{
+    return jobs.running ? jobs.worker_count + 1 : 1;
+}
+
+jobs_stats_t jobs_stats()
+{
+    jobs_stats_t stats;
+    stats.workers = jobs.worker_count;
+    stats.executed = __atomic_exchange_n(&jobs.executed, 0, __ATOMIC_RELAXED);
+    stats.stolen = __atomic_exchange_n(&jobs.stolen, 0, __ATOMIC_RELAXED);
+    return stats;
+}
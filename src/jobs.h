@@ -0,0 +1,47 @@
+#pragma once
+
+// JOB SYSTEM
+// ----------
+// one worker per core (minus the main thread) started once, each with its own deque. a thread
+// pushes and pops its own jobs at the bottom, idle workers steal from the top of everyone
+// else's. the main thread is thread 0: it owns a deque too and runs jobs while it waits.
+//
+// counters are the only sync: submitting bumps one, finishing a job drops it, job_wait runs
+// other jobs until it hits 0. a job can wait on a counter itself (or be submitted after one),
+// thats how dependencies work. threads outside the pool (io threads etc.) run what they
+// submit right away, but can still wait.
+//
+// anything slow that nobody waits on this frame (texture decodes) should go through
+// job_submit_background so the main thread never picks it up while helping. blocking io
+// doesnt belong in here at all, it holds a worker hostage for the whole read.
+#define JOBS_MAX_WORKERS 31
+#define JOBS_DEQUE_SIZE 1024 // per thread, power of 2. a push into a full deque runs the job inline
+#define JOBS_CHUNKS_PER_THREAD 4 // job_parallel_for aims for this many chunks per thread, so stealing can even out uneven chunks
+#define JOBS_SPIN 64 // empty rounds before an idle worker goes to sleep
+
+typedef void (*job_function_t)(void* data, int first, int count); // plain jobs get 0, 1
+
+typedef struct job_counter_s
+{
+    int remaining; // atomic, 0 when everything submitted against it is done
+} job_counter_t;
+
+typedef struct jobs_stats_s
+{
+    int workers;
+    int executed, stolen; // since the last call
+} jobs_stats_t;
+
+extern void jobs_setup(); // setup_choks does this. without it everything runs inline
+extern void jobs_cleanup(); // finishes whats queued first
+
+extern void job_submit(job_function_t function, void* data, job_counter_t* counter); // counter can be NULL
+extern void job_submit_after(const job_counter_t* dependency, job_function_t function, void* data, job_counter_t* counter); // starts once dependency is done
+extern void job_submit_background(job_function_t function, void* data, job_counter_t* counter); // any thread. fifo, only idle workers run these (inline if there are none)
+extern void job_parallel_for(job_function_t function, void* data, int count, int min_chunk, job_counter_t* counter); // function(data, first, count) over [0, count), chunks of at least min_chunk
+
+extern void job_wait(job_counter_t* counter); // helps out until its done
+extern int job_done(const job_counter_t* counter);
+
+extern int jobs_thread_count(); // workers + the main thread
+extern jobs_stats_t jobs_stats();
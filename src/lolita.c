@@ -0,0 +1,140 @@
+#include "lolita.h"
+
+#include <glad/gl.h>
+#include <string.h>
+#include <math.h>
+
+#include "upper_graphics.h"
+
+// software cluster handling
+extern void software_generate_cluster_grid(camera_t* camera);
+extern void software_populate_cluster_grid(camera_t* camera, light_t* lights, int light_count);
+extern void software_upload_cluster_grid(unsigned int clusters, unsigned int indices);
+extern void cleanup_software_clustering();
+
+static struct cluster_manager_s
+{
+    void (*generate_grid)(camera_t* camera);
+    void (*populate_grid)(camera_t* camera, light_t* lights, int light_count);
+    void (*upload)(unsigned int clusters, unsigned int indices);
+    void (*cleanup)();
+} clustermanager;
+
+// mirrors the lighting block in gfx/src/lighting.f.glsl (std140)
+typedef struct
+{
+    int grid[4]; // horizontal, vertical, depth slices, light count
+    vec4_t tile; // pixels per tile
+    vec4_t depth; // near, far, slice scale, slice bias
+    vec4_t ambient;
+} lighting_block_t;
+
+static struct
+{
+    // each is a buffer + the texture buffer viewing it
+    struct { unsigned int buffer, texture; } lights, clusters, indices;
+
+    vec4_t packed[KIM_MAX_LIGHTS * 2]; // position + radius, color + type
+    lighting_block_t block;
+
+    mat4_t projection; // the grid was built for this one
+    int grid_valid;
+} lolkim = { .block.ambient = { 0.2f, 0.2f, 0.2f, 1.0f } };
+
+static void _texture_buffer(unsigned int* buffer, unsigned int* texture, unsigned int format, size_t size)
+{
+    glGenBuffers(1, buffer);
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, *buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+    glGenTextures(1, texture);
+    choks_bind_texture(GL_TEXTURE_BUFFER, *texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, *buffer);
+}
+
+void setup_lolkim()
+{
+    // TODO: add hardware clustering support + detection of compute extensions
+    clustermanager.generate_grid = software_generate_cluster_grid;
+    clustermanager.populate_grid = software_populate_cluster_grid;
+    clustermanager.upload = software_upload_cluster_grid;
+    clustermanager.cleanup = cleanup_software_clustering;
+
+    // no ssbos below 4.3 and a ubo is too small for the index list, so texture buffers it is
+    _texture_buffer(&lolkim.lights.buffer, &lolkim.lights.texture, GL_RGBA32F, sizeof(lolkim.packed));
+    _texture_buffer(&lolkim.clusters.buffer, &lolkim.clusters.texture, GL_RG32I, sizeof(int) * 2 * KIM_CLUSTER_COUNT);
+    _texture_buffer(&lolkim.indices.buffer, &lolkim.indices.texture, GL_R32UI, sizeof(unsigned int) * KIM_CLUSTER_COUNT * KIM_MAX_LIGHTS_IN_CLUSTER);
+
+    lolkim.grid_valid = 0;
+}
+
+void cleanup_lolkim()
+{
+    clustermanager.cleanup();
+
+    choks_delete_texture(lolkim.lights.texture);
+    choks_delete_texture(lolkim.clusters.texture);
+    choks_delete_texture(lolkim.indices.texture);
+    choks_delete_buffer(lolkim.lights.buffer);
+    choks_delete_buffer(lolkim.clusters.buffer);
+    choks_delete_buffer(lolkim.indices.buffer);
+}
+
+void attach_lighting_data_to_program(program_t program)
+{
+    // the lighting block gets bound with the others when the program loads
+    choks_use_program(program.id);
+    glUniform1i(glGetUniformLocation(program.id, "lights"), KIM_UNIT_LIGHTS);
+    glUniform1i(glGetUniformLocation(program.id, "cluster_lights"), KIM_UNIT_CLUSTERS);
+    glUniform1i(glGetUniformLocation(program.id, "light_indices"), KIM_UNIT_INDICES);
+}
+
+void set_ambient_light(vec3_t color)
+{
+    lolkim.block.ambient = HMM_Vec4v(color, 1.0f);
+}
+
+void update_lighting_clusters(camera_t* camera, light_t* lights, int light_count)
+{
+    if (light_count > KIM_MAX_LIGHTS) light_count = KIM_MAX_LIGHTS;
+
+    // the grid is in viewspace, only the projection moves it
+    if (!lolkim.grid_valid || memcmp(&lolkim.projection, &camera->matrices.projection, sizeof(mat4_t)))
+    {
+        clustermanager.generate_grid(camera);
+        lolkim.projection = camera->matrices.projection;
+        lolkim.grid_valid = 1;
+
+        float log_ratio = logf(camera->far / camera->near);
+        lolkim.block.grid[0] = KIM_HORIZONTAL_SLICES;
+        lolkim.block.grid[1] = KIM_VERTICAL_SLICES;
+        lolkim.block.grid[2] = KIM_DEPTH_SLICES;
+        lolkim.block.tile = HMM_Vec4((float) CHOKS_WIDTH / KIM_HORIZONTAL_SLICES, (float) CHOKS_HEIGHT / KIM_VERTICAL_SLICES, 0.0f, 0.0f);
+        lolkim.block.depth = HMM_Vec4(camera->near, camera->far, KIM_DEPTH_SLICES / log_ratio, KIM_DEPTH_SLICES * logf(camera->near) / log_ratio);
+    }
+
+    clustermanager.populate_grid(camera, lights, light_count);
+    clustermanager.upload(lolkim.clusters.buffer, lolkim.indices.buffer);
+
+    for (int i = 0; i < light_count; i++)
+    {
+        lolkim.packed[i * 2] = HMM_Vec4v(lights[i].position.xyz, lights[i].strength);
+        lolkim.packed[i * 2 + 1] = HMM_Vec4v(lights[i].color, (float) lights[i].type);
+    }
+
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, lolkim.lights.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(lolkim.packed), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(vec4_t) * 2 * light_count, lolkim.packed);
+
+    lolkim.block.grid[3] = light_count;
+    stream_bind_uniform(&lolkim.block, sizeof(lolkim.block), CHOKS_BINDING_LIGHTING);
+
+    // stays bound for the frame, everything else draws on unit 0
+    choks_active_texture(GL_TEXTURE0 + KIM_UNIT_LIGHTS);
+    choks_bind_texture(GL_TEXTURE_BUFFER, lolkim.lights.texture);
+    choks_active_texture(GL_TEXTURE0 + KIM_UNIT_CLUSTERS);
+    choks_bind_texture(GL_TEXTURE_BUFFER, lolkim.clusters.texture);
+    choks_active_texture(GL_TEXTURE0 + KIM_UNIT_INDICES);
+    choks_bind_texture(GL_TEXTURE_BUFFER, lolkim.indices.texture);
+    choks_active_texture(GL_TEXTURE0);
+}
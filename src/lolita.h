@@ -0,0 +1,44 @@
+// holly kim (lolita) - clustered lighting
+#pragma once
+
+#include "turan_choks.h"
+#include "upper_graphics.h"
+
+// KIM CONFIGURATION
+#define KIM_LIGHTS_PER_CALL 4
+#define KIM_MAX_LIGHTS 1024 // per frame, the rest get dropped
+#define KIM_MAX_LIGHTS_IN_CLUSTER 50
+#define KIM_HORIZONTAL_SLICES 16
+#define KIM_VERTICAL_SLICES 10
+#define KIM_DEPTH_SLICES 24 // exponential between camera near and far
+#define KIM_CLUSTER_COUNT (KIM_HORIZONTAL_SLICES * KIM_VERTICAL_SLICES * KIM_DEPTH_SLICES)
+
+// lit shaders get the light data from here (see gfx/src/lighting.f.glsl): the lighting
+// uniform block at CHOKS_BINDING_LIGHTING, and three texture buffers on these units
+#define KIM_UNIT_LIGHTS 5
+#define KIM_UNIT_CLUSTERS 6
+#define KIM_UNIT_INDICES 7
+
+enum
+{
+    LIGHT_POINT,
+};
+
+// the type.
+typedef struct
+{
+    vec4_t position; // world space, w unused
+    vec3_t color;
+    int type;
+    float strength; // radius, falls off to nothing there
+} light_t; // point light only rn.
+
+extern void setup_lolkim();
+extern void cleanup_lolkim();
+
+extern void attach_lighting_data_to_program(program_t program); // once per lit program, after its loaded (program_batch_end)
+extern void set_ambient_light(vec3_t color);
+
+// rebuilds the grid when the projection changed, assigns lights to clusters and uploads all of it.
+// once per frame after camera_update_view, before drawing anything lit
+extern void update_lighting_clusters(camera_t* camera, light_t* lights, int light_count);
@@ -11,13 +11,26 @@
 #include <unistd.h> 
 #define CWD "./content"
 
+#define DEBRIS_COUNT 10000
+#define DEBRIS_SPREAD 200.0f
+
+#define LIGHT_COUNT 384
+#define LIGHT_SPREAD 60.0f
+
 #include "world.h"
+#include "rqueue.h"
+#include "lolita.h"
 
 float lerp(float a, float b, float f)
 {
     return a * (1.0 - f) + (b * f);
 }
 
+void draw_sky(void* cubemap)
+{
+    rskybox_render(*(texture_t*) cubemap);
+}
+
 float __planevertices[] = {
     -0.5f, 0.0f, -0.5f, 0.0f, 1.0f,
     -0.5f, 0.0f, 0.5f, 0.0f, 0.0f,
@@ -35,6 +48,8 @@ int main(int argc, char* argv[])
 {
     chdir(CWD);
 
+    uint64_t startup_start = SDL_GetPerformanceCounter();
+
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
     {
         printf("SDL initialization err.\n");
@@ -81,6 +96,10 @@ int main(int argc, char* argv[])
     printf("OPENGL %s | %s\n", glGetString(GL_VENDOR), glGetString(GL_RENDERER));
 
     setup_choks();
+    setup_lolkim();
+
+    // submit every startup program first so the driver can compile them while we decode textures
+    program_batch_begin();
 
     ren2d_init();
 
@@ -89,8 +108,22 @@ int main(int argc, char* argv[])
     };
     primitive_t plane = primitive_load_with_indices(__planevertices, 4, indices, 6, GL_TRIANGLES);
 
+    // debris field - every piece in one instanced draw
+    transform_t* debris = malloc(sizeof(transform_t) * DEBRIS_COUNT);
+    for (int i = 0; i < DEBRIS_COUNT; i++)
+    {
+        float scale = 0.2f + 0.4f * rand() / (float) RAND_MAX;
+        debris[i].position = HMM_Vec3((rand() / (float) RAND_MAX - 0.5f) * DEBRIS_SPREAD, -2.0f + rand() / (float) RAND_MAX, (rand() / (float) RAND_MAX - 0.5f) * DEBRIS_SPREAD);
+        debris[i].rotate = HMM_Vec3(rand() % 360, rand() % 360, rand() % 360);
+        debris[i].scale = HMM_Vec3(scale, scale, scale);
+    }
+    instance_buffer_t debris_instances = instance_buffer_from_transforms(debris, DEBRIS_COUNT);
+    free(debris);
+
     program_t program = program_load_from_files("gfx/src/basic.v.glsl", "gfx/src/basic.f.glsl");    
     program_t point_program = program_load_from_files("gfx/src/basic.v.glsl","gfx/src/points.f.glsl");
+    program_t water_program = program_load_from_files("gfx/src/water.v.glsl", "gfx/src/water.f.glsl");
+    program_t lit_program = program_load_from_files("gfx/src/lighting.v.glsl", "gfx/src/lighting.f.glsl");
 
     camera_t camera = { 0 };
     camera.transform.position = (vec3_t) { 0.0f, 0.0f, -10.0f };
@@ -106,19 +139,31 @@ int main(int argc, char* argv[])
     rskybox_setup();
     texture_t cubemap = texture_load_cubemap_from_file("media/skybox/water64.webp");
 
-    world_generate_test();
+    world_generate_test(lit_program);
 
-    texture_t scrolling = texture_load_2d_from_file("media/misc/noise.webp");
-    program_t water_program = program_load_from_files("gfx/src/water.v.glsl", "gfx/src/water.f.glsl");
+    texture_t* scrolling = texture_load_2d_async("media/misc/noise.webp"); // placeholder until its uploaded
+    texture_t* tiles = texture_load_2d_async("media/misc/tiles.webp");
+
+    // a few hundred point lights drifting around over the floor and the debris
+    light_t* lights = malloc(sizeof(light_t) * LIGHT_COUNT);
+    vec3_t* light_origins = malloc(sizeof(vec3_t) * LIGHT_COUNT);
+    for (int i = 0; i < LIGHT_COUNT; i++)
+    {
+        light_origins[i] = HMM_Vec3((rand() / (float) RAND_MAX - 0.5f) * LIGHT_SPREAD, 0.5f + rand() / (float) RAND_MAX, (rand() / (float) RAND_MAX - 0.5f) * LIGHT_SPREAD);
+        lights[i].type = LIGHT_POINT;
+        lights[i].strength = 4.0f + 6.0f * rand() / (float) RAND_MAX;
+        lights[i].color = HMM_MultiplyVec3f(HMM_Vec3(rand() / (float) RAND_MAX, rand() / (float) RAND_MAX, rand() / (float) RAND_MAX), 6.0f);
+    }
+    float light_time = 0.0f;
 
     // gl configuration
     glPointSize(50.0f);
-    glViewport(0, 0, CHOKS_WIDTH, CHOKS_HEIGHT);
-    glActiveTexture(GL_TEXTURE0);
-    glEnable(GL_DEPTH_TEST);
+    choks_viewport(0, 0, CHOKS_WIDTH, CHOKS_HEIGHT);
+    choks_active_texture(GL_TEXTURE0);
+    choks_enable(GL_DEPTH_TEST, 1);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
+    choks_enable(GL_BLEND, 1);
+    choks_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  
 
     float delta = 0.0f;
 
@@ -135,6 +180,9 @@ int main(int argc, char* argv[])
     spritefont_t font_fixedsys = spritefont_load_from_img("media/font/fixedsys.webp");
     char* fpsmsg = malloc(64);
 
+    // programs have to be done before we touch their uniforms
+    program_batch_end();
+    attach_lighting_data_to_program(lit_program);
 
     int time_loc = glGetUniformLocation(water_program.id, "time");
 
@@ -147,6 +195,10 @@ int main(int argc, char* argv[])
 
     float avg_delta = 1.0f;
 
+    // cold (empty program cache) vs warm startup
+    printf("startup took %f ms\n", (float)(SDL_GetPerformanceCounter() - startup_start) * 1000.0f / (float)SDL_GetPerformanceFrequency());
+    program_cache_report();
+
     int running = 1;
     while (running)
     {
@@ -158,12 +210,6 @@ int main(int argc, char* argv[])
 
         // printf("\b\b\b\b\b\b\b\b\b\b%10f", delta * 1000.0f);
 
-        // test the cluster grid generation speed
-        // perftest(&camera);
-        // HOLY SHIT SIMD N MULTITHREAD IS SO FACKING FAST frametime avg = 1.25 ms
-        // without running this func every frame the time is 0.81 ms/frame
-        // worst-case predicted performance hit of 0.39 ms
-
         SDL_Event ev;
         while (SDL_PollEvent(&ev))
         {
@@ -183,6 +229,13 @@ int main(int argc, char* argv[])
                             desired_fov = 60.0f;
                             mousesens = 5.0f;
                             break;
+                        case SDL_SCANCODE_E:
+                        {
+                            float distance;
+                            if (world_raycast(camera.transform.position, camera.front, camera.far, &distance)) printf("looking at world geometry %f units away\n", distance);
+                            else printf("looking at nothing\n");
+                            break;
+                        }
                         default: break;
                     }
                     break;
@@ -256,6 +309,14 @@ int main(int argc, char* argv[])
         camera_update_view(&camera);
         set_view_and_projection_matrices(camera.matrices.view, camera.matrices.projection); // FIXME: should just add another function
                                                                                             // so i can set each matrix separately
+
+        light_time += delta;
+        for (int i = 0; i < LIGHT_COUNT; i++)
+        {
+            float phase = light_time * (0.5f + (i % 7) * 0.1f) + i;
+            lights[i].position = HMM_Vec4v(HMM_AddVec3(light_origins[i], HMM_Vec3(HMM_CosF(phase) * 3.0f, HMM_SinF(phase * 2.0f) * 0.5f, HMM_SinF(phase) * 3.0f)), 1.0f);
+        }
+        update_lighting_clusters(&camera, lights, LIGHT_COUNT);
         
         // FIXME: this logic is flawed b/c the movement data doesnt happen until the next frame. however, this stuff in a real game would ideally
         // happen AFTER all the parent character's movement had been calculate so i dont really have to worry too much about it
@@ -265,34 +326,94 @@ int main(int argc, char* argv[])
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glUseProgram(program.id);
-        plane.draw_mode = GL_TRIANGLES;
-        primitive_draw(&plane);
+        vec3_t bounds_min, bounds_max;
+        rqueue_item_t item = { 0 };
+
+        bounds_transform(plane.min, plane.max, obj_trans, &bounds_min, &bounds_max);
+        if (frustum_test_box(&camera.frustum, bounds_min, bounds_max))
+        {
+            item.primitive = plane;
+            item.program = program.id;
+            item.transform = obj_trans;
+            rqueue_submit(&item);
+        }
+
+        mat4_t plane_matrix = transform_to_matrix(&trans_plane);
+        bounds_transform(plane.min, plane.max, plane_matrix, &bounds_min, &bounds_max);
 
-        set_model_matrix(transform_to_matrix(&trans_plane));
-        glUseProgram(point_program.id);
-        plane.draw_mode = GL_POINTS;
-        primitive_draw(&plane);
+        if (frustum_test_box(&camera.frustum, bounds_min, bounds_max))
+        {
+            item.primitive = plane;
+            item.primitive.draw_mode = GL_POINTS;
+            item.program = point_program.id;
+            item.transform = plane_matrix;
+            rqueue_submit(&item);
+
+            // the queue puts transparents last, back to front
+            item.primitive.draw_mode = GL_TRIANGLES;
+            item.program = water_program.id;
+            item.texture = scrolling->id;
+            item.transparent = 1;
+            item.depth = HMM_LengthVec3(HMM_SubtractVec3(HMM_MultiplyVec3f(HMM_AddVec3(bounds_min, bounds_max), 0.5f), camera.transform.position));
+            rqueue_submit(&item);
+        }
+
+        // whole field as one box, the pieces are too small to be worth culling one by one
+        bounds_min = HMM_Vec3(-DEBRIS_SPREAD / 2 - 1.0f, -3.0f, -DEBRIS_SPREAD / 2 - 1.0f);
+        bounds_max = HMM_Vec3(DEBRIS_SPREAD / 2 + 1.0f, 0.0f, DEBRIS_SPREAD / 2 + 1.0f);
+        if (frustum_test_box(&camera.frustum, bounds_min, bounds_max))
+        {
+            item = (rqueue_item_t) { 0 };
+            item.primitive = plane;
+            item.program = lit_program.id;
+            item.texture = tiles->id;
+            item.transform = HMM_Mat4d(1.0f);
+            item.instances = debris_instances;
+            rqueue_submit(&item);
+        }
 
-        set_model_matrix(HMM_Mat4d(1.0f));
+        world_stream_update(camera.transform.position);
+        world_cull(&camera.frustum);
+        world_update_lods(&camera, CHOKS_HEIGHT, delta);
         world_draw();
 
-        rskybox_render(cubemap);
-        
-        // transparent objects have to be rendered last. UGH
-        set_model_matrix(transform_to_matrix(&trans_plane));
-        plane.draw_mode = GL_TRIANGLES;
-        glUseProgram(water_program.id);
+        rqueue_submit_callback(RQUEUE_LAYER_SKY, draw_sky, &cubemap);
+
+        choks_use_program(water_program.id);
         glUniform1f(time_loc, (float) ((float)SDL_GetTicks() / 1000.0f));
-        glBindTexture(GL_TEXTURE_2D, scrolling.id);
-        primitive_draw(&plane);
+        rqueue_flush();
 
         glClear(GL_DEPTH_BUFFER_BIT);
 
         sprintf(fpsmsg, "delta: %f ms", delta * 1000);
         draw_text_spritefont(&font_fixedsys, 0.5f, (vec3_t) { 1.0f, 0.5f, 1.0f }, fpsmsg, (vec2_t) { 10.0f, 10.0f });
 
+        world_stream_stats_t stream = world_stream_stats();
+        if (stream.chunks)
+        {
+            char streammsg[128];
+            snprintf(streammsg, sizeof(streammsg), "chunks: %i/%i resident, %i pending, %zu kb streamed", stream.resident, stream.chunks, stream.pending, stream.bytes_streamed / 1024);
+            draw_text_spritefont(&font_fixedsys, 0.5f, (vec3_t) { 1.0f, 0.5f, 1.0f }, streammsg, (vec2_t) { 10.0f, 30.0f });
+        }
+
+        rqueue_stats_t queue = rqueue_stats();
+        char queuemsg[128];
+        snprintf(queuemsg, sizeof(queuemsg), "draws: %i (%i instances), state changes: %i (%i unsorted), %.2f ms", queue.draws, queue.instances, queue.state_changes, queue.unsorted_state_changes, queue.flush_ms);
+        draw_text_spritefont(&font_fixedsys, 0.5f, (vec3_t) { 1.0f, 0.5f, 1.0f }, queuemsg, (vec2_t) { 10.0f, 50.0f });
+
+        choks_state_stats_t state = choks_state_stats();
+        char statemsg[128];
+        snprintf(statemsg, sizeof(statemsg), "gl state calls: %i issued, %i elided", state.issued, state.elided);
+        draw_text_spritefont(&font_fixedsys, 0.5f, (vec3_t) { 1.0f, 0.5f, 1.0f }, statemsg, (vec2_t) { 10.0f, 70.0f });
+
+        geometry_arena_stats_t arena = geometry_arena_stats();
+        char arenamsg[128];
+        snprintf(arenamsg, sizeof(arenamsg), "geometry: %i meshes in %i blocks, %i/%i k vertices, %i free ranges", arena.allocations, arena.blocks, arena.vertices_used / 1024, arena.vertices_capacity / 1024, arena.free_ranges);
+        draw_text_spritefont(&font_fixedsys, 0.5f, (vec3_t) { 1.0f, 0.5f, 1.0f }, arenamsg, (vec2_t) { 10.0f, 90.0f });
+        ren2d_flush();
+
         SDL_GL_SwapWindow(window);
+        choks_end_frame();
     }
 
     printf("\n\nshutting down. avg slimetime %fms\n", avg_delta * 1000);
@@ -302,19 +423,27 @@ int main(int argc, char* argv[])
     spritefont_free(&font_fixedsys);
 
     program_free(water_program);
-    texture_free(scrolling);
+    texture_async_free(scrolling);
+    texture_async_free(tiles);
+
+    program_free(lit_program);
+    free(lights);
+    free(light_origins);
 
     rskybox_cleanup();
     texture_free(cubemap);
 
     program_free(point_program);
     program_free(program);
+    instance_buffer_free(&debris_instances);
     primitive_free(&plane);
 
     ren2d_cleanup();
+    world_cleanup();
+    rqueue_cleanup();
 
+    cleanup_lolkim();
     cleanup_choks();
-    // cleanup_lolkim();
 
     printf("cleaned up gpu resources.\n");
 
@@ -0,0 +1,826 @@
+#include "meshopt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+
+// STATS
+// -----
+meshopt_stats_t meshopt_analyze(const unsigned int* indices, int index_count, int vertex_count)
+{
+    meshopt_stats_t stats = { 0 };
+    if (index_count < 3 || !vertex_count) return stats;
+
+    // fifo: a hit doesnt move anything, a miss pushes out the oldest
+    unsigned int* timestamps = calloc(vertex_count, sizeof(unsigned int));
+    unsigned int time = MESHOPT_FIFO_SIZE + 1;
+    int misses = 0;
+
+    for (int i = 0; i < index_count; i++)
+    {
+        unsigned int vertex = indices[i];
+        if (time - timestamps[vertex] > MESHOPT_FIFO_SIZE)
+        {
+            timestamps[vertex] = time++;
+            misses++;
+        }
+    }
+
+    free(timestamps);
+
+    stats.acmr = (float) misses / (index_count / 3);
+    stats.atvr = (float) misses / vertex_count;
+    return stats;
+}
+
+// WELDING
+// -------
+static uint32_t _hash_vertex(const vertex_t* vertex)
+{
+    const unsigned char* bytes = (const unsigned char*) vertex;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(vertex_t); i++) hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+int meshopt_weld(vertex_t* vertices, int vertex_count, unsigned int* indices, int index_count)
+{
+    int table_size = 1;
+    while (table_size < vertex_count * 2) table_size *= 2;
+
+    int* table = malloc(sizeof(int) * table_size);
+    memset(table, 0xff, sizeof(int) * table_size);
+    unsigned int* remap = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+
+    // open addressing, the first copy of every vertex wins and gets compacted down
+    int unique = 0;
+    for (int i = 0; i < vertex_count; i++)
+    {
+        uint32_t slot = _hash_vertex(&vertices[i]) & (table_size - 1);
+        while (table[slot] >= 0 && memcmp(&vertices[table[slot]], &vertices[i], sizeof(vertex_t))) slot = (slot + 1) & (table_size - 1);
+
+        if (table[slot] < 0)
+        {
+            vertices[unique] = vertices[i];
+            table[slot] = unique++;
+        }
+
+        remap[i] = table[slot];
+    }
+
+    for (int i = 0; i < index_count; i++) indices[i] = remap[indices[i]];
+
+    free(remap);
+    free(table);
+    return unique;
+}
+
+// VERTEX CACHE
+// ------------
+// tom forsyth's linear-speed vertex cache optimisation: greedily emit the triangle whose
+// vertices score best, where recently used vertices and vertices with few triangles left
+// score high.
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+static float _vertex_score(int cache_position, int remaining)
+{
+    if (!remaining) return -1.0f; // nothing left to use it for
+
+    float score = 0.0f;
+    if (cache_position >= 0)
+    {
+        if (cache_position < 3) score = LAST_TRIANGLE_SCORE; // just used, dont reward emitting the same triangle again
+        else score = powf(1.0f - (cache_position - 3) * (1.0f / (MESHOPT_CACHE_SIZE - 3)), CACHE_DECAY_POWER);
+    }
+
+    return score + VALENCE_BOOST_SCALE * powf((float) remaining, -VALENCE_BOOST_POWER);
+}
+
+void meshopt_vertex_cache(unsigned int* indices, int index_count, int vertex_count)
+{
+    int triangle_count = index_count / 3;
+    if (triangle_count < 2) return;
+
+    // vertex -> triangles, csr style
+    int* offsets = calloc(vertex_count + 1, sizeof(int));
+    int* remaining = calloc(vertex_count, sizeof(int));
+    for (int i = 0; i < index_count; i++) remaining[indices[i]]++;
+    for (int v = 0; v < vertex_count; v++) offsets[v + 1] = offsets[v] + remaining[v];
+
+    int* adjacency = malloc(sizeof(int) * index_count);
+    int* fill = malloc(sizeof(int) * vertex_count);
+    memcpy(fill, offsets, sizeof(int) * vertex_count);
+    for (int i = 0; i < index_count; i++) adjacency[fill[indices[i]]++] = i / 3;
+    free(fill);
+
+    int* cache_position = malloc(sizeof(int) * vertex_count);
+    float* vertex_score = malloc(sizeof(float) * vertex_count);
+    for (int v = 0; v < vertex_count; v++)
+    {
+        cache_position[v] = -1;
+        vertex_score[v] = _vertex_score(-1, remaining[v]);
+    }
+
+    float* triangle_score = malloc(sizeof(float) * triangle_count);
+    unsigned char* emitted = calloc(triangle_count, 1);
+    for (int t = 0; t < triangle_count; t++)
+    {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+    }
+
+    unsigned int* output = malloc(sizeof(unsigned int) * index_count);
+    int cache[MESHOPT_CACHE_SIZE + 3], cache_count = 0;
+    int next_scan = 0; // fallback when nothing in the cache has triangles left
+
+    int best = 0;
+    for (int t = 1; t < triangle_count; t++) if (triangle_score[t] > triangle_score[best]) best = t;
+
+    for (int emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+    {
+        if (best < 0)
+        {
+            while (emitted[next_scan]) next_scan++;
+            best = next_scan;
+        }
+
+        const unsigned int* triangle = indices + best * 3;
+        memcpy(output + emitted_count * 3, triangle, sizeof(unsigned int) * 3);
+        emitted[best] = 1;
+
+        // take the triangle out of its vertices adjacency
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangle[k];
+            int* list = adjacency + offsets[v];
+            for (int i = 0; i < remaining[v]; i++)
+            {
+                if (list[i] != best) continue;
+                list[i] = list[remaining[v] - 1];
+                break;
+            }
+            remaining[v]--;
+        }
+
+        // lru: the triangles vertices go to the front, the rest shift back
+        int new_cache[MESHOPT_CACHE_SIZE + 3], new_count = 0;
+        for (int k = 0; k < 3; k++) new_cache[new_count++] = triangle[k];
+        for (int i = 0; i < cache_count; i++)
+        {
+            int v = cache[i];
+            if (v != (int) triangle[0] && v != (int) triangle[1] && v != (int) triangle[2]) new_cache[new_count++] = v;
+        }
+
+        for (int i = 0; i < new_count; i++) cache_position[new_cache[i]] = i < MESHOPT_CACHE_SIZE ? i : -1;
+
+        // rescore whats affected and pick the next triangle from the cache neighbourhood
+        best = -1;
+        float best_score = -FLT_MAX;
+        for (int i = 0; i < new_count; i++)
+        {
+            int v = new_cache[i];
+            vertex_score[v] = _vertex_score(cache_position[v], remaining[v]);
+        }
+
+        for (int i = 0; i < new_count; i++)
+        {
+            int v = new_cache[i];
+            for (int j = 0; j < remaining[v]; j++)
+            {
+                int t = adjacency[offsets[v] + j];
+                float score = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+                triangle_score[t] = score;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        cache_count = new_count < MESHOPT_CACHE_SIZE ? new_count : MESHOPT_CACHE_SIZE;
+        memcpy(cache, new_cache, sizeof(int) * cache_count);
+    }
+
+    memcpy(indices, output, sizeof(unsigned int) * index_count);
+
+    free(output);
+    free(emitted);
+    free(triangle_score);
+    free(vertex_score);
+    free(cache_position);
+    free(adjacency);
+    free(remaining);
+    free(offsets);
+}
+
+// OVERDRAW
+// --------
+// cuts the cache optimised order into clusters where the cache starts over anyway (a triangle
+// with three misses) or where the cluster so far is already as cache friendly as the whole
+// mesh, then draws the clusters that face away from the mesh center first - those are the
+// outside and tend to hide the rest. close to sander et al. "tipsy".
+#define MIN_CLUSTER_TRIANGLES 128
+typedef struct
+{
+    int first, count; // triangles
+    float sort;
+} _cluster_t;
+
+static int _compare_clusters(const void* a, const void* b)
+{
+    float x = ((const _cluster_t*) a)->sort, y = ((const _cluster_t*) b)->sort;
+    return (x < y) - (x > y); // biggest first
+}
+
+int meshopt_overdraw(unsigned int* indices, int index_count, const vertex_t* vertices, int vertex_count, float threshold)
+{
+    int triangle_count = index_count / 3;
+    if (triangle_count < 2) return 0;
+
+    meshopt_stats_t before = meshopt_analyze(indices, index_count, vertex_count);
+
+    _cluster_t* clusters = malloc(sizeof(_cluster_t) * triangle_count);
+    int cluster_count = 0;
+
+    unsigned int* timestamps = calloc(vertex_count, sizeof(unsigned int));
+    unsigned int time = MESHOPT_FIFO_SIZE + 1;
+    int cluster_misses = 0, soft_boundary = 0;
+    for (int t = 0; t < triangle_count; t++)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - timestamps[v] > MESHOPT_FIFO_SIZE)
+            {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+
+        if (!cluster_count || misses == 3 || soft_boundary)
+        {
+            clusters[cluster_count++] = (_cluster_t) { t, 0, 0.0f };
+            cluster_misses = 0;
+        }
+
+        _cluster_t* cluster = &clusters[cluster_count - 1];
+        cluster->count++;
+        cluster_misses += misses;
+        soft_boundary = cluster->count >= MIN_CLUSTER_TRIANGLES && cluster_misses <= before.acmr * threshold * cluster->count;
+    }
+    free(timestamps);
+
+    if (cluster_count < 2)
+    {
+        free(clusters);
+        return 0;
+    }
+
+    // area weighted centroid of everything
+    float center[3] = { 0 }, total_area = 0.0f;
+    float* centroids = malloc(sizeof(float) * 3 * cluster_count);
+    float* normals = malloc(sizeof(float) * 3 * cluster_count);
+
+    for (int c = 0; c < cluster_count; c++)
+    {
+        float* centroid = centroids + c * 3;
+        float* normal = normals + c * 3;
+        float area = 0.0f;
+        memset(centroid, 0, sizeof(float) * 3);
+        memset(normal, 0, sizeof(float) * 3);
+
+        for (int t = clusters[c].first; t < clusters[c].first + clusters[c].count; t++)
+        {
+            const float* a = vertices[indices[t * 3]].position;
+            const float* b = vertices[indices[t * 3 + 1]].position;
+            const float* d = vertices[indices[t * 3 + 2]].position;
+
+            float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e1[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+            float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+            float triangle_area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+
+            for (int i = 0; i < 3; i++)
+            {
+                centroid[i] += (a[i] + b[i] + d[i]) / 3.0f * triangle_area;
+                normal[i] += n[i];
+            }
+            area += triangle_area;
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            center[i] += centroid[i];
+            centroid[i] = area > 0.0f ? centroid[i] / area : 0.0f;
+        }
+        total_area += area;
+    }
+
+    for (int i = 0; i < 3; i++) center[i] = total_area > 0.0f ? center[i] / total_area : 0.0f;
+
+    for (int c = 0; c < cluster_count; c++)
+    {
+        const float* centroid = centroids + c * 3;
+        const float* normal = normals + c * 3;
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float sort = 0.0f;
+        for (int i = 0; i < 3; i++) sort += (centroid[i] - center[i]) * (length > 0.0f ? normal[i] / length : 0.0f);
+        clusters[c].sort = sort;
+    }
+
+    free(normals);
+    free(centroids);
+
+    qsort(clusters, cluster_count, sizeof(_cluster_t), _compare_clusters);
+
+    unsigned int* output = malloc(sizeof(unsigned int) * index_count);
+    int written = 0;
+    for (int c = 0; c < cluster_count; c++)
+    {
+        memcpy(output + written, indices + clusters[c].first * 3, sizeof(unsigned int) * 3 * clusters[c].count);
+        written += clusters[c].count * 3;
+    }
+    memcpy(output + written, indices + written, sizeof(unsigned int) * (index_count - written)); // leftover indices, if any
+
+    // only worth it if the cache doesnt suffer much
+    meshopt_stats_t after = meshopt_analyze(output, index_count, vertex_count);
+    if (after.acmr > before.acmr * threshold) cluster_count = 0;
+    else memcpy(indices, output, sizeof(unsigned int) * index_count);
+
+    free(output);
+    free(clusters);
+    return cluster_count;
+}
+
+// VERTEX FETCH
+// ------------
+int meshopt_vertex_fetch(vertex_t* vertices, int vertex_count, unsigned int* indices, int index_count)
+{
+    unsigned int* remap = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+    memset(remap, 0xff, sizeof(unsigned int) * vertex_count);
+    vertex_t* sorted = malloc(sizeof(vertex_t) * (vertex_count ? vertex_count : 1));
+
+    // vertices in the order the index buffer first touches them
+    int count = 0;
+    for (int i = 0; i < index_count; i++)
+    {
+        unsigned int v = indices[i];
+        if (remap[v] == 0xffffffffu)
+        {
+            sorted[count] = vertices[v];
+            remap[v] = count++;
+        }
+        indices[i] = remap[v];
+    }
+
+    memcpy(vertices, sorted, sizeof(vertex_t) * count);
+
+    free(sorted);
+    free(remap);
+    return count;
+}
+
+// SIMPLIFICATION
+// --------------
+// garland-heckbert quadrics with half edge collapses (a vertex moves onto a neighbour), so
+// every level keeps the same vertices and only needs its own indices. collapses go in passes:
+// every vertex picks its cheapest neighbour, cheapest first, and a collapse blocks the
+// vertices around it until the next pass so the flip checks stay valid.
+//
+// vertices sharing a position with another one (uv/normal seams) never move, vertices on the
+// border only slide along it, held there by extra quadrics through the border edges. indices
+// that went through meshopt_position_remap have no seams left, so everything can move.
+#define SIMPLIFY_BORDER_WEIGHT 10.0
+#define SIMPLIFY_MAX_PASSES 64
+#define SIMPLIFY_PASS_SHARE 4 // collapses a pass goes through, 1 / this of the candidates by cost
+
+enum
+{
+    SIMPLIFY_INTERIOR,
+    SIMPLIFY_BORDER,
+    SIMPLIFY_LOCKED,
+};
+
+typedef struct
+{
+    double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+    double weight; // triangle area, so the error comes out as a distance
+} _quadric_t;
+
+typedef struct
+{
+    unsigned int from, to;
+    double cost;
+} _collapse_t;
+
+static const float* _position(const float* positions, int stride, unsigned int vertex)
+{
+    return (const float*) ((const char*) positions + (size_t) stride * vertex);
+}
+
+static void _quadric_add_plane(_quadric_t* q, double a, double b, double c, double d, double w)
+{
+    q->a2 += w * a * a; q->b2 += w * b * b; q->c2 += w * c * c;
+    q->ab += w * a * b; q->ac += w * a * c; q->bc += w * b * c;
+    q->ad += w * a * d; q->bd += w * b * d; q->cd += w * c * d;
+    q->d2 += w * d * d;
+}
+
+static void _quadric_add(_quadric_t* q, const _quadric_t* other)
+{
+    q->a2 += other->a2; q->b2 += other->b2; q->c2 += other->c2;
+    q->ab += other->ab; q->ac += other->ac; q->bc += other->bc;
+    q->ad += other->ad; q->bd += other->bd; q->cd += other->cd;
+    q->d2 += other->d2;
+    q->weight += other->weight;
+}
+
+static double _quadric_error(const _quadric_t* q, const float* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double error = q->a2 * x * x + q->b2 * y * y + q->c2 * z * z + 2.0 * (q->ab * x * y + q->ac * x * z + q->bc * y * z + q->ad * x + q->bd * y + q->cd * z) + q->d2;
+    return fabs(error) / (q->weight > 0.0 ? q->weight : 1.0);
+}
+
+static void _triangle_normal(const float* a, const float* b, const float* c, double* normal)
+{
+    double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    normal[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    normal[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    normal[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+// directed edges of the current triangles, a border edge is one without its twin
+typedef struct
+{
+    uint64_t* keys;
+    int mask;
+} _edge_set_t;
+
+static uint32_t _hash_edge(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t) key;
+}
+
+static void _edge_set_build(_edge_set_t* set, const unsigned int* indices, int index_count)
+{
+    int size = 1;
+    while (size < index_count * 2) size *= 2;
+
+    set->keys = realloc(set->keys, sizeof(uint64_t) * size);
+    memset(set->keys, 0xff, sizeof(uint64_t) * size);
+    set->mask = size - 1;
+
+    for (int i = 0; i < index_count; i++)
+    {
+        uint64_t key = (uint64_t) indices[i] << 32 | indices[i - i % 3 + (i + 1) % 3];
+        uint32_t slot = _hash_edge(key) & set->mask;
+        while (set->keys[slot] != UINT64_MAX && set->keys[slot] != key) slot = (slot + 1) & set->mask;
+        set->keys[slot] = key;
+    }
+}
+
+static int _edge_set_has(const _edge_set_t* set, unsigned int a, unsigned int b)
+{
+    uint64_t key = (uint64_t) a << 32 | b;
+    uint32_t slot = _hash_edge(key) & set->mask;
+    while (set->keys[slot] != UINT64_MAX)
+    {
+        if (set->keys[slot] == key) return 1;
+        slot = (slot + 1) & set->mask;
+    }
+    return 0;
+}
+
+static int _edge_is_border(const _edge_set_t* set, unsigned int a, unsigned int b)
+{
+    return _edge_set_has(set, a, b) != _edge_set_has(set, b, a);
+}
+
+static int _compare_collapses(const void* a, const void* b)
+{
+    double x = ((const _collapse_t*) a)->cost, y = ((const _collapse_t*) b)->cost;
+    return (x > y) - (x < y);
+}
+
+void meshopt_position_remap(const float* positions, int stride, int vertex_count, unsigned int* remap)
+{
+    int table_size = 1;
+    while (table_size < vertex_count * 2) table_size *= 2;
+    int* table = malloc(sizeof(int) * table_size);
+    memset(table, 0xff, sizeof(int) * table_size);
+
+    for (int i = 0; i < vertex_count; i++)
+    {
+        const unsigned char* bytes = (const unsigned char*) _position(positions, stride, i);
+        uint32_t hash = 2166136261u;
+        for (int b = 0; b < (int) sizeof(float) * 3; b++) hash = (hash ^ bytes[b]) * 16777619u;
+
+        uint32_t slot = hash & (table_size - 1);
+        while (table[slot] >= 0 && memcmp(_position(positions, stride, table[slot]), bytes, sizeof(float) * 3)) slot = (slot + 1) & (table_size - 1);
+
+        if (table[slot] < 0) table[slot] = i;
+        remap[i] = table[slot];
+    }
+
+    free(table);
+}
+
+// referenced vertices sharing a position with another referenced one, those are seams
+static unsigned char* _find_seams(const unsigned int* indices, int index_count, const float* positions, int stride, int vertex_count)
+{
+    unsigned char* seams = calloc(vertex_count ? vertex_count : 1, 1);
+    unsigned char* used = calloc(vertex_count ? vertex_count : 1, 1);
+    unsigned int* remap = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+    unsigned int* first_used = malloc(sizeof(unsigned int) * (vertex_count ? vertex_count : 1));
+
+    for (int i = 0; i < index_count; i++) used[indices[i]] = 1;
+    meshopt_position_remap(positions, stride, vertex_count, remap);
+    memset(first_used, 0xff, sizeof(unsigned int) * vertex_count);
+
+    for (int i = 0; i < vertex_count; i++)
+    {
+        if (!used[i]) continue;
+
+        unsigned int* first = &first_used[remap[i]];
+        if (*first == UINT_MAX) *first = i;
+        else seams[i] = seams[*first] = 1;
+    }
+
+    free(first_used);
+    free(remap);
+    free(used);
+    return seams;
+}
+
+int meshopt_simplify(unsigned int* indices, int index_count, const float* positions, int stride, int vertex_count, int target_index_count, float max_error, float* error)
+{
+    *error = 0.0f;
+    if (index_count <= target_index_count) return index_count;
+
+    unsigned char* seams = _find_seams(indices, index_count, positions, stride, vertex_count);
+    unsigned char* kinds = malloc(vertex_count);
+    unsigned char* touched = malloc(vertex_count);
+    unsigned int* remap = malloc(sizeof(unsigned int) * vertex_count);
+    _quadric_t* quadrics = calloc(vertex_count, sizeof(_quadric_t));
+    _collapse_t* collapses = malloc(sizeof(_collapse_t) * vertex_count);
+    int* offsets = malloc(sizeof(int) * (vertex_count + 1));
+    int* adjacency = malloc(sizeof(int) * index_count);
+    _edge_set_t edges = { 0 };
+
+    // plane of every triangle, weighted by area
+    _edge_set_build(&edges, indices, index_count);
+    for (int t = 0; t < index_count; t += 3)
+    {
+        const float* p[3] = { _position(positions, stride, indices[t]), _position(positions, stride, indices[t + 1]), _position(positions, stride, indices[t + 2]) };
+        double normal[3];
+        _triangle_normal(p[0], p[1], p[2], normal);
+
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length <= 0.0) continue;
+        for (int i = 0; i < 3; i++) normal[i] /= length;
+        double d = -(normal[0] * p[0][0] + normal[1] * p[0][1] + normal[2] * p[0][2]);
+
+        for (int i = 0; i < 3; i++)
+        {
+            _quadric_t* q = &quadrics[indices[t + i]];
+            _quadric_add_plane(q, normal[0], normal[1], normal[2], d, length * 0.5);
+            q->weight += length * 0.5;
+        }
+
+        // borders: a plane through the edge, at a right angle to the triangle
+        for (int i = 0; i < 3; i++)
+        {
+            unsigned int a = indices[t + i], b = indices[t + (i + 1) % 3];
+            if (_edge_set_has(&edges, b, a)) continue;
+
+            double edge[3] = { p[(i + 1) % 3][0] - p[i][0], p[(i + 1) % 3][1] - p[i][1], p[(i + 1) % 3][2] - p[i][2] };
+            double side[3] = { edge[1] * normal[2] - edge[2] * normal[1], edge[2] * normal[0] - edge[0] * normal[2], edge[0] * normal[1] - edge[1] * normal[0] };
+            double side_length = sqrt(side[0] * side[0] + side[1] * side[1] + side[2] * side[2]);
+            if (side_length <= 0.0) continue;
+            for (int c = 0; c < 3; c++) side[c] /= side_length;
+
+            double side_d = -(side[0] * p[i][0] + side[1] * p[i][1] + side[2] * p[i][2]);
+            double weight = SIMPLIFY_BORDER_WEIGHT * side_length * side_length; // |edge|^2, side is edge x unit normal
+            _quadric_add_plane(&quadrics[a], side[0], side[1], side[2], side_d, weight);
+            _quadric_add_plane(&quadrics[b], side[0], side[1], side[2], side_d, weight);
+        }
+    }
+
+    double limit = (double) max_error * max_error, worst = 0.0;
+    for (int pass = 0; pass < SIMPLIFY_MAX_PASSES && index_count > target_index_count; pass++)
+    {
+        int pass_index_count = index_count;
+
+        // vertex -> triangles
+        memset(offsets, 0, sizeof(int) * (vertex_count + 1));
+        for (int i = 0; i < index_count; i++) offsets[indices[i] + 1]++;
+        for (int v = 0; v < vertex_count; v++) offsets[v + 1] += offsets[v];
+        for (int i = 0; i < index_count; i++) adjacency[offsets[indices[i]]++] = i / 3;
+        for (int v = vertex_count; v > 0; v--) offsets[v] = offsets[v - 1];
+        offsets[0] = 0;
+
+        // a border vertex with anything but exactly 2 border edges is a corner
+        if (pass) _edge_set_build(&edges, indices, index_count);
+        memset(kinds, SIMPLIFY_INTERIOR, vertex_count);
+        int* border_edges = (int*) remap; // scratch, remap gets reset below
+        memset(border_edges, 0, sizeof(int) * vertex_count);
+        for (int i = 0; i < index_count; i++)
+        {
+            unsigned int a = indices[i], b = indices[i - i % 3 + (i + 1) % 3];
+            if (_edge_set_has(&edges, b, a)) continue;
+            border_edges[a]++;
+            border_edges[b]++;
+        }
+        for (int v = 0; v < vertex_count; v++)
+        {
+            if (seams[v] || (border_edges[v] && border_edges[v] != 2)) kinds[v] = SIMPLIFY_LOCKED;
+            else if (border_edges[v]) kinds[v] = SIMPLIFY_BORDER;
+        }
+
+        // cheapest collapse per vertex
+        int collapse_count = 0;
+        for (int u = 0; u < vertex_count; u++)
+        {
+            if (kinds[u] == SIMPLIFY_LOCKED || offsets[u] == offsets[u + 1]) continue;
+
+            _collapse_t best = { u, u, DBL_MAX };
+            for (int n = offsets[u]; n < offsets[u + 1]; n++)
+            {
+                const unsigned int* triangle = indices + adjacency[n] * 3;
+                for (int c = 0; c < 3; c++)
+                {
+                    unsigned int v = triangle[c];
+                    if (v == (unsigned int) u) continue;
+                    if (kinds[u] == SIMPLIFY_BORDER && !_edge_is_border(&edges, u, v)) continue;
+
+                    _quadric_t q = quadrics[u];
+                    _quadric_add(&q, &quadrics[v]);
+                    double cost = _quadric_error(&q, _position(positions, stride, v));
+                    if (cost < best.cost) best = (_collapse_t) { u, v, cost };
+                }
+            }
+
+            if (best.cost <= limit) collapses[collapse_count++] = best;
+        }
+
+        qsort(collapses, collapse_count, sizeof(_collapse_t), _compare_collapses);
+
+        // only the cheap end per pass, cheap collapses the blocking pushed out get another go next pass
+        double pass_limit = collapse_count ? collapses[collapse_count / SIMPLIFY_PASS_SHARE].cost : 0.0;
+
+        for (int v = 0; v < vertex_count; v++) remap[v] = v;
+        memset(touched, 0, vertex_count);
+
+        int collapsed = 0;
+        for (int i = 0; i < collapse_count && index_count > target_index_count; i++)
+        {
+            unsigned int u = collapses[i].from, v = collapses[i].to;
+            if (collapses[i].cost > pass_limit) break;
+            if (touched[u] || touched[v]) continue;
+
+            // no flipped triangles around u
+            int flips = 0, removed = 0;
+            for (int n = offsets[u]; n < offsets[u + 1] && !flips; n++)
+            {
+                const unsigned int* triangle = indices + adjacency[n] * 3;
+                if (triangle[0] == v || triangle[1] == v || triangle[2] == v)
+                {
+                    removed++;
+                    continue;
+                }
+
+                const float* before[3], *after[3];
+                for (int c = 0; c < 3; c++)
+                {
+                    before[c] = _position(positions, stride, triangle[c]);
+                    after[c] = _position(positions, stride, triangle[c] == u ? v : triangle[c]);
+                }
+
+                double old_normal[3], new_normal[3];
+                _triangle_normal(before[0], before[1], before[2], old_normal);
+                _triangle_normal(after[0], after[1], after[2], new_normal);
+                flips = old_normal[0] * new_normal[0] + old_normal[1] * new_normal[1] + old_normal[2] * new_normal[2] <= 0.0;
+            }
+            if (flips) continue;
+
+            remap[u] = v;
+            _quadric_add(&quadrics[v], &quadrics[u]);
+            for (int n = offsets[u]; n < offsets[u + 1]; n++)
+            {
+                const unsigned int* triangle = indices + adjacency[n] * 3;
+                for (int c = 0; c < 3; c++) touched[triangle[c]] = 1;
+            }
+
+            worst = collapses[i].cost > worst ? collapses[i].cost : worst;
+            index_count -= removed * 3;
+            collapsed++;
+        }
+
+        if (!collapsed) break;
+
+        // apply, dropping whatever collapsed to a line
+        int count = 0;
+        for (int t = 0; t < pass_index_count; t += 3)
+        {
+            unsigned int a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+            if (a == b || b == c || c == a) continue;
+            indices[count++] = a;
+            indices[count++] = b;
+            indices[count++] = c;
+        }
+        index_count = count;
+    }
+
+    free(edges.keys);
+    free(adjacency);
+    free(offsets);
+    free(collapses);
+    free(quadrics);
+    free(remap);
+    free(touched);
+    free(kinds);
+    free(seams);
+
+    *error = (float) sqrt(worst);
+    return index_count;
+}
+
+int meshopt_build_lods(const unsigned int* indices, int index_count, const float* positions, int stride, int vertex_count, unsigned int* lod_indices, meshopt_lod_t* lods)
+{
+    unsigned int* scratch = malloc(sizeof(unsigned int) * (index_count ? index_count : 1));
+    const unsigned int* source = indices;
+    int source_count = index_count, offset = 0, level_count = 0;
+    float error = 0.0f;
+
+    // each level from the one before, cheaper than from full detail every time
+    while (level_count < MESHOPT_LOD_LEVELS - 1)
+    {
+        memcpy(scratch, source, sizeof(unsigned int) * source_count);
+
+        float level_error;
+        int target = (int) (source_count / 3 * MESHOPT_LOD_RATIO) * 3;
+        int count = meshopt_simplify(scratch, source_count, positions, stride, vertex_count, target, FLT_MAX, &level_error);
+        if (!count || count > source_count * MESHOPT_LOD_MIN_SAVING) break;
+
+        meshopt_vertex_cache(scratch, count, vertex_count);
+        memcpy(lod_indices + offset, scratch, sizeof(unsigned int) * count);
+
+        error += level_error; // against the previous level, so they add up
+        lods[level_count++] = (meshopt_lod_t) { offset, count, error };
+
+        source = lod_indices + offset;
+        source_count = count;
+        offset += count;
+    }
+
+    free(scratch);
+    return level_count;
+}
+
+// ALL OF IT
+// ---------
+meshopt_report_t meshopt_optimize(vertex_t* vertices, int* vertex_count, unsigned int* indices, int index_count)
+{
+    meshopt_report_t report = { 0 };
+    report.vertices_before = *vertex_count;
+    report.before = meshopt_analyze(indices, index_count, *vertex_count);
+
+    int count = meshopt_weld(vertices, *vertex_count, indices, index_count);
+    meshopt_vertex_cache(indices, index_count, count);
+    report.clusters = meshopt_overdraw(indices, index_count, vertices, count, MESHOPT_OVERDRAW_THRESHOLD);
+    count = meshopt_vertex_fetch(vertices, count, indices, index_count);
+
+    *vertex_count = count;
+    report.vertices_after = count;
+    report.after = meshopt_analyze(indices, index_count, count);
+    return report;
+}
+
+void meshopt_print_report(const char* name, const meshopt_report_t* report)
+{
+    printf("%s: %i -> %i vertices, acmr %.3f -> %.3f, atvr %.3f -> %.3f, %i overdraw clusters\n", name,
+        report->vertices_before, report->vertices_after,
+        report->before.acmr, report->after.acmr, report->before.atvr, report->after.atvr, report->clusters);
+}
+
+int meshopt_index_size(int vertex_count)
+{
+    return vertex_count <= 65536 ? 2 : 4;
+}
+
+void meshopt_narrow_indices(const unsigned int* indices, int index_count, uint16_t* out)
+{
+    for (int i = 0; i < index_count; i++) out[i] = (uint16_t) indices[i];
+}
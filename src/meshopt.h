@@ -0,0 +1,59 @@
+#pragma once
+
+// MESH OPTIMIZATION
+// -----------------
+// cpu only, no gl - loaders run it before primitive_load_vertices and tooling/mapc.c runs it
+// at cook time. works on full precision vertex_t and 32 bit triangle lists, in place.
+//
+// order matters, meshopt_optimize does all of it:
+//   weld -> vertex cache -> overdraw -> vertex fetch -> (16 bit indices at upload)
+//
+// lods come after that, they share the vertices and only add indices (see SIMPLIFICATION).
+
+#include "vertex.h"
+
+#define MESHOPT_CACHE_SIZE 32 // lru size the triangle order is tuned for
+#define MESHOPT_FIFO_SIZE 16 // fifo size the stats are measured with, closer to what gpus do
+#define MESHOPT_OVERDRAW_THRESHOLD 1.05f // overdraw order may cost this much acmr before it gets thrown away
+
+#define MESHOPT_LOD_LEVELS 4 // full detail included
+#define MESHOPT_LOD_RATIO 0.5f // triangles each level aims for, against the one before
+#define MESHOPT_LOD_MIN_SAVING 0.8f // a level that keeps more than this isnt worth the indices, the chain stops there
+
+typedef struct meshopt_stats_s
+{
+    float acmr; // vertex shader runs per triangle, 0.5 is the best a regular grid can do, 3 the worst
+    float atvr; // vertex shader runs per vertex, 1 is perfect
+} meshopt_stats_t;
+
+typedef struct meshopt_report_s
+{
+    int vertices_before, vertices_after;
+    meshopt_stats_t before, after;
+    int clusters; // overdraw clusters, 0 if that order was rejected
+} meshopt_report_t;
+
+typedef struct meshopt_lod_s
+{
+    int first_index, index_count; // into lod_indices
+    float error; // object space distance from full detail, roughly
+} meshopt_lod_t;
+
+extern int meshopt_weld(vertex_t* vertices, int vertex_count, unsigned int* indices, int index_count); // exact duplicates, returns the new vertex count
+extern void meshopt_vertex_cache(unsigned int* indices, int index_count, int vertex_count); // forsyth
+extern int meshopt_overdraw(unsigned int* indices, int index_count, const vertex_t* vertices, int vertex_count, float threshold); // after meshopt_vertex_cache, returns clusters (0 = kept as is)
+extern int meshopt_vertex_fetch(vertex_t* vertices, int vertex_count, unsigned int* indices, int index_count); // first use order, drops unused, returns the new vertex count
+
+// positions are the first 3 floats of every stride bytes, so this works on any vertex struct
+extern void meshopt_position_remap(const float* positions, int stride, int vertex_count, unsigned int* remap); // every vertex to the first one at its position. lods on remapped indices dont care about seams
+extern int meshopt_simplify(unsigned int* indices, int index_count, const float* positions, int stride, int vertex_count, int target_index_count, float max_error, float* error); // in place, returns the new index count
+extern int meshopt_build_lods(const unsigned int* indices, int index_count, const float* positions, int stride, int vertex_count, unsigned int* lod_indices, meshopt_lod_t* lods); // up to MESHOPT_LOD_LEVELS - 1 levels back to back in lod_indices (2 * index_count always fits), returns how many
+
+extern meshopt_stats_t meshopt_analyze(const unsigned int* indices, int index_count, int vertex_count);
+
+extern meshopt_report_t meshopt_optimize(vertex_t* vertices, int* vertex_count, unsigned int* indices, int index_count);
+extern void meshopt_print_report(const char* name, const meshopt_report_t* report);
+
+// 16 bit indices whenever the vertices fit
+extern int meshopt_index_size(int vertex_count); // 2 or 4
+extern void meshopt_narrow_indices(const unsigned int* indices, int index_count, uint16_t* out);
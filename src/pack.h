@@ -0,0 +1,42 @@
+#pragma once
+
+// ASSET PACK (.pak)
+// -----------------
+// everything under content/ in one file, written by tooling/pack.c and mmapped once at startup.
+// layout: pack_header_t, then count pack_entry_t sorted by hash, then the names, then the data.
+// every entry starts on a PACK_ALIGN boundary and is followed by a '\0' (not counted in size),
+// so shader sources can be used straight out of the mapping.
+
+#include <stdint.h>
+#include <string.h>
+
+#define PACK_MAGIC 0x4b415043 // "CPAK"
+#define PACK_VERSION 1
+#define PACK_ALIGN 16
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+} pack_header_t;
+
+typedef struct
+{
+    uint64_t hash; // pack_hash of the path relative to content/, eg. "gfx/src/basic.v.glsl"
+    uint32_t offset, size; // data, from the start of the file
+    uint32_t name_offset, name_length; // for telling collisions apart
+} pack_entry_t;
+
+// fnv-1a
+static inline uint64_t pack_hash(const char* path)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char* c = (const unsigned char*) path; *c; c++)
+    {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
@@ -4,6 +4,15 @@
 #include "external/HandmadeMath.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include <math.h>
+#include <stdint.h>
+
+#define REN2D_MAX_FONTS 8
+#define REN2D_ATLAS_PADDING 1 // keeps linear filtering from bleeding neighbours in
 
 static mat4_t projection;
 
@@ -16,22 +25,81 @@ static struct
 } _quaddata;
 
 // spritefont rendering data
+// every glyph is one instance of the quad, everything queued for a font goes out in one draw at ren2d_flush()
+typedef struct
+{
+    float x, y;
+    float scale;
+    unsigned int index;
+    unsigned char rgba[4];
+} glyph_instance_t;
+
+typedef struct
+{
+    spritefont_t* font;
+
+    glyph_instance_t* glyphs;
+    int count, capacity;
+} glyph_batch_t;
+
 static struct 
 {
     program_t shader;
-    struct
-    {
-        int model;
+    int ready; // uniforms get looked up on first use, the program may still be linking after init
 
-        int fg;
-        int bg;
+    unsigned int vao; // quad + per-glyph attributes
 
-        int charindex;
-        int charwidth;
-        int charheight;
+    struct
+    {
+        int charsize;
+        int font;
     } uniforms;
+
+    glyph_batch_t batches[REN2D_MAX_FONTS];
 } sfrenderer;
 
+// sprite rendering data
+typedef struct
+{
+    float x, y, w, h; // top left + size before rotation
+    float rotation; // radians
+    unsigned short uv[4]; // unorm16
+    unsigned char rgba[4];
+} sprite_instance_t;
+
+typedef struct
+{
+    unsigned int texture;
+    int live_sprites; // page gets reset once nothing references it
+
+    int shelf_count;
+    struct
+    {
+        int y, height;
+        int x; // next free x on this shelf
+    } shelves[REN2D_MAX_ATLAS_SHELVES];
+} atlas_page_t;
+
+static struct
+{
+    program_t shader;
+    int ready;
+
+    unsigned int vao;
+    int projection_uniform;
+    int atlas_uniform;
+
+    atlas_page_t pages[REN2D_MAX_ATLAS_PAGES];
+    int page_count;
+
+    // queued this frame, sorted at flush
+    sprite_instance_t* instances;
+    uint32_t* keys; // layer | blend | page
+    uint32_t* order;
+    uint32_t* scratch; // radix ping-pong (keys + order)
+    int count, capacity;
+} sprrenderer;
+
 void ren2d_init()
 {
     // setup projection according to screen dimensions
@@ -51,14 +119,14 @@ void ren2d_init()
     };
 
     glGenVertexArrays(1, &_quaddata.vao);
-    glBindVertexArray(_quaddata.vao);
+    choks_bind_vertex_array(_quaddata.vao);
 
     glGenBuffers(1, &_quaddata.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, _quaddata.vbo);
+    choks_bind_buffer(GL_ARRAY_BUFFER, _quaddata.vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadcoords), quadcoords, GL_STATIC_DRAW);
 
     glGenBuffers(1, &_quaddata.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quaddata.ibo);
+    choks_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, _quaddata.ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadindices), quadindices, GL_STATIC_DRAW);
 
     // pos.xy = xy, pos.zw = st
@@ -69,25 +137,392 @@ void ren2d_init()
 
     // SETUP SPRITEFONT RENDERER
     sfrenderer.shader = program_load_from_files("gfx/src/bitmapfont.v.glsl", "gfx/src/bitmapfont.f.glsl");
-    glUseProgram(sfrenderer.shader.id);
+    sfrenderer.ready = 0;
+
+    // same quad, instance attributes get pointed at the streaming buffer every flush
+    glGenVertexArrays(1, &sfrenderer.vao);
+    choks_bind_vertex_array(sfrenderer.vao);
+
+    choks_bind_buffer(GL_ARRAY_BUFFER, _quaddata.vbo);
+    choks_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, _quaddata.ibo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (void*) 0);
+    glEnableVertexAttribArray(0);
+
+    for (int i = 1; i <= 4; i++)
+    {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+
+    choks_bind_vertex_array(0);
+
+    // SETUP SPRITE RENDERER
+    sprrenderer.shader = program_load_from_files("gfx/src/sprite.v.glsl", "gfx/src/sprite.f.glsl");
+    sprrenderer.ready = 0;
+
+    glGenVertexArrays(1, &sprrenderer.vao);
+    choks_bind_vertex_array(sprrenderer.vao);
+
+    choks_bind_buffer(GL_ARRAY_BUFFER, _quaddata.vbo);
+    choks_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, _quaddata.ibo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 4, (void*) 0);
+    glEnableVertexAttribArray(0);
+
+    for (int i = 1; i <= 4; i++)
+    {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+
+    choks_bind_vertex_array(0);
+}
+
+static void _sprrenderer_setup()
+{
+    choks_use_program(sprrenderer.shader.id);
+    glUniformMatrix4fv(glGetUniformLocation(sprrenderer.shader.id, "projection"), 1, GL_FALSE, &projection.elements[0][0]);
+    glUniform1i(glGetUniformLocation(sprrenderer.shader.id, "atlas"), 0);
+
+    sprrenderer.ready = 1;
+}
+
+static void _sfrenderer_setup()
+{
+    choks_use_program(sfrenderer.shader.id);
 
     glUniformMatrix4fv(glGetUniformLocation(sfrenderer.shader.id, "projection"), 1, GL_FALSE, &projection.elements[0][0]);
-    sfrenderer.uniforms.fg = glGetUniformLocation(sfrenderer.shader.id, "fgcolor");
-    sfrenderer.uniforms.charindex = glGetUniformLocation(sfrenderer.shader.id, "index");
-    sfrenderer.uniforms.model = glGetUniformLocation(sfrenderer.shader.id, "model");
+    sfrenderer.uniforms.charsize = glGetUniformLocation(sfrenderer.shader.id, "charsize");
+    sfrenderer.uniforms.font = glGetUniformLocation(sfrenderer.shader.id, "font");
+
+    sfrenderer.ready = 1;
 }
 
 void ren2d_cleanup()
 {
+    // CLEANUP SPRITE RENDERER
+    for (int i = 0; i < sprrenderer.page_count; i++)
+    {
+        choks_delete_texture(sprrenderer.pages[i].texture);
+    }
+    sprrenderer.page_count = 0;
+
+    free(sprrenderer.instances);
+    free(sprrenderer.keys);
+    free(sprrenderer.order);
+    free(sprrenderer.scratch);
+
+    choks_delete_vertex_array(sprrenderer.vao);
+    program_free(sprrenderer.shader);
+
     // CLEANUP SPRITEFONT RENDERER
+    for (int i = 0; i < REN2D_MAX_FONTS; i++)
+    {
+        free(sfrenderer.batches[i].glyphs);
+    }
+
+    choks_delete_vertex_array(sfrenderer.vao);
     program_free(sfrenderer.shader);
 
     // cleanup quad buffer
-    glDeleteBuffers(1, &_quaddata.ibo);
-    glDeleteBuffers(1, &_quaddata.vbo);
-    glDeleteVertexArrays(1, &_quaddata.vao);
+    choks_delete_buffer(_quaddata.ibo);
+    choks_delete_buffer(_quaddata.vbo);
+    choks_delete_vertex_array(_quaddata.vao);
+}
+
+// SPRITES
+// -------
+// shelf packing: sprites go left to right on rows ("shelves") as tall as the first sprite on them.
+static int _atlas_pack(atlas_page_t* page, int width, int height, int* x, int* y)
+{
+    width += REN2D_ATLAS_PADDING * 2;
+    height += REN2D_ATLAS_PADDING * 2;
+
+    // best fitting shelf
+    int best = -1;
+    for (int i = 0; i < page->shelf_count; i++)
+    {
+        if (page->shelves[i].height >= height && page->shelves[i].x + width <= REN2D_ATLAS_SIZE)
+        {
+            if (best < 0 || page->shelves[i].height < page->shelves[best].height) best = i;
+        }
+    }
+
+    if (best < 0)
+    {
+        // new shelf
+        int top = page->shelf_count ? page->shelves[page->shelf_count - 1].y + page->shelves[page->shelf_count - 1].height : 0;
+        if (top + height > REN2D_ATLAS_SIZE || width > REN2D_ATLAS_SIZE || page->shelf_count == REN2D_MAX_ATLAS_SHELVES) return 0;
+
+        best = page->shelf_count++;
+        page->shelves[best].y = top;
+        page->shelves[best].height = height;
+        page->shelves[best].x = 0;
+    }
+
+    *x = page->shelves[best].x + REN2D_ATLAS_PADDING;
+    *y = page->shelves[best].y + REN2D_ATLAS_PADDING;
+    page->shelves[best].x += width;
+
+    return 1;
+}
+
+static atlas_page_t* _atlas_new_page()
+{
+    if (sprrenderer.page_count == REN2D_MAX_ATLAS_PAGES) return NULL;
+
+    atlas_page_t* page = &sprrenderer.pages[sprrenderer.page_count++];
+    memset(page, 0, sizeof(*page));
+
+    glGenTextures(1, &page->texture);
+    choks_bind_texture(GL_TEXTURE_2D, page->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, REN2D_ATLAS_SIZE, REN2D_ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return page;
 }
 
+sprite_t sprite_load_from_file(const char* path)
+{
+    sprite_t this = { 0 };
+    this.page = -1;
+
+    image_t image = image_load_from_file(path);
+    if (!image.pixels)
+    {
+        printf("sprite %s failed to load\n", path);
+        return this;
+    }
+
+    // first page with room, otherwise a new one
+    int x = 0, y = 0;
+    int page_index = -1;
+    for (int i = 0; i < sprrenderer.page_count; i++)
+    {
+        if (_atlas_pack(&sprrenderer.pages[i], image.width, image.height, &x, &y))
+        {
+            page_index = i;
+            break;
+        }
+    }
+
+    if (page_index < 0)
+    {
+        atlas_page_t* page = _atlas_new_page();
+        if (page && _atlas_pack(page, image.width, image.height, &x, &y)) page_index = sprrenderer.page_count - 1;
+    }
+
+    if (page_index < 0)
+    {
+        printf("sprite %s (%ix%i) does not fit in the atlas\n", path, image.width, image.height);
+        image_free(&image);
+        return this;
+    }
+
+    atlas_page_t* page = &sprrenderer.pages[page_index];
+    page->live_sprites++;
+
+    choks_bind_texture(GL_TEXTURE_2D, page->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+
+    this.page = page_index;
+    this.width = image.width;
+    this.height = image.height;
+    this.u0 = (float) x / REN2D_ATLAS_SIZE;
+    this.v0 = (float) y / REN2D_ATLAS_SIZE;
+    this.u1 = (float) (x + image.width) / REN2D_ATLAS_SIZE;
+    this.v1 = (float) (y + image.height) / REN2D_ATLAS_SIZE;
+
+    image_free(&image);
+    return this;
+}
+
+void sprite_unload(sprite_t* spr)
+{
+    if (spr->page < 0) return;
+
+    // space isnt reclaimed per sprite, but an empty page starts over
+    atlas_page_t* page = &sprrenderer.pages[spr->page];
+    if (--page->live_sprites == 0) page->shelf_count = 0;
+
+    spr->page = -1;
+}
+
+static int _sprrenderer_reserve(int count)
+{
+    if (sprrenderer.count + count <= sprrenderer.capacity) return 1;
+
+    int capacity = sprrenderer.capacity ? sprrenderer.capacity : 1024;
+    while (capacity < sprrenderer.count + count) capacity *= 2;
+
+    sprite_instance_t* instances = realloc(sprrenderer.instances, sizeof(sprite_instance_t) * capacity);
+    uint32_t* keys = realloc(sprrenderer.keys, sizeof(uint32_t) * capacity);
+    uint32_t* order = realloc(sprrenderer.order, sizeof(uint32_t) * capacity);
+    uint32_t* scratch = realloc(sprrenderer.scratch, sizeof(uint32_t) * capacity * 2);
+
+    if (instances) sprrenderer.instances = instances;
+    if (keys) sprrenderer.keys = keys;
+    if (order) sprrenderer.order = order;
+    if (scratch) sprrenderer.scratch = scratch;
+
+    if (!instances || !keys || !order || !scratch) return 0;
+
+    sprrenderer.capacity = capacity;
+    return 1;
+}
+
+static unsigned short _unorm16(float value)
+{
+    return (unsigned short) (HMM_Clamp(0.0f, value, 1.0f) * 65535.0f + 0.5f);
+}
+
+static unsigned char _unorm8(float value)
+{
+    return (unsigned char) (HMM_Clamp(0.0f, value, 1.0f) * 255.0f + 0.5f);
+}
+
+void sprite_draw(sprite_t* spr, int x, int y)
+{
+    sprite_draw_ex(spr, x, y, 0, 0.0f, (vec2_t) { 1.0f, 1.0f }, (vec4_t) { 1.0f, 1.0f, 1.0f, 1.0f }, REN2D_BLEND_ALPHA);
+}
+
+void sprite_draw_ex(sprite_t* spr, int x, int y, int layer, float rotation, vec2_t scale, vec4_t tint, ren2d_blend_t blend)
+{
+    if (spr->page < 0 || !_sprrenderer_reserve(1)) return;
+
+    int i = sprrenderer.count++;
+
+    sprrenderer.instances[i] = (sprite_instance_t) {
+        (float) x, (float) y, spr->width * scale.x, spr->height * scale.y,
+        HMM_ToRadians(rotation),
+        { _unorm16(spr->u0), _unorm16(spr->v0), _unorm16(spr->u1), _unorm16(spr->v1) },
+        { _unorm8(tint.r), _unorm8(tint.g), _unorm8(tint.b), _unorm8(tint.a) },
+    };
+
+    // layer is biased so negative layers sort first
+    uint32_t biased_layer = (uint32_t) (HMM_MAX(-32768, HMM_MIN(layer, 32767)) + 32768);
+    sprrenderer.keys[i] = (biased_layer << 16) | ((uint32_t) blend << 8) | (uint32_t) spr->page;
+}
+
+// stable lsd radix sort of the queued indices by key, skipping bytes that are the same everywhere
+static void _sprrenderer_sort()
+{
+    int count = sprrenderer.count;
+    uint32_t* keys = sprrenderer.keys;
+    uint32_t* order = sprrenderer.order;
+    uint32_t* other_keys = sprrenderer.scratch;
+    uint32_t* other_order = sprrenderer.scratch + sprrenderer.capacity;
+
+    int histograms[4][256] = { 0 };
+    int sorted = 1;
+    for (int i = 0; i < count; i++)
+    {
+        order[i] = i;
+        for (int b = 0; b < 4; b++) histograms[b][(keys[i] >> (b * 8)) & 0xFF]++;
+        if (i && keys[i - 1] > keys[i]) sorted = 0;
+    }
+
+    if (sorted) return; // usual case for huds that draw in layer order
+
+    for (int b = 0; b < 4; b++)
+    {
+        int* histogram = histograms[b];
+        if (histogram[(keys[0] >> (b * 8)) & 0xFF] == count) continue; // nothing to do for this byte
+
+        int offset = 0;
+        for (int v = 0; v < 256; v++)
+        {
+            int n = histogram[v];
+            histogram[v] = offset;
+            offset += n;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            int dst = histogram[(keys[i] >> (b * 8)) & 0xFF]++;
+            other_keys[dst] = keys[i];
+            other_order[dst] = order[i];
+        }
+
+        uint32_t* temp = keys; keys = other_keys; other_keys = temp;
+        temp = order; order = other_order; other_order = temp;
+    }
+
+    // make sure the sorted result ends up in keys/order
+    if (keys != sprrenderer.keys)
+    {
+        memcpy(sprrenderer.keys, keys, sizeof(uint32_t) * count);
+        memcpy(sprrenderer.order, order, sizeof(uint32_t) * count);
+    }
+}
+
+static void _sprrenderer_flush()
+{
+    if (!sprrenderer.count) return;
+    if (!sprrenderer.ready) _sprrenderer_setup();
+
+    _sprrenderer_sort();
+
+    // gather into the stream in sorted order
+    stream_range_t range;
+    sprite_instance_t* mapped = stream_map(sizeof(sprite_instance_t) * sprrenderer.count, 16, &range);
+    if (!mapped)
+    {
+        sprrenderer.count = 0;
+        return;
+    }
+
+    for (int i = 0; i < sprrenderer.count; i++)
+    {
+        mapped[i] = sprrenderer.instances[sprrenderer.order[i]];
+    }
+    stream_unmap();
+
+    choks_use_program(sprrenderer.shader.id);
+    choks_active_texture(GL_TEXTURE0);
+    choks_bind_vertex_array(sprrenderer.vao);
+    choks_bind_buffer(GL_ARRAY_BUFFER, range.buffer);
+
+    int depth_test = choks_is_enabled(GL_DEPTH_TEST);
+    choks_enable(GL_DEPTH_TEST, 0); // sprites in the same layer overlap at the same depth
+
+    // one draw per run of equal page + blend
+    int first = 0;
+    while (first < sprrenderer.count)
+    {
+        uint32_t key = sprrenderer.keys[first];
+        uint32_t state = key & 0xFFFF;
+
+        int last = first + 1;
+        while (last < sprrenderer.count && (sprrenderer.keys[last] & 0xFFFF) == state) last++;
+
+        size_t base = range.offset + sizeof(sprite_instance_t) * first;
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(sprite_instance_t), (void*) (base + offsetof(sprite_instance_t, x)));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(sprite_instance_t), (void*) (base + offsetof(sprite_instance_t, rotation)));
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(sprite_instance_t), (void*) (base + offsetof(sprite_instance_t, uv)));
+        glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(sprite_instance_t), (void*) (base + offsetof(sprite_instance_t, rgba)));
+
+        choks_bind_texture(GL_TEXTURE_2D, sprrenderer.pages[key & 0xFF].texture);
+
+        if (((key >> 8) & 0xFF) == REN2D_BLEND_ADDITIVE) choks_blend_func(GL_SRC_ALPHA, GL_ONE);
+        else choks_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0, last - first);
+
+        first = last;
+    }
+
+    choks_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (depth_test) choks_enable(GL_DEPTH_TEST, 1);
+
+    sprrenderer.count = 0;
+}
+
+// SPRITEFONTS
+// -----------
 spritefont_t spritefont_load_from_img(const char* path)
 {
     spritefont_t font = { 0 };
@@ -108,38 +543,120 @@ spritefont_t spritefont_load_from_img(const char* path)
 
 void spritefont_free(spritefont_t* this)
 {
+    // drop anything still queued for this font
+    for (int i = 0; i < REN2D_MAX_FONTS; i++)
+    {
+        if (sfrenderer.batches[i].font == this)
+        {
+            sfrenderer.batches[i].font = NULL;
+            sfrenderer.batches[i].count = 0;
+        }
+    }
+
     texture_free(this->texture);
 }
 
-// TODO: batched rendering for fonts + other optimizations
+static glyph_instance_t* _sfrenderer_reserve(spritefont_t* font, int count)
+{
+    int free_slot = -1;
+    for (int i = 0; i < REN2D_MAX_FONTS; i++)
+    {
+        if (sfrenderer.batches[i].font == font)
+        {
+            free_slot = i;
+            break;
+        }
+        if (free_slot < 0 && !sfrenderer.batches[i].font) free_slot = i;
+    }
+
+    if (free_slot < 0)
+    {
+        printf("too many fonts in flight (REN2D_MAX_FONTS)\n");
+        return NULL;
+    }
+
+    glyph_batch_t* batch = &sfrenderer.batches[free_slot];
+    batch->font = font;
+
+    if (batch->count + count > batch->capacity)
+    {
+        int capacity = batch->capacity ? batch->capacity : 256;
+        while (capacity < batch->count + count) capacity *= 2;
+
+        glyph_instance_t* glyphs = realloc(batch->glyphs, sizeof(glyph_instance_t) * capacity);
+        if (!glyphs) return NULL;
+
+        batch->glyphs = glyphs;
+        batch->capacity = capacity;
+    }
+
+    glyph_instance_t* reserved = batch->glyphs + batch->count;
+    batch->count += count;
+    return reserved;
+}
+
+// queues the text, it gets drawn at ren2d_flush()
 void draw_text_spritefont(spritefont_t* font, float scale, vec3_t rgb, const char* text, vec2_t pos)
 {
-    glUseProgram(sfrenderer.shader.id);
-    glUniform3fv(sfrenderer.uniforms.fg, 1, rgb.elements);
+    int length = strlen(text);
+    if (!length) return;
+
+    glyph_instance_t* glyphs = _sfrenderer_reserve(font, length);
+    if (!glyphs) return;
 
-    mat4_t model = HMM_Mat4d(1.0f);
-    model = HMM_MultiplyMat4(HMM_Scale((vec3_t){scale * font->charwidth, scale * font->charheight, 1.0f}), model);
-    model = HMM_MultiplyMat4(HMM_Translate((vec3_t) { pos.x, pos.y, 0.0f}), model);
+    unsigned char r = (unsigned char) (HMM_Clamp(0.0f, rgb.r, 1.0f) * 255.0f);
+    unsigned char g = (unsigned char) (HMM_Clamp(0.0f, rgb.g, 1.0f) * 255.0f);
+    unsigned char b = (unsigned char) (HMM_Clamp(0.0f, rgb.b, 1.0f) * 255.0f);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, font->texture.id);
-    glBindVertexArray(_quaddata.vao);
+    float advance = (float) font->charwidth * scale;
 
-    int i = 0;
-    while (text[i] != '\0')
+    for (int i = 0; i < length; i++)
     {
         // TODO: overflow handling
-        int index = text[i];
-        index %= 128;        
+        glyphs[i] = (glyph_instance_t) {
+            pos.x + advance * i, pos.y,
+            scale,
+            (unsigned char) text[i] % 128,
+            { r, g, b, 255 },
+        };
+    }
+}
+
+void ren2d_flush()
+{
+    _sprrenderer_flush();
+
+    if (!sfrenderer.ready) _sfrenderer_setup();
 
-        glUniform1i(sfrenderer.uniforms.charindex, index);
+    choks_use_program(sfrenderer.shader.id);
+    glUniform1i(sfrenderer.uniforms.font, 0);
 
-        glUniformMatrix4fv(sfrenderer.uniforms.model, 1, GL_FALSE, &model.elements[0][0]);
+    choks_active_texture(GL_TEXTURE0);
+    choks_bind_vertex_array(sfrenderer.vao);
 
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0);
+    for (int i = 0; i < REN2D_MAX_FONTS; i++)
+    {
+        glyph_batch_t* batch = &sfrenderer.batches[i];
+        if (!batch->font || !batch->count) continue;
 
-        model = HMM_MultiplyMat4(HMM_Translate((vec3_t) { (float) font->charwidth * scale, 0.0f, 0.0f}), model);
+        stream_range_t range = stream_upload(batch->glyphs, sizeof(glyph_instance_t) * batch->count, 16);
 
-        i++;
+        if (range.buffer)
+        {
+            choks_bind_buffer(GL_ARRAY_BUFFER, range.buffer);
+
+            size_t base = range.offset;
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glyph_instance_t), (void*) (base + offsetof(glyph_instance_t, x)));
+            glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(glyph_instance_t), (void*) (base + offsetof(glyph_instance_t, scale)));
+            glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(glyph_instance_t), (void*) (base + offsetof(glyph_instance_t, index)));
+            glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(glyph_instance_t), (void*) (base + offsetof(glyph_instance_t, rgba)));
+
+            glUniform2f(sfrenderer.uniforms.charsize, (float) batch->font->charwidth, (float) batch->font->charheight);
+            choks_bind_texture(GL_TEXTURE_2D, batch->font->texture.id);
+
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0, batch->count);
+        }
+
+        batch->count = 0;
     }
-}
\ No newline at end of file
+}
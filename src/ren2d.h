@@ -8,17 +8,31 @@
 extern void ren2d_init();
 extern void ren2d_cleanup();
 
+// sprites get packed into shared atlas pages when loaded, and draws are
+// batched until ren2d_flush() (one draw per atlas page + blend state).
+// lower layers are drawn first. inside a layer, order is only kept per page.
+#define REN2D_ATLAS_SIZE 2048
+#define REN2D_MAX_ATLAS_PAGES 8
+#define REN2D_MAX_ATLAS_SHELVES 128
+
+typedef enum
+{
+    REN2D_BLEND_ALPHA,
+    REN2D_BLEND_ADDITIVE,
+} ren2d_blend_t;
+
 typedef struct
 {
-    unsigned int id;
-    int width, height;  
+    int page; // -1 if not loaded
+    int width, height;
+    float u0, v0, u1, v1; // region of the atlas page
 } sprite_t;
 
-extern void sprite_load_from_file(const char* path);
+extern sprite_t sprite_load_from_file(const char* path);
 extern void sprite_unload(sprite_t* spr);
 
 extern void sprite_draw(sprite_t* spr, int x, int y);
-extern void sprite_draw_ex(sprite_t* spr, int x, int y);
+extern void sprite_draw_ex(sprite_t* spr, int x, int y, int layer, float rotation, vec2_t scale, vec4_t tint, ren2d_blend_t blend); // rotation in degrees around the center
 
 // temporary font drawing shitz
 typedef struct
@@ -31,4 +45,6 @@ typedef struct
 extern spritefont_t spritefont_load_from_img(const char* path);
 extern void spritefont_free(spritefont_t* this);
 
-extern void draw_text_spritefont(spritefont_t* font, float scale, vec3_t rgb, const char* text, vec2_t pos);
\ No newline at end of file
+extern void draw_text_spritefont(spritefont_t* font, float scale, vec3_t rgb, const char* text, vec2_t pos); // queued
+
+extern void ren2d_flush(); // draws everything queued this frame: sprites, then text (one draw per font)
\ No newline at end of file
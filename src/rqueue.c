@@ -0,0 +1,289 @@
+#include "rqueue.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+static struct
+{
+    rqueue_item_t* items;
+    int count, capacity;
+
+    // sort scratch, ping-ponged between passes
+    uint64_t *keys, *keys_swap;
+    uint32_t *order, *order_swap;
+
+    stream_range_t* blocks; // model block per sorted item, streamed before drawing
+
+    rqueue_stats_t stats;
+} rqueue;
+
+// positive floats compare the same as their bits
+static uint32_t _depth_bits(float depth)
+{
+    if (!(depth > 0.0f)) return 0; // behind the camera, or nan
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+static uint64_t _item_key(const rqueue_item_t* item)
+{
+    uint64_t key = (uint64_t) (item->transparent ? 1 : 0) << 63;
+    key |= (uint64_t) (item->layer & (RQUEUE_LAYERS - 1)) << 59;
+
+    uint64_t program = item->program, texture = item->texture, vao = item->primitive.vao;
+    uint32_t depth = _depth_bits(item->depth);
+
+    if (item->transparent)
+    {
+        key |= (uint64_t) (~depth) << 27; // far first
+        key |= (program & 0x1ff) << 18 | (texture & 0x1ff) << 9 | (vao & 0x1ff);
+    }
+    else
+    {
+        key |= (program & 0xffff) << 43 | (texture & 0xffff) << 27 | (vao & 0xffff) << 11;
+        key |= depth >> 20 & 0x7ff; // exponent + a bit of mantissa is plenty for rough front to back
+    }
+
+    return key;
+}
+
+void rqueue_submit(const rqueue_item_t* item)
+{
+    if (rqueue.count == rqueue.capacity)
+    {
+        rqueue.capacity = rqueue.capacity ? rqueue.capacity * 2 : 256;
+        rqueue.items = realloc(rqueue.items, sizeof(rqueue_item_t) * rqueue.capacity);
+        rqueue.keys = realloc(rqueue.keys, sizeof(uint64_t) * rqueue.capacity);
+        rqueue.keys_swap = realloc(rqueue.keys_swap, sizeof(uint64_t) * rqueue.capacity);
+        rqueue.order = realloc(rqueue.order, sizeof(uint32_t) * rqueue.capacity);
+        rqueue.order_swap = realloc(rqueue.order_swap, sizeof(uint32_t) * rqueue.capacity);
+        rqueue.blocks = realloc(rqueue.blocks, sizeof(stream_range_t) * rqueue.capacity);
+    }
+
+    rqueue.keys[rqueue.count] = _item_key(item);
+    rqueue.order[rqueue.count] = rqueue.count;
+    rqueue.items[rqueue.count++] = *item;
+}
+
+void rqueue_submit_callback(int layer, void (*callback)(void* user), void* user)
+{
+    rqueue_item_t item = { 0 };
+    item.layer = layer;
+    item.callback = callback;
+    item.user = user;
+    rqueue_submit(&item);
+}
+
+// lsd radix, a byte per pass. passes where every key has the same byte get skipped,
+// which with the layout above is most of them for a typical frame
+static void _radix_sort(int count)
+{
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int histogram[256] = { 0 };
+        for (int i = 0; i < count; i++) histogram[rqueue.keys[i] >> shift & 0xff]++;
+
+        if (histogram[rqueue.keys[0] >> shift & 0xff] == count) continue;
+
+        int offset = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            int n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            int slot = histogram[rqueue.keys[i] >> shift & 0xff]++;
+            rqueue.keys_swap[slot] = rqueue.keys[i];
+            rqueue.order_swap[slot] = rqueue.order[i];
+        }
+
+        uint64_t* keys = rqueue.keys;
+        rqueue.keys = rqueue.keys_swap;
+        rqueue.keys_swap = keys;
+
+        uint32_t* order = rqueue.order;
+        rqueue.order = rqueue.order_swap;
+        rqueue.order_swap = order;
+    }
+}
+
+typedef struct
+{
+    unsigned int program, texture, vao;
+    const mat4_t* transform;
+    const vertex_decode_t* decode;
+    float lod_fade;
+    int known; // 0 right after a callback, or at the start of a flush
+} rqueue_state_t;
+
+static int _transform_changed(const rqueue_state_t* state, const rqueue_item_t* item)
+{
+    return !state->known || memcmp(state->transform, &item->transform, sizeof(mat4_t)) || memcmp(state->decode, &item->primitive.decode, sizeof(vertex_decode_t)) || state->lod_fade != item->lod_fade;
+}
+
+// counts (and optionally applies) the changes needed to go from state to item. applying
+// needs the model block _stream_blocks wrote for it
+static int _transition(rqueue_state_t* state, const rqueue_item_t* item, rqueue_stats_t* stats, const stream_range_t* block)
+{
+    int apply = block != NULL;
+
+    if (item->callback)
+    {
+        if (apply) item->callback(item->user);
+        state->known = 0;
+        return 0;
+    }
+
+    int changes = 0;
+    if (!state->known || state->program != item->program)
+    {
+        if (apply) choks_use_program(item->program);
+        stats->program_changes += apply;
+        state->program = item->program;
+        changes++;
+    }
+    if (!state->known || state->texture != item->texture)
+    {
+        if (apply) choks_bind_texture(GL_TEXTURE_2D, item->texture);
+        stats->texture_changes += apply;
+        state->texture = item->texture;
+        changes++;
+    }
+    if (!state->known || state->vao != item->primitive.vao)
+    {
+        if (apply) choks_bind_vertex_array(item->primitive.vao);
+        stats->vao_changes += apply;
+        state->vao = item->primitive.vao;
+        changes++;
+    }
+    if (_transform_changed(state, item))
+    {
+        if (apply) set_model_block(*block, item->transform, item->primitive.decode, item->lod_fade);
+        stats->transform_changes += apply;
+        state->transform = &item->transform;
+        state->decode = &item->primitive.decode;
+        state->lod_fade = item->lod_fade;
+        changes++;
+    }
+
+    state->known = 1;
+    return changes;
+}
+
+// every transform the sorted queue will set goes into the stream before the first draw,
+// so without persistent mapping they reach the gpu in a single upload
+static void _stream_blocks()
+{
+    rqueue_state_t state = { 0 };
+
+    stream_batch_begin();
+    for (int i = 0; i < rqueue.count; i++)
+    {
+        const rqueue_item_t* item = &rqueue.items[rqueue.order[i]];
+        if (item->callback)
+        {
+            state.known = 0;
+            continue;
+        }
+
+        if (_transform_changed(&state, item))
+        {
+            rqueue.blocks[i] = stream_model_block(item->transform, item->primitive.decode, item->lod_fade);
+            state.transform = &item->transform;
+            state.decode = &item->primitive.decode;
+            state.lod_fade = item->lod_fade;
+        }
+        state.known = 1;
+    }
+    stream_batch_end();
+}
+
+void rqueue_flush()
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    rqueue_stats_t stats = { 0 };
+    stats.items = rqueue.count;
+
+    if (rqueue.count)
+    {
+        // the arena may have moved things around since they were submitted
+        for (int i = 0; i < rqueue.count; i++) primitive_locate(&rqueue.items[i].primitive);
+
+        // what it would have cost as submitted, just for the numbers
+        rqueue_state_t state = { 0 };
+        for (int i = 0; i < rqueue.count; i++) stats.unsorted_state_changes += _transition(&state, &rqueue.items[i], &stats, NULL);
+
+        _radix_sort(rqueue.count);
+        _stream_blocks();
+
+        state = (rqueue_state_t) { 0 };
+        int depth_writes = 1;
+        for (int i = 0; i < rqueue.count; i++)
+        {
+            const rqueue_item_t* item = &rqueue.items[rqueue.order[i]];
+            stats.state_changes += _transition(&state, item, &stats, &rqueue.blocks[i]);
+            if (item->callback) continue;
+
+            // sorted transparents still shouldnt hide each other
+            if (item->transparent && depth_writes)
+            {
+                choks_depth_mask(0);
+                depth_writes = 0;
+            }
+
+            const primitive_t* primitive = &item->primitive;
+            int instances = item->instances.count;
+            if (instances) instance_buffer_bind(&item->instances);
+
+            if (primitive->index_count)
+            {
+                int count = item->index_count ? item->index_count : primitive->index_count;
+                void* offset = primitive_index_offset(primitive, item->first_index);
+                if (instances) glDrawElementsInstancedBaseVertex(primitive->draw_mode, count, primitive->index_type, offset, instances, primitive->base_vertex);
+                else glDrawElementsBaseVertex(primitive->draw_mode, count, primitive->index_type, offset, primitive->base_vertex);
+            }
+            else
+            {
+                if (instances) glDrawArraysInstanced(primitive->draw_mode, primitive->base_vertex, primitive->vertex_count, instances);
+                else glDrawArrays(primitive->draw_mode, primitive->base_vertex, primitive->vertex_count);
+            }
+
+            if (instances) instance_buffer_unbind();
+            stats.instances += instances;
+            stats.draws++;
+        }
+
+        if (!depth_writes) choks_depth_mask(1);
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats.flush_ms = (end.tv_sec - start.tv_sec) * 1000.0f + (end.tv_nsec - start.tv_nsec) / 1000000.0f;
+
+    rqueue.stats = stats;
+    rqueue.count = 0;
+}
+
+rqueue_stats_t rqueue_stats()
+{
+    return rqueue.stats;
+}
+
+void rqueue_cleanup()
+{
+    free(rqueue.items);
+    free(rqueue.keys);
+    free(rqueue.keys_swap);
+    free(rqueue.order);
+    free(rqueue.order_swap);
+    free(rqueue.blocks);
+    memset(&rqueue, 0, sizeof(rqueue));
+}
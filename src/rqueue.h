@@ -0,0 +1,52 @@
+// render queue - everything 3d gets submitted here during the frame, rqueue_flush sorts
+// by a 64 bit key and draws it with as few state changes as it can.
+//
+// key, high to low:
+//   63     transparent (after every opaque item)
+//   62-59  layer
+//   opaque:      58-43 program, 42-27 texture, 26-11 vao, 10-0 depth (front to back)
+//   transparent: 58-27 depth (back to front), 26-0 program/texture/vao (9 bits each)
+#pragma once
+
+#include "turan_choks.h"
+
+#define RQUEUE_LAYERS 16
+#define RQUEUE_LAYER_SKY (RQUEUE_LAYERS - 1) // last opaque layer, after the world but before transparents
+
+typedef struct rqueue_item_s
+{
+    primitive_t primitive; // by value so the draw mode can differ per item
+    unsigned int program;
+    unsigned int texture; // GL_TEXTURE_2D on the active unit, 0 for none
+    mat4_t transform;
+
+    int first_index, index_count; // sub range of an indexed primitive, 0 count = everything
+    instance_buffer_t instances; // count > 0 draws every instance, transform applies to all of them
+    float lod_fade; // dithered lod transition, see lod_fade in upper_graphics.h. 0 for none
+
+    int layer; // 0 .. RQUEUE_LAYERS - 1, lower first
+    int transparent;
+    float depth; // distance from the camera
+
+    // custom draws (skybox etc), gl state is treated as unknown afterwards
+    void (*callback)(void* user);
+    void* user;
+} rqueue_item_t;
+
+typedef struct rqueue_stats_s
+{
+    int items, draws;
+    int instances; // drawn through instanced items
+    int program_changes, texture_changes, vao_changes, transform_changes;
+    int state_changes; // sum of the above
+    int unsorted_state_changes; // what submission order would have cost
+    float flush_ms; // cpu time, gpu work not included
+} rqueue_stats_t;
+
+extern void rqueue_submit(const rqueue_item_t* item);
+extern void rqueue_submit_callback(int layer, void (*callback)(void* user), void* user);
+
+extern void rqueue_flush(); // sort, draw, clear
+extern rqueue_stats_t rqueue_stats(); // of the last flush
+
+extern void rqueue_cleanup();
@@ -57,10 +57,10 @@ static float _rskybox_vertices[] = {
 static void rskybox_setup()
 {
     glGenVertexArrays(1, &_rskybox.vao);
-    glBindVertexArray(_rskybox.vao);
+    choks_bind_vertex_array(_rskybox.vao);
 
     glGenBuffers(1, &_rskybox.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, _rskybox.vbo);
+    choks_bind_buffer(GL_ARRAY_BUFFER, _rskybox.vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(_rskybox_vertices), _rskybox_vertices, GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
@@ -71,18 +71,18 @@ static void rskybox_setup()
 
 static void rskybox_cleanup()
 {
-    glDeleteBuffers(1, &_rskybox.vbo);
-    glDeleteVertexArrays(1, &_rskybox.vao);
+    choks_delete_buffer(_rskybox.vbo);
+    choks_delete_vertex_array(_rskybox.vao);
 
     program_free(_rskybox.shaderprog);
 }
 
 static void rskybox_render(texture_t tex)
 {
-    glDepthFunc(GL_LEQUAL);
-    glUseProgram(_rskybox.shaderprog.id);
-    glBindVertexArray(_rskybox.vao);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, tex.id);  		
+    choks_depth_func(GL_LEQUAL);
+    choks_use_program(_rskybox.shaderprog.id);
+    choks_bind_vertex_array(_rskybox.vao);
+    choks_bind_texture(GL_TEXTURE_CUBE_MAP, tex.id);  		
     glDrawArrays(GL_TRIANGLES, 0, 36);	 
-    glDepthFunc(GL_LESS);
+    choks_depth_func(GL_LESS);
 }
\ No newline at end of file
@@ -0,0 +1,331 @@
+// software lighting clustering algo - anaya khadka (c)
+// http://www.aortiz.me/2018/12/21/CG.html
+
+// this is for sub gl 4.3 compatible gpus where we cannot
+// take advantage of the compute shader functionality.
+
+// rendering pipeline:
+// 1. build cluster grid
+// 2. pre-pass into depth buffer
+// 3. find visible clusters
+// 4. reduce repeated instances
+// 5. light culling + cluster assignment
+// 6. shade
+
+#include "turan_choks.h"
+#include "upper_graphics.h"
+
+#include "lolita.h"
+#include "jobs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/* CONFIGURATION (KIM CONFIGURATION in lolita.h) */
+#define MAX_LIGHTS_IN_CLUSTER KIM_MAX_LIGHTS_IN_CLUSTER
+#define DEPTH_SLICE_COUNT KIM_DEPTH_SLICES
+#define HORIZONTAL_SLICE_COUNT KIM_HORIZONTAL_SLICES
+#define VERTICAL_SLICE_COUNT KIM_VERTICAL_SLICES
+#define CLUSTERS_PER_BLOCK 64 // unit of work for the job system, and of the light list prefix sum
+/* ============= */
+/* = CONSTANTS = */
+#define TOTAL_CLUSTER_COUNT KIM_CLUSTER_COUNT
+#define CLUSTER_BLOCK_COUNT ((TOTAL_CLUSTER_COUNT + CLUSTERS_PER_BLOCK - 1) / CLUSTERS_PER_BLOCK)
+#define CLUSTER_GRID_DIMENSIONS (vec3_t) { HORIZONTAL_SLICE_COUNT, VERTICAL_SLICE_COUNT, DEPTH_SLICE_COUNT, }
+/* CPU OPTIMIZ.. */
+// light vs cluster tests are spheres_touching_box (upper_graphics.c), sse2 or avx2 picked at runtime
+/* ============= */
+
+static vec4_t m128_to_vec4(__m128 val)
+{
+    return (vec4_t) { ._internal_sse = val };
+}
+
+// taken from handmade math 2.0
+static mat4_t _mat4_inverse(mat4_t in)
+{
+    vec3_t c01 = HMM_Cross(m128_to_vec4(in.columns[0]).xyz, m128_to_vec4(in.columns[1]).xyz);
+    vec3_t c23 = HMM_Cross(m128_to_vec4(in.columns[2]).xyz, m128_to_vec4(in.columns[3]).xyz);
+    vec3_t b10 = HMM_SubtractVec3(HMM_MultiplyVec3f(m128_to_vec4(in.columns[0]).xyz, m128_to_vec4(in.columns[1]).w), HMM_MultiplyVec3f(m128_to_vec4(in.columns[1]).xyz, m128_to_vec4(in.columns[0]).w));
+    vec3_t b32 = HMM_SubtractVec3(HMM_MultiplyVec3f(m128_to_vec4(in.columns[2]).xyz, m128_to_vec4(in.columns[3]).w), HMM_MultiplyVec3f(m128_to_vec4(in.columns[3]).xyz, m128_to_vec4(in.columns[2]).w));
+
+    float inv_determinant = 1.0f / (HMM_DotVec3(c01, b32) + HMM_DotVec3(c23, b10));
+    c01 = HMM_MultiplyVec3f(c01, inv_determinant);
+    c23 = HMM_MultiplyVec3f(c23, inv_determinant);
+    b10 = HMM_MultiplyVec3f(b10, inv_determinant);
+    b32 = HMM_MultiplyVec3f(b32, inv_determinant);
+
+    mat4_t result;
+    result.columns[0] = HMM_Vec4v(HMM_AddVec3(HMM_Cross(m128_to_vec4(in.columns[1]).xyz, b32), HMM_MultiplyVec3f(c23, m128_to_vec4(in.columns[1]).w)), -HMM_DotVec3(m128_to_vec4(in.columns[1]).xyz, c23))._internal_sse;
+    result.columns[1] = HMM_Vec4v(HMM_SubtractVec3(HMM_Cross(b32, m128_to_vec4(in.columns[0]).xyz), HMM_MultiplyVec3f(c23, m128_to_vec4(in.columns[0]).w)), +HMM_DotVec3(m128_to_vec4(in.columns[0]).xyz, c23))._internal_sse;
+    result.columns[2] = HMM_Vec4v(HMM_AddVec3(HMM_Cross(m128_to_vec4(in.columns[3]).xyz, b10), HMM_MultiplyVec3f(c01, m128_to_vec4(in.columns[3]).w)), -HMM_DotVec3(m128_to_vec4(in.columns[3]).xyz, c01))._internal_sse;
+    result.columns[3] = HMM_Vec4v(HMM_SubtractVec3(HMM_Cross(b10, m128_to_vec4(in.columns[2]).xyz), HMM_MultiplyVec3f(c01, m128_to_vec4(in.columns[2]).w)), +HMM_DotVec3(m128_to_vec4(in.columns[2]).xyz, c01))._internal_sse;
+
+    return HMM_Transpose(result); 
+}
+
+// viewspace aabbs, soa
+typedef struct cluster_bounds_s
+{
+    float min_x[TOTAL_CLUSTER_COUNT], min_y[TOTAL_CLUSTER_COUNT], min_z[TOTAL_CLUSTER_COUNT];
+    float max_x[TOTAL_CLUSTER_COUNT], max_y[TOTAL_CLUSTER_COUNT], max_z[TOTAL_CLUSTER_COUNT];
+} cluster_bounds_t;
+
+typedef struct cluster_light_reference_s
+{
+    int offset;
+    int length;
+} cluster_light_reference_t;
+
+// globals
+static cluster_bounds_t cluster_grid;
+static cluster_light_reference_t cluster_lights[TOTAL_CLUSTER_COUNT];
+
+static unsigned int global_light_index_list[TOTAL_CLUSTER_COUNT * MAX_LIGHTS_IN_CLUSTER];
+static int global_light_index_count = 0;
+
+// populate writes each cluster's lights to its own MAX_LIGHTS_IN_CLUSTER slots in here, then
+// they get packed into global_light_index_list at offsets from a prefix sum over the counts.
+// blocks are fixed, so the list comes out the same no matter how many threads ran it
+static unsigned int cluster_light_scratch[TOTAL_CLUSTER_COUNT * MAX_LIGHTS_IN_CLUSTER];
+static int block_light_offsets[CLUSTER_BLOCK_COUNT]; // block totals, then where each block starts
+
+// tiles cover the viewport exactly, so they arent square
+static const vec2_t screen_tile_size = { (float) CHOKS_WIDTH / HORIZONTAL_SLICE_COUNT, (float) CHOKS_HEIGHT / VERTICAL_SLICE_COUNT };
+
+// lights moved into viewspace once per frame, every cluster tests against these
+static sphere_set_t viewspace_lights;
+
+void cleanup_software_clustering()
+{
+    sphere_set_free(&viewspace_lights);
+}
+
+// pos is in pixels from the bottom left like gl_FragCoord, z/w in clip space
+static vec4_t _screenspace_to_viewspace(camera_t* cam, mat4_t inv_proj, vec4_t pos)
+{
+    vec2_t st = HMM_DivideVec2(pos.xy, (vec2_t) { CHOKS_WIDTH, CHOKS_HEIGHT });
+    
+    vec2_t clip_xy = HMM_SubtractVec2(HMM_MultiplyVec2f(st, 2.0), (vec2_t) { 1.0f, 1.0f });
+    vec4_t clip = HMM_Vec4(
+        clip_xy.x,
+        clip_xy.y,
+        pos.z,
+        pos.w
+    );
+
+    vec4_t viewspace_pos = HMM_MultiplyMat4ByVec4(inv_proj, clip);
+
+    viewspace_pos = HMM_DivideVec4f(viewspace_pos, viewspace_pos.w);
+    
+    return viewspace_pos;
+}
+
+static vec3_t _index_to_xyz(int index, vec3_t max)
+{
+    vec3_t xyz;
+
+    xyz.x = (float) (index % (int) max.x);
+    xyz.y = (float) ((index / (int) max.x) % (int) max.y);
+    xyz.z = (float) (index / ((int) max.x * (int) max.y));
+
+    return xyz;
+}
+
+// gets
+static vec3_t line_intersection_to_zplane(vec3_t a, vec3_t b, float z_distance)
+{
+    static const vec3_t normal = { 0.0f, 0.0f, 1.0f };
+    vec3_t ab = HMM_SubtractVec3(b, a);
+
+    float t = (z_distance - HMM_DotVec3(normal, a)) / HMM_DotVec3(normal, ab);
+
+    vec3_t result = HMM_AddVec3(a, HMM_MultiplyVec3f(ab, t));
+
+    return result;
+}
+
+typedef struct
+{
+    camera_t* camera;
+    mat4_t inverse_proj;
+} cluster_thread_input_t;
+
+// job system chunk: clusters [first_cluster_index, first_cluster_index + length)
+static void _thread_clustergen(void* ptr, int first_cluster_index, int length)
+{
+    // note: each chunk will never contact the same memory cells.
+
+    // for viewspace calcs.
+    static const vec3_t position = { 0.0f };
+
+    // get input (getting by value should be safer here but as long as we dont write we should be good)
+    cluster_thread_input_t input = *((cluster_thread_input_t*) ptr); // void* to cluster_thread_input_t* cast
+
+    for (int i = 0; i < length; i++) // loop through all clusters assigned to this chunk.
+                                     // this is basically what a single gpu thread would do
+                                     // for this function in the original article
+    {
+        int cluster_index = first_cluster_index + i;
+        vec3_t tile_coord = _index_to_xyz(cluster_index, CLUSTER_GRID_DIMENSIONS);
+
+        // screenspace
+        vec4_t max_point = HMM_Vec4((tile_coord.x + 1) * screen_tile_size.x, (tile_coord.y + 1) * screen_tile_size.y, -1.0f, 1.0f);
+        vec4_t min_point = HMM_Vec4(tile_coord.x * screen_tile_size.x, tile_coord.y * screen_tile_size.y, -1.0f, 1.0f);
+
+        // viewspace
+        vec3_t vs_max_point = _screenspace_to_viewspace(input.camera, input.inverse_proj, max_point).xyz;
+        vec3_t vs_min_point = _screenspace_to_viewspace(input.camera, input.inverse_proj, min_point).xyz;
+
+        // cluster near/far in viewspace
+        float cluster_near = -input.camera->near * powf(input.camera->far / input.camera->near, tile_coord.z / DEPTH_SLICE_COUNT);
+        float cluster_far = -input.camera->near * powf(input.camera->far / input.camera->near, (tile_coord.z + 1.0f) / DEPTH_SLICE_COUNT);
+
+        // calculate the aabb of this cluster grid cell
+        // the eye is the origin in viewspace, not the camera's world position
+        vec3_t corners[4] = {
+            line_intersection_to_zplane(position, vs_min_point, cluster_near),
+            line_intersection_to_zplane(position, vs_min_point, cluster_far),
+            line_intersection_to_zplane(position, vs_max_point, cluster_near),
+            line_intersection_to_zplane(position, vs_max_point, cluster_far),
+        };
+
+        vec3_t min_point_aabb = corners[0], max_point_aabb = corners[0];
+        for (int c = 1; c < 4; c++)
+        {
+            min_point_aabb = HMM_Vec3(HMM_MIN(min_point_aabb.x, corners[c].x), HMM_MIN(min_point_aabb.y, corners[c].y), HMM_MIN(min_point_aabb.z, corners[c].z));
+            max_point_aabb = HMM_Vec3(HMM_MAX(max_point_aabb.x, corners[c].x), HMM_MAX(max_point_aabb.y, corners[c].y), HMM_MAX(max_point_aabb.z, corners[c].z));
+        }
+
+        cluster_grid.min_x[cluster_index] = min_point_aabb.x;
+        cluster_grid.min_y[cluster_index] = min_point_aabb.y;
+        cluster_grid.min_z[cluster_index] = min_point_aabb.z;
+        cluster_grid.max_x[cluster_index] = max_point_aabb.x;
+        cluster_grid.max_y[cluster_index] = max_point_aabb.y;
+        cluster_grid.max_z[cluster_index] = max_point_aabb.z;
+    }
+}
+
+
+// this happens ONLY when the fov/znear/zfar changes.
+void software_generate_cluster_grid(camera_t* camera)
+{
+    // in this case using glReadPixels() is okay because the prepass is already done - meaning that 
+    // sync will NOT be an issue - HOORAY!
+    // however:
+    // we CANNOT take advantage of multiple threads with glReadPixels() i think it could work if the entire depth buffer was read to 
+    // a buffer here in cpuland in a previously malloced buffer and then performs operations
+    // simultaneously:
+    // this can introduce a memory issue as a depth buffer for a 1920x1080 render target would take up
+    // 1920px * 1080px * 1 float * 4 bytes/float = 8294400 bytes = 8.29 MB of ram usage for this portion of clustering alone
+
+    // parallelized (to the best of my efforts)
+    
+    // take advantage of our cpu depth_buffer
+    // glReadPixels(0, 0, CHOKS_WIDTH, CHOKS_HEIGHT, GL_DEPTH_COMPONENT, GL_FLOAT, (void*)depth_buffer);
+
+    cluster_thread_input_t input = { camera, _mat4_inverse(camera->matrices.projection) };
+
+    // pt. 1: initial cluster gen, split up by the job system. we help out until its done
+    job_counter_t done = { 0 };
+    job_parallel_for(_thread_clustergen, &input, TOTAL_CLUSTER_COUNT, CLUSTERS_PER_BLOCK, &done);
+    job_wait(&done);
+}
+
+// this function won't be as "smart" as the one from the article, but it'll probably
+// be quicker writing it this way on the CPU.
+// goal: iterate through every cluster
+static vec3_t _cluster_min(int cluster_index)
+{
+    return HMM_Vec3(cluster_grid.min_x[cluster_index], cluster_grid.min_y[cluster_index], cluster_grid.min_z[cluster_index]);
+}
+
+static vec3_t _cluster_max(int cluster_index)
+{
+    return HMM_Vec3(cluster_grid.max_x[cluster_index], cluster_grid.max_y[cluster_index], cluster_grid.max_z[cluster_index]);
+}
+
+// pass 1: every light against the aabb of each cluster in these blocks, a full cluster drops the rest
+static void _thread_clusterpop(void* ptr, int first_block, int block_count)
+{
+    for (int b = first_block; b < first_block + block_count; b++)
+    {
+        int first_cluster_index = b * CLUSTERS_PER_BLOCK;
+        int last_cluster_index = HMM_MIN(first_cluster_index + CLUSTERS_PER_BLOCK, TOTAL_CLUSTER_COUNT);
+
+        int block_total = 0;
+        for (int cluster_index = first_cluster_index; cluster_index < last_cluster_index; cluster_index++)
+        {
+            unsigned int* visible_light_indices = &cluster_light_scratch[cluster_index * MAX_LIGHTS_IN_CLUSTER];
+            int visible_light_count = spheres_touching_box(&viewspace_lights, _cluster_min(cluster_index), _cluster_max(cluster_index), visible_light_indices, MAX_LIGHTS_IN_CLUSTER);
+
+            cluster_lights[cluster_index].length = visible_light_count;
+            block_total += visible_light_count;
+        }
+
+        block_light_offsets[b] = block_total;
+    }
+}
+
+// pass 2: each block knows where it starts now, pack its clusters down in order
+static void _thread_clusterscatter(void* ptr, int first_block, int block_count)
+{
+    for (int b = first_block; b < first_block + block_count; b++)
+    {
+        int first_cluster_index = b * CLUSTERS_PER_BLOCK;
+        int last_cluster_index = HMM_MIN(first_cluster_index + CLUSTERS_PER_BLOCK, TOTAL_CLUSTER_COUNT);
+
+        int offset = block_light_offsets[b];
+        for (int cluster_index = first_cluster_index; cluster_index < last_cluster_index; cluster_index++)
+        {
+            int visible_light_count = cluster_lights[cluster_index].length;
+            memcpy(&global_light_index_list[offset], &cluster_light_scratch[cluster_index * MAX_LIGHTS_IN_CLUSTER], sizeof(unsigned int) * visible_light_count);
+
+            cluster_lights[cluster_index].offset = offset;
+            offset += visible_light_count;
+        }
+    }
+}
+
+void software_populate_cluster_grid(camera_t* camera, light_t* lights, int light_count) // per frame
+{
+    // into viewspace once here instead of once per cluster
+    sphere_set_clear(&viewspace_lights);
+    for (int i = 0; i < light_count; i++)
+    {
+        vec3_t center = HMM_MultiplyMat4ByVec4(camera->matrices.view, HMM_Vec4v(lights[i].position.xyz, 1.0f)).xyz;
+        sphere_set_add(&viewspace_lights, center, lights[i].strength);
+    }
+
+    // counts (+ the lights themselves into scratch)
+    job_counter_t counted = { 0 };
+    job_parallel_for(_thread_clusterpop, NULL, CLUSTER_BLOCK_COUNT, 1, &counted);
+    job_wait(&counted);
+
+    // exclusive scan over the block totals, only CLUSTER_BLOCK_COUNT of them so not worth splitting
+    global_light_index_count = 0;
+    for (int b = 0; b < CLUSTER_BLOCK_COUNT; b++)
+    {
+        int block_total = block_light_offsets[b];
+        block_light_offsets[b] = global_light_index_count;
+        global_light_index_count += block_total;
+    }
+
+    job_counter_t scattered = { 0 };
+    job_parallel_for(_thread_clusterscatter, NULL, CLUSTER_BLOCK_COUNT, 1, &scattered);
+    job_wait(&scattered);
+}
+
+// cluster (offset, count) pairs and the index list, for the texture buffers lolita binds.
+// orphaned every frame so the driver doesnt wait on last frame's draws
+void software_upload_cluster_grid(unsigned int clusters, unsigned int indices)
+{
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, clusters);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(cluster_lights), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(cluster_lights), cluster_lights);
+
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, indices);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(global_light_index_list), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(unsigned int) * global_light_index_count, global_light_index_list);
+}
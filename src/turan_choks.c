@@ -3,6 +3,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "ctex.h"
+#include "pack.h"
+#include "meshopt.h"
+#include "jobs.h"
 
 #define nil (void*)0
 
@@ -10,16 +24,176 @@ static struct choks_s
 {
     struct choks_mvp_s
     {
-        unsigned int ubo;
-
+        // last values set, re-streamed every frame so the bindings never point at recycled memory
         struct choks_mvp_data_s
         {
-            mat4_t model, view, proj;
+            mat4_t model;
+            vec4_t decode_scale, decode_bias; // rest of the mvp block, decode_scale.w is the lod fade
+            mat4_t view, proj;
         } data;
+
+        int model_bound, viewprojection_bound; // 0 forces the next set to stream + bind
     } mvp;
-    
+
+    struct choks_state_s
+    {
+        // CHOKS_STATE_UNKNOWN until set through the cache
+        unsigned int program, vao, active_unit;
+        unsigned int textures[CHOKS_STATE_TEXTURE_UNITS][2]; // 2d, cube map
+        unsigned int buffers[8]; // see _state_buffer_targets
+        struct choks_state_range_s
+        {
+            unsigned int buffer, offset, size;
+        } uniform_ranges[CHOKS_STATE_UNIFORM_BINDINGS];
+        int caps[5]; // see _state_caps, -1 unknown
+        unsigned int blend_source, blend_destination, depth_func;
+        int depth_mask; // -1 unknown
+        int viewport[4], viewport_known;
+
+        choks_state_stats_t frame, last_frame;
+    } state;
+
+    struct choks_stream_s
+    {
+        unsigned int buffer;
+
+        unsigned int segment; // which frame in flight we are writing to
+        unsigned int head; // offset within that segment
+        int uniform_alignment;
+
+        unsigned char* mapped; // the whole ring, persistently mapped. nil without GL_ARB_buffer_storage
+        unsigned char* shadow; // otherwise: cpu copy of the current segment
+        unsigned int dirty_begin, dirty_end; // part of the shadow that still has to go up
+        int batching;
+
+        GLsync fences[CHOKS_FRAMES_IN_FLIGHT];
+        unsigned int unfenced; // bit per segment given up early this frame, fenced at choks_end_frame
+    } stream;
+
+    struct choks_programs_s
+    {
+        int cache_usable;
+        uint64_t driver_hash; // vendor/renderer/version, binaries are useless across these
+
+        int parallel; // GL_KHR/ARB_parallel_shader_compile, lets us ask if a link is done without blocking
+
+        int batching;
+        int pending_count;
+        struct choks_pending_program_s
+        {
+            unsigned int id;
+            unsigned int vertex_shader, fragment_shader; // 0 when loaded from cache
+            uint64_t hash;
+        } pending[CHOKS_MAX_PENDING_PROGRAMS];
+
+        int loaded;
+        int cache_hits;
+        int cache_rejected;
+        double milliseconds;
+    } programs;
+
+    struct choks_assets_s
+    {
+        const unsigned char* pack; // the whole file, mapped
+        size_t pack_size;
+
+        const pack_entry_t* entries; // sorted by hash
+        uint32_t count;
+    } assets;
+
+    struct choks_textures_s
+    {
+        unsigned int placeholder; // 1x1 white
+        texture_t exhausted; // handed out when every slot is taken, stays on the placeholder
+
+        // reads + decodes run as background jobs (jobs.h), one per step
+        job_counter_t in_flight;
+        pthread_mutex_t mutex;
+
+        // job indices. each job is in at most one queue at a time so this never overflows
+        struct choks_job_queue_s
+        {
+            int items[CHOKS_MAX_ASYNC_TEXTURES];
+            int head, count;
+        } done; // job system -> render thread
+
+        int uploading[CHOKS_MAX_ASYNC_TEXTURES]; // render thread only
+        int uploading_count;
+
+        struct choks_texture_job_s
+        {
+            enum
+            {
+                CHOKS_ASYNC_FREE,
+                CHOKS_ASYNC_READ, // worker: read file + header
+                CHOKS_ASYNC_NEEDS_BUFFER, // render thread: map a pbo
+                CHOKS_ASYNC_DECODE, // worker: decode into the pbo
+                CHOKS_ASYNC_DECODED, // render thread: upload
+                CHOKS_ASYNC_UPLOADING,
+                CHOKS_ASYNC_DONE,
+                CHOKS_ASYNC_FAILED,
+            } state;
+            int released; // texture_async_free was called while in flight
+            int busy; // render thread only: a worker has it, or its sitting in done. dont touch anything else while set
+
+            texture_t texture; // the handle we give out
+            char path[256];
+
+            asset_t file; // webp, or the .ctex when cooked
+            int cooked;
+
+            int width, height;
+            int levels;
+            uint32_t level_offsets[CTEX_MAX_LEVELS]; // within the pbo
+            size_t buffer_size;
+
+            unsigned int pbo;
+            void* mapped;
+            unsigned int real_id;
+            int level, rows_uploaded;
+        } jobs[CHOKS_MAX_ASYNC_TEXTURES];
+    } textures;
+
+    struct choks_arena_s
+    {
+        struct choks_arena_block_s
+        {
+            unsigned int vao, vbo, ibo;
+            vertex_layout_t layout;
+            int stride;
+            int vertex_capacity, index_capacity;
+
+            struct choks_range_list_s
+            {
+                struct choks_range_s
+                {
+                    int offset, size;
+                } *ranges; // free space, sorted by offset, never touching
+                int count, capacity;
+            } free_vertices, free_indices;
+        } *blocks;
+        int block_count;
+
+        struct choks_allocation_s
+        {
+            int block; // -1 when unused
+            int first_vertex, vertex_count;
+            int first_index, index_count; // 4 byte slots
+            int next_free;
+        } *allocations;
+        int allocation_count, allocation_capacity;
+        int free_allocation; // unused slot chain, -1 for none
+        int live;
+    } arena;
 } choks;
 
+static void _assets_mount();
+static void _assets_unmount();
+static void _texture_async_setup();
+static void _texture_async_cleanup();
+static void _arena_cleanup();
+static void _texture_async_update();
+
 static void _dbgprintf(const char* file, const char* func, int line, const char* fmt, ...)
 {
     va_list args;
@@ -35,440 +209,2562 @@ static void _dbgprintf(const char* file, const char* func, int line, const char*
 #define choks_debug_printf(x, ...)
 #endif
 
-// setup/cleanup
-// -------------
-void setup_choks()
+static double _time_ms()
 {
-    // initialize mvp ubo + data
-    choks.mvp.data = (struct choks_mvp_data_s){
-        HMM_Mat4d(1.0f),
-        HMM_Mat4d(1.0f),
-        HMM_Mat4d(1.0f),
-    };
-
-    glGenBuffers(1, &choks.mvp.ubo);
-
-    glBindBuffer(GL_UNIFORM_BUFFER, choks.mvp.ubo);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(struct choks_mvp_data_s), (void*) &choks.mvp.data, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 0, choks.mvp.ubo);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
 
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+// fnv-1a, good enough for cache keys
+static uint64_t _hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
 }
 
-void cleanup_choks()
+static uint64_t _hash_string(uint64_t hash, const char* string)
 {
-    glDeleteBuffers(1, &choks.mvp.ubo);
+    if (!string) string = "";
+    return _hash_bytes(hash, string, strlen(string) + 1); // include the terminator so "ab"+"c" != "a"+"bc"
 }
 
+// GL STATE CACHE
+// --------------
+#define CHOKS_STATE_UNKNOWN 0xFFFFFFFFu
+
+static const unsigned int _state_buffer_targets[8][2] = {
+    { GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING },
+    { GL_ELEMENT_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER_BINDING }, // part of the vao, forgotten on vao changes
+    { GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING },
+    { GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER }, // the target doubles as the binding query
+    { GL_COPY_WRITE_BUFFER, GL_COPY_WRITE_BUFFER },
+    { GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_UNPACK_BUFFER_BINDING },
+    { GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING },
+    { GL_DRAW_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER_BINDING },
+};
+
+static const unsigned int _state_caps[5] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST };
+
+#if CHOKS_STATE_VALIDATE
+#define _state_check() choks_state_validate()
+#else
+#define _state_check()
+#endif
 
-// state machine :D
-// ----------------
-// mvp:
-void set_model_matrix(mat4_t model)
+// 1 if the call has to go through
+static int _state_set(unsigned int* shadow, unsigned int value)
 {
-    glBindBuffer(GL_UNIFORM_BUFFER, choks.mvp.ubo);
-    glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr) 0, sizeof(mat4_t), &model);
+    if (*shadow == value)
+    {
+        choks.state.frame.elided++;
+        return 0;
+    }
+
+    *shadow = value;
+    choks.state.frame.issued++;
+    return 1;
 }
 
-void set_view_and_projection_matrices(mat4_t view, mat4_t projection)
+static int _state_buffer_slot(unsigned int target)
 {
-    glBindBuffer(GL_UNIFORM_BUFFER, choks.mvp.ubo);
-    glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr) sizeof(mat4_t), sizeof(mat4_t), &view.elements[0][0]);
-    glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr) sizeof(mat4_t) * 2, sizeof(mat4_t), &projection.elements[0][0]);
+    for (int i = 0; i < 8; i++)
+    {
+        if (_state_buffer_targets[i][0] == target) return i;
+    }
+    return -1;
 }
 
-// PRIMITIVES
-// ----------
-static void _setup_vao_attr()
+static unsigned int* _state_texture_shadow(unsigned int target)
 {
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, nil);
-    glEnableVertexAttribArray(0);
+    int kind = target == GL_TEXTURE_2D ? 0 : target == GL_TEXTURE_CUBE_MAP ? 1 : -1;
+    unsigned int unit = choks.state.active_unit;
+    if (kind < 0 || unit == CHOKS_STATE_UNKNOWN || unit >= CHOKS_STATE_TEXTURE_UNITS) return nil;
 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_TRUE, sizeof(float) * 5, (void*) (sizeof(float)*3));
-    glEnableVertexAttribArray(1); 
+    return &choks.state.textures[unit][kind];
 }
 
-primitive_t primitive_load(float* data, int vertex_count, int draw_mode) // vertex: xyzst.
+void choks_use_program(unsigned int program)
 {
-    primitive_t this;    
-    this.vertex_count = vertex_count;
-    this.draw_mode = draw_mode;
+    if (_state_set(&choks.state.program, program)) glUseProgram(program);
+    _state_check();
+}
 
-    glGenVertexArrays(1, &this.vao);
-    glBindVertexArray(this.vao);
+void choks_bind_vertex_array(unsigned int vao)
+{
+    if (_state_set(&choks.state.vao, vao))
+    {
+        glBindVertexArray(vao);
+        choks.state.buffers[1] = CHOKS_STATE_UNKNOWN;
+    }
+    _state_check();
+}
 
-    glGenBuffers(1, &this.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this.vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 5 * vertex_count, (const void*) data, GL_STATIC_DRAW);
+void choks_active_texture(unsigned int unit)
+{
+    if (_state_set(&choks.state.active_unit, unit - GL_TEXTURE0)) glActiveTexture(unit);
+    _state_check();
+}
 
-    _setup_vao_attr();
-    
-    this.ibo = 0;
+void choks_bind_texture(unsigned int target, unsigned int texture)
+{
+    unsigned int* shadow = _state_texture_shadow(target);
+    if (!shadow)
+    {
+        choks.state.frame.issued++;
+        glBindTexture(target, texture);
+        return;
+    }
 
-    return this;
+    if (_state_set(shadow, texture)) glBindTexture(target, texture);
+    _state_check();
 }
 
-primitive_t primitive_load_with_indices(float* vertices, int vertex_count, unsigned int* indices, int index_count, int draw_mode)
+void choks_bind_buffer(unsigned int target, unsigned int buffer)
 {
-    primitive_t this;    
-    this.vertex_count = vertex_count;
-    this.index_count = index_count;
-    this.draw_mode = draw_mode;
+    int slot = _state_buffer_slot(target);
+    if (slot < 0)
+    {
+        choks.state.frame.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
 
-    glGenVertexArrays(1, &this.vao);
-    glBindVertexArray(this.vao);
+    if (_state_set(&choks.state.buffers[slot], buffer)) glBindBuffer(target, buffer);
+    _state_check();
+}
 
-    glGenBuffers(1, &this.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this.vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 5 * vertex_count, (const void*) vertices, GL_STATIC_DRAW);
+void choks_bind_buffer_range(unsigned int target, unsigned int index, unsigned int buffer, unsigned int offset, unsigned int size)
+{
+    if (target != GL_UNIFORM_BUFFER || index >= CHOKS_STATE_UNIFORM_BINDINGS)
+    {
+        choks.state.frame.issued++;
+        glBindBufferRange(target, index, buffer, offset, size);
+        choks.state.buffers[_state_buffer_slot(GL_UNIFORM_BUFFER)] = CHOKS_STATE_UNKNOWN;
+        return;
+    }
 
-    glGenBuffers(1, &this.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * this.index_count, indices, GL_STATIC_DRAW);
+    struct choks_state_range_s* range = &choks.state.uniform_ranges[index];
+    if (range->buffer == buffer && range->offset == offset && range->size == size)
+    {
+        choks.state.frame.elided++;
+        return;
+    }
 
-    _setup_vao_attr();
+    *range = (struct choks_state_range_s) { buffer, offset, size };
+    choks.state.frame.issued++;
+    glBindBufferRange(target, index, buffer, offset, size);
+    choks.state.buffers[_state_buffer_slot(GL_UNIFORM_BUFFER)] = buffer; // also sets the generic binding
 
-    return this;
+    _state_check();
 }
 
-void primitive_free(primitive_t* this)
+void choks_enable(unsigned int cap, int enabled)
 {
-    glDeleteBuffers(1, &this->ibo);
-    glDeleteBuffers(1, &this->vbo);
-    glDeleteVertexArrays(1, &this->vao);
+    enabled = !!enabled;
+    for (int i = 0; i < 5; i++)
+    {
+        if (_state_caps[i] != cap) continue;
+
+        if (choks.state.caps[i] == enabled)
+        {
+            choks.state.frame.elided++;
+            return;
+        }
+        choks.state.caps[i] = enabled;
+        break;
+    }
+
+    choks.state.frame.issued++;
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+
+    _state_check();
 }
 
-// DEPRECATED ---------------------------------------------------------------------------------
-#if 0
-void primitive_attach_indices(primitive_t* this, unsigned int* data, int index_count) // unused
+int choks_is_enabled(unsigned int cap)
 {
-    this->index_count = index_count;
+    for (int i = 0; i < 5; i++)
+    {
+        if (_state_caps[i] != cap) continue;
 
-    glBindVertexArray(this->vao);
-    glGenBuffers(1, &this->ibo);
+        // only asks gl when the cache doesnt know yet (after choks_state_invalidate)
+        if (choks.state.caps[i] < 0) choks.state.caps[i] = glIsEnabled(cap) ? 1 : 0;
+        return choks.state.caps[i];
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * this->vertex_count, data, GL_STATIC_DRAW);
+    return glIsEnabled(cap); // not cached
 }
-#endif
 
-void primitive_draw(primitive_t* this)
+void choks_blend_func(unsigned int source, unsigned int destination)
 {
-    glBindVertexArray(this->vao);
-
-    if (this->ibo)
+    if (choks.state.blend_source == source && choks.state.blend_destination == destination)
     {
-        glDrawElements(this->draw_mode, this->index_count, GL_UNSIGNED_INT, nil);
+        choks.state.frame.elided++;
         return;
     }
 
-    glDrawArrays(this->draw_mode, 0, this->vertex_count);
+    choks.state.blend_source = source;
+    choks.state.blend_destination = destination;
+    choks.state.frame.issued++;
+    glBlendFunc(source, destination);
+
+    _state_check();
 }
 
-// PROGRAMS
-// --------
-static char* slurp(const char* path) // ALL GOOD
+void choks_depth_func(unsigned int func)
 {
-    char* buffer = 0;
-    size_t length;
-    FILE* f = fopen(path, "r");
+    if (_state_set(&choks.state.depth_func, func)) glDepthFunc(func);
+    _state_check();
+}
 
-    if (f)
+void choks_depth_mask(int write)
+{
+    write = !!write;
+    if (choks.state.depth_mask == write)
     {
-        fseek(f, 0L, SEEK_END);
-        length = ftell(f);
-        fseek(f, 0, SEEK_SET);
-        buffer = malloc(length);
+        choks.state.frame.elided++;
+        return;
+    }
 
-        if (buffer)
-        {
-            size_t new_size = fread(buffer, 1, length, f);
-            buffer[new_size] = '\0'; // FOR SAFETY
-        }
+    choks.state.depth_mask = write;
+    choks.state.frame.issued++;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
 
-        fclose(f);
+    _state_check();
+}
+
+void choks_viewport(int x, int y, int width, int height)
+{
+    int* viewport = choks.state.viewport;
+    if (choks.state.viewport_known && viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height)
+    {
+        choks.state.frame.elided++;
+        return;
     }
 
-    return buffer;
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+    choks.state.viewport_known = 1;
+    choks.state.frame.issued++;
+    glViewport(x, y, width, height);
+
+    _state_check();
 }
 
-static void validate_shader(int id)
+void choks_delete_program(unsigned int program)
 {
-    int successful;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &successful);
-    if (!successful) {
-        static char log[512];
-        glGetShaderInfoLog(id, 512, NULL, log);
-        printf("%s\n", log);
-    }
+    // the current program stays in use until something else is, but its name can come back
+    if (choks.state.program == program) choks.state.program = CHOKS_STATE_UNKNOWN;
+    glDeleteProgram(program);
 }
 
-program_t program_load_from_files(const char* vertex_shader_path, const char* fragment_shader_path)
+void choks_delete_vertex_array(unsigned int vao)
 {
-    char* vertex_source = slurp(vertex_shader_path);
-    char* fragment_source = slurp(fragment_shader_path);
+    if (choks.state.vao == vao)
+    {
+        choks.state.vao = 0;
+        choks.state.buffers[1] = CHOKS_STATE_UNKNOWN;
+    }
+    glDeleteVertexArrays(1, &vao);
+}
 
-    // printf("%s (vertex):\n%s\n%s (fragment):\n%s\n", vertex_shader_path, vertex_source, fragment_shader_path, fragment_source);
+void choks_delete_buffer(unsigned int buffer)
+{
+    // gl unbinds it everywhere it was bound
+    for (int i = 0; i < 8; i++)
+    {
+        if (choks.state.buffers[i] == buffer) choks.state.buffers[i] = 0;
+    }
+    for (int i = 0; i < CHOKS_STATE_UNIFORM_BINDINGS; i++)
+    {
+        if (choks.state.uniform_ranges[i].buffer == buffer) choks.state.uniform_ranges[i] = (struct choks_state_range_s) { 0, 0, 0 };
+    }
+    glDeleteBuffers(1, &buffer);
+}
 
-    if (!vertex_source || !fragment_source)
+void choks_delete_texture(unsigned int texture)
+{
+    for (int unit = 0; unit < CHOKS_STATE_TEXTURE_UNITS; unit++)
     {
-        choks_debug_printf("program source paths not valid.\n");
-        return (program_t) { 0 }; // invalid program
+        for (int kind = 0; kind < 2; kind++)
+        {
+            if (choks.state.textures[unit][kind] == texture) choks.state.textures[unit][kind] = 0;
+        }
     }
+    glDeleteTextures(1, &texture);
+}
 
-    program_t this = program_load_from_source(vertex_source, fragment_source);
+void choks_state_invalidate()
+{
+    struct choks_state_s* state = &choks.state;
+    state->program = state->vao = state->active_unit = CHOKS_STATE_UNKNOWN;
+    memset(state->textures, 0xFF, sizeof(state->textures));
+    memset(state->buffers, 0xFF, sizeof(state->buffers));
+    memset(state->uniform_ranges, 0xFF, sizeof(state->uniform_ranges));
+    for (int i = 0; i < 5; i++) state->caps[i] = -1;
+    state->blend_source = state->blend_destination = state->depth_func = CHOKS_STATE_UNKNOWN;
+    state->depth_mask = -1;
+    state->viewport_known = 0;
+}
 
-    free(vertex_source);
-    free(fragment_source);
+static int _state_compare(const char* what, int index, unsigned int shadow, int actual)
+{
+    if (shadow == CHOKS_STATE_UNKNOWN || shadow == (unsigned int) actual) return 0;
 
-    return this;
+    choks_debug_printf("state cache out of sync: %s[%i] is %i, cache thinks %u\n", what, index, actual, shadow);
+    return 1;
 }
 
-program_t program_load_from_source(const char* vertex_source, const char* fragment_source)
+int choks_state_validate()
 {
-    program_t this; // put a finger down if you can squirt.....
-    this.id = glCreateProgram();
+    struct choks_state_s* state = &choks.state;
+    int mismatches = 0, value;
 
-    // printf("vertex:\n%s\nfragment:\n%s\n", vertex_source, fragment_source);
-
-    int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &vertex_source, nil);
-    glCompileShader(vertex_shader);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+    mismatches += _state_compare("program", 0, state->program, value);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+    mismatches += _state_compare("vao", 0, state->vao, value);
 
-    #if CHOKS_DEBUG
-    choks_debug_printf("vert debug:\n");
-    validate_shader(vertex_shader);
-    #endif
+    for (int i = 0; i < 8; i++)
+    {
+        glGetIntegerv(_state_buffer_targets[i][1], &value);
+        mismatches += _state_compare("buffer", i, state->buffers[i], value);
+    }
 
-    glAttachShader(this.id, vertex_shader);
+    for (int i = 0; i < CHOKS_STATE_UNIFORM_BINDINGS; i++)
+    {
+        if (state->uniform_ranges[i].buffer == CHOKS_STATE_UNKNOWN) continue;
+
+        GLint64 offset, size;
+        glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &value);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_START, i, &offset);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, i, &size);
+        mismatches += _state_compare("uniform range buffer", i, state->uniform_ranges[i].buffer, value);
+        mismatches += _state_compare("uniform range offset", i, state->uniform_ranges[i].offset, (int) offset);
+        mismatches += _state_compare("uniform range size", i, state->uniform_ranges[i].size, (int) size);
+    }
 
-    int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 1, &fragment_source, nil);
-    glCompileShader(fragment_shader);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+    int active = value;
+    mismatches += _state_compare("active texture unit", 0, state->active_unit, value - GL_TEXTURE0);
 
-    #if CHOKS_DEBUG
-    choks_debug_printf("frag debug:\n");
-    validate_shader(fragment_shader);
-    #endif
+    for (int unit = 0; unit < CHOKS_STATE_TEXTURE_UNITS; unit++)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+        mismatches += _state_compare("texture 2d", unit, state->textures[unit][0], value);
+        glGetIntegerv(GL_TEXTURE_BINDING_CUBE_MAP, &value);
+        mismatches += _state_compare("texture cube map", unit, state->textures[unit][1], value);
+    }
+    glActiveTexture(active);
 
-    glAttachShader(this.id, fragment_shader);
+    for (int i = 0; i < 5; i++)
+    {
+        if (state->caps[i] < 0) continue;
+        mismatches += _state_compare("enabled", i, state->caps[i], glIsEnabled(_state_caps[i]));
+    }
 
-    glLinkProgram(this.id);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &value);
+    mismatches += _state_compare("blend source", 0, state->blend_source, value);
+    glGetIntegerv(GL_BLEND_DST_RGB, &value);
+    mismatches += _state_compare("blend destination", 0, state->blend_destination, value);
+    glGetIntegerv(GL_DEPTH_FUNC, &value);
+    mismatches += _state_compare("depth func", 0, state->depth_func, value);
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+    GLboolean mask;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &mask);
+    if (state->depth_mask >= 0) mismatches += _state_compare("depth mask", 0, state->depth_mask, mask);
 
-    #if CHOKS_DEBUG
-    int successful;
-    glGetProgramiv(this.id, GL_LINK_STATUS, &successful);
-    if (!successful) {
-        static char log[512];
-        glGetProgramInfoLog(this.id, 512, NULL, log);
-        printf("%s\n", log);
+    if (state->viewport_known)
+    {
+        int viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        for (int i = 0; i < 4; i++) mismatches += _state_compare("viewport", i, state->viewport[i], viewport[i]);
     }
-    choks_debug_printf("program success!!!\n");
-    #endif
 
-    // bind uniform block.
-    glUniformBlockBinding(this.id, glGetUniformBlockIndex(this.id, "mvp"), 0);
-
-    return this;
+    return mismatches;
 }
 
-void program_free(program_t this)
+choks_state_stats_t choks_state_stats()
 {
-    glDeleteProgram(this.id);
+    return choks.state.last_frame;
 }
 
-// TEXTURES
-// --------
-// i think for this one ill be sticking to .webp
-#include <webp/decode.h>
-#include <webp/demux.h>
-
-static char* slurp_bytes(const char* path, size_t* size) // ALL GOOD (no mem err)
+// setup/cleanup
+// -------------
+void setup_choks()
 {
-    char* buffer = 0;
-    size_t length;
-    FILE* f = fopen (path, "rb");
+    jobs_setup();
 
-    if (f)
+    choks_state_invalidate();
+    _assets_mount();
+
+    choks.arena.free_allocation = -1;
+
+    // setup streaming ring
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &choks.stream.uniform_alignment);
+
+    glGenBuffers(1, &choks.stream.buffer);
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, choks.stream.buffer);
+
+    #if CHOKS_STREAM_PERSISTENT
+    if (GLAD_GL_ARB_buffer_storage)
     {
-        fseek(f, 0, SEEK_END);
-        length = ftell(f);
-        fseek(f, 0, SEEK_SET);
-        buffer = malloc(length);
+        // coherent, so writes are visible to anything issued after them without a flush
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, CHOKS_STREAM_SIZE * CHOKS_FRAMES_IN_FLIGHT, nil, flags);
+        choks.stream.mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, CHOKS_STREAM_SIZE * CHOKS_FRAMES_IN_FLIGHT, flags);
 
-        if (buffer)
+        if (!choks.stream.mapped)
         {
-            size_t new_size = fread(buffer, 1, length, f);
-            *size = new_size;
+            // storage is immutable, the fallback needs a fresh buffer
+            choks_debug_printf("couldnt map the stream ring persistently, using the cpu copy.\n");
+            choks_delete_buffer(choks.stream.buffer);
+            glGenBuffers(1, &choks.stream.buffer);
+            choks_bind_buffer(GL_COPY_WRITE_BUFFER, choks.stream.buffer);
         }
-        fclose (f);
     }
+    #endif
 
-    return buffer;
-}
-
-texture_t texture_load_2d_from_file(const char* path)
-{
-    texture_t this = { 0 };
-    this.type = CHOKS_TEXTURETYPE_2D;
-
-    size_t size;
-    const uint8_t* data = (uint8_t*) slurp_bytes(path, &size);
-
-    if (data)
+    if (!choks.stream.mapped)
     {
-        // use webp decode to load img and flip it
-        WebPDecoderConfig config;
-        WebPInitDecoderConfig(&config);
-        config.output.colorspace = MODE_RGBA;
+        glBufferData(GL_COPY_WRITE_BUFFER, CHOKS_STREAM_SIZE * CHOKS_FRAMES_IN_FLIGHT, nil, GL_STREAM_DRAW);
+        choks.stream.shadow = malloc(CHOKS_STREAM_SIZE);
+    }
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, 0);
 
-        config.options.flip = 1;
+    choks.stream.segment = 0;
+    choks.stream.head = 0;
 
-        WebPDecode(data, size, &config);
+    // program binary cache is only worth it if the driver actually hands out binaries
+    #if CHOKS_PROGRAM_CACHE
+    int binary_formats = 0;
+    if (GLAD_GL_ARB_get_program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
 
-        if (!config.output.private_memory)
-        {
-            choks_debug_printf("failed to parse %s (not webp?)\n", path);
-            free((void*) data);
-            return this;
-        }
+    choks.programs.cache_usable = binary_formats > 0;
+    if (choks.programs.cache_usable)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        hash = _hash_string(hash, (const char*) glGetString(GL_VENDOR));
+        hash = _hash_string(hash, (const char*) glGetString(GL_RENDERER));
+        hash = _hash_string(hash, (const char*) glGetString(GL_VERSION));
+        choks.programs.driver_hash = hash;
 
-        // A.O.K. proceed to load to gl
-        this.width = config.output.width;
-        this.height = config.output.height;
-
-        glGenTextures(1, &this.id);
-        glBindTexture(GL_TEXTURE_2D, this.id);
-
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RGBA,
-            this.width,
-            this.height,
-            0,
-            GL_RGBA,
-            GL_UNSIGNED_BYTE,
-            config.output.private_memory
-        );
-
-        // image configs TODO: make these texture filtering settings configurable etc. etc.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        mkdir(CHOKS_PROGRAM_CACHE_DIR, 0755);
+    }
+    else choks_debug_printf("program binaries not supported, program cache disabled.\n");
+    #endif
 
-        WebPFreeDecBuffer(&config.output);
+    // let the driver compile on its own threads if it can
+    if (GLAD_GL_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // implementation maximum
+        choks.programs.parallel = 1;
     }
-    else
+    else if (GLAD_GL_ARB_parallel_shader_compile)
     {
-        choks_debug_printf("invalid file\n");
-        return this;
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        choks.programs.parallel = 1;
     }
 
-    free((void*)data);
-    return this;
-}
+    // initialize mvp data
+    choks.mvp.data = (struct choks_mvp_data_s){
+        HMM_Mat4d(1.0f),
+        HMM_Vec4(1.0f, 1.0f, 1.0f, 0.0f),
+        HMM_Vec4(0.0f, 0.0f, 0.0f, 0.0f),
+        HMM_Mat4d(1.0f),
+        HMM_Mat4d(1.0f),
+    };
 
+    set_model_matrix(choks.mvp.data.model);
+    set_view_and_projection_matrices(choks.mvp.data.view, choks.mvp.data.proj);
 
-texture_t texture_load_cubemap_from_file(const char* path)
+    // disabled attributes read these, so non instanced draws get an identity instance_model
+    for (int i = 0; i < 4; i++) glVertexAttrib4f(CHOKS_ATTRIB_INSTANCE_MODEL + i, i == 0, i == 1, i == 2, i == 3);
+
+    // and layouts without normals/colors get up and white
+    glVertexAttrib4f(VERTEX_NORMAL, 0.0f, 1.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(VERTEX_COLOR, 1.0f, 1.0f, 1.0f, 1.0f);
+
+    _texture_async_setup();
+}
+
+void cleanup_choks()
 {
-    texture_t this = { 0 };
-    this.type = CHOKS_TEXTURETYPE_CUBEMAP;
-    
-    // load image
-    size_t size;
-    const uint8_t* data = (uint8_t*) slurp_bytes(path, &size);
+    _texture_async_cleanup();
+    _arena_cleanup();
 
-    if (data)
+    for (int i = 0; i < CHOKS_FRAMES_IN_FLIGHT; i++)
     {
-        choks_debug_printf("loaded file %s, size %i\n", path, size);
+        if (choks.stream.fences[i]) glDeleteSync(choks.stream.fences[i]);
+        choks.stream.fences[i] = 0;
+    }
+    choks.stream.unfenced = 0;
 
-        WebPData webp_data = { data, size };
+    if (choks.stream.mapped)
+    {
+        choks_bind_buffer(GL_COPY_WRITE_BUFFER, choks.stream.buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        choks.stream.mapped = nil;
+    }
+    free(choks.stream.shadow);
+    choks.stream.shadow = nil;
 
-        WebPAnimDecoderOptions decoder_options;
-        WebPAnimDecoderOptionsInit(&decoder_options);
+    choks_delete_buffer(choks.stream.buffer);
 
-        WebPAnimDecoder* decoder = WebPAnimDecoderNew(&webp_data, &decoder_options);
+    _assets_unmount();
+    jobs_cleanup();
+}
 
-        int valid = 1;
-    
-        if (!decoder)
-        {
-            choks_debug_printf("animation decoder did not parse webp.\n");
-            valid = 0;
-        }
+// STREAMING BUFFER
+// ----------------
+static void _stream_flush()
+{
+    if (choks.stream.dirty_end <= choks.stream.dirty_begin) return;
 
-        WebPAnimInfo anim_info;
-        WebPAnimDecoderGetInfo(decoder, &anim_info);
+    // fences guarantee the gpu is done with this segment, so the driver can copy straight in
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, choks.stream.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, choks.stream.segment * CHOKS_STREAM_SIZE + choks.stream.dirty_begin,
+        choks.stream.dirty_end - choks.stream.dirty_begin, choks.stream.shadow + choks.stream.dirty_begin);
 
+    choks.stream.dirty_begin = choks.stream.dirty_end = 0;
+}
 
-        // checks
-        if (anim_info.frame_count != 6)
-        {
-            choks_debug_printf("cubemap webp does not have EXACTLY 6 frames.\n");
-            valid = 0;
-        }
+static void _stream_next_segment(int frame_end)
+{
+    // whatever is still in the shadow belongs to this segment
+    _stream_flush();
 
-        // after checks are done.
-        if (valid)
+    // a fence only covers what was issued before it. mid frame the draws reading this segment
+    // may not be (rqueue streams every block up front), so early wraps wait for the frame end
+    choks.stream.unfenced |= 1u << choks.stream.segment;
+    if (frame_end)
+    {
+        for (int i = 0; i < CHOKS_FRAMES_IN_FLIGHT; i++)
         {
-            this.width = anim_info.canvas_width;
-            this.height = anim_info.canvas_height;
+            if (choks.stream.unfenced & (1u << i)) choks.stream.fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        choks.stream.unfenced = 0;
+    }
 
-            // NOW generate opengl cubemap texture.
-            glGenTextures(1, &this.id);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, this.id);
+    // then move on and wait until the gpu is done with the next one.
+    choks.stream.segment = (choks.stream.segment + 1) % CHOKS_FRAMES_IN_FLIGHT;
+    choks.stream.head = 0;
 
-            int index = 0;
-            while (WebPAnimDecoderHasMoreFrames(decoder))
+    if (choks.stream.unfenced & (1u << choks.stream.segment))
+    {
+        // went all the way around in one frame. anything streamed but not drawn yet gets overwritten
+        choks_debug_printf("stream ring wrapped within a single frame. raise CHOKS_STREAM_SIZE.\n");
+        choks.stream.fences[choks.stream.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        choks.stream.unfenced &= ~(1u << choks.stream.segment);
+    }
+
+    GLsync fence = choks.stream.fences[choks.stream.segment];
+    if (fence)
+    {
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(fence);
+        choks.stream.fences[choks.stream.segment] = 0;
+    }
+}
+
+void choks_end_frame()
+{
+    choks.state.last_frame = choks.state.frame;
+    choks.state.frame = (choks_state_stats_t) { 0 };
+
+    _texture_async_update();
+
+    _stream_next_segment(1);
+
+    // keep the mvp bindings alive in the new segment
+    choks.mvp.model_bound = choks.mvp.viewprojection_bound = 0;
+    set_model_matrix_faded(choks.mvp.data.model, (vertex_decode_t) {
+        { choks.mvp.data.decode_scale.x, choks.mvp.data.decode_scale.y, choks.mvp.data.decode_scale.z },
+        { choks.mvp.data.decode_bias.x, choks.mvp.data.decode_bias.y, choks.mvp.data.decode_bias.z },
+    }, choks.mvp.data.decode_scale.w);
+    set_view_and_projection_matrices(choks.mvp.data.view, choks.mvp.data.proj);
+}
+
+void* stream_map(unsigned int size, unsigned int alignment, stream_range_t* range)
+{
+    if (alignment == CHOKS_STREAM_ALIGN_UNIFORM) alignment = choks.stream.uniform_alignment;
+    if (alignment == 0) alignment = 1;
+
+    if (size > CHOKS_STREAM_SIZE)
+    {
+        choks_debug_printf("stream allocation of %u bytes is bigger than CHOKS_STREAM_SIZE.\n", size);
+        return nil;
+    }
+
+    unsigned int head = (choks.stream.head + alignment - 1) / alignment * alignment;
+    if (head + size > CHOKS_STREAM_SIZE)
+    {
+        // ran out of room this frame, steal the next segment (may stall)
+        choks_debug_printf("stream segment full, wrapping early. raise CHOKS_STREAM_SIZE.\n");
+        _stream_next_segment(0);
+        head = 0;
+    }
+
+    range->buffer = choks.stream.buffer;
+    range->offset = choks.stream.segment * CHOKS_STREAM_SIZE + head;
+    range->size = size;
+
+    choks.stream.head = head + size;
+
+    if (choks.stream.mapped) return choks.stream.mapped + range->offset;
+
+    // allocations only move forward, so the dirty part stays one range
+    if (choks.stream.dirty_end <= choks.stream.dirty_begin) choks.stream.dirty_begin = head;
+    choks.stream.dirty_end = head + size;
+    return choks.stream.shadow + head;
+}
+
+void stream_unmap()
+{
+    if (!choks.stream.batching) _stream_flush();
+}
+
+void stream_batch_begin()
+{
+    choks.stream.batching = 1;
+}
+
+void stream_batch_end()
+{
+    choks.stream.batching = 0;
+    _stream_flush();
+}
+
+stream_range_t stream_upload(const void* data, unsigned int size, unsigned int alignment)
+{
+    stream_range_t range = { 0 };
+    void* ptr = stream_map(size, alignment, &range);
+
+    if (ptr)
+    {
+        memcpy(ptr, data, size);
+        stream_unmap();
+    }
+
+    return range;
+}
+
+stream_range_t stream_bind_uniform(const void* data, unsigned int size, unsigned int binding)
+{
+    stream_range_t range = stream_upload(data, size, CHOKS_STREAM_ALIGN_UNIFORM);
+
+    if (range.buffer)
+    {
+        choks_bind_buffer_range(GL_UNIFORM_BUFFER, binding, range.buffer, range.offset, range.size);
+    }
+
+    return range;
+}
+
+// state machine :D
+// ----------------
+// mvp:
+void set_model_matrix(mat4_t model)
+{
+    set_model_matrix_decoded(model, VERTEX_DECODE_IDENTITY);
+}
+
+void set_model_matrix_decoded(mat4_t model, vertex_decode_t decode)
+{
+    set_model_matrix_faded(model, decode, 0.0f);
+}
+
+void set_model_matrix_faded(mat4_t model, vertex_decode_t decode, float lod_fade)
+{
+    vec4_t scale = HMM_Vec4(decode.scale[0], decode.scale[1], decode.scale[2], lod_fade);
+    vec4_t bias = HMM_Vec4(decode.bias[0], decode.bias[1], decode.bias[2], 0.0f);
+
+    // same as last time, the binding already points at it
+    if (choks.mvp.model_bound && !memcmp(&model, &choks.mvp.data.model, sizeof(mat4_t)) &&
+        !memcmp(&scale, &choks.mvp.data.decode_scale, sizeof(vec4_t)) && !memcmp(&bias, &choks.mvp.data.decode_bias, sizeof(vec4_t)))
+    {
+        choks.state.frame.elided++;
+        return;
+    }
+
+    choks.mvp.data.model = model;
+    choks.mvp.data.decode_scale = scale;
+    choks.mvp.data.decode_bias = bias;
+    choks.mvp.model_bound = 1;
+    stream_bind_uniform(&choks.mvp.data.model, sizeof(mat4_t) + sizeof(vec4_t) * 2, CHOKS_BINDING_MODEL);
+}
+
+stream_range_t stream_model_block(mat4_t model, vertex_decode_t decode, float lod_fade)
+{
+    stream_range_t range = { 0 };
+    struct choks_mvp_data_s* block = stream_map(sizeof(mat4_t) + sizeof(vec4_t) * 2, CHOKS_STREAM_ALIGN_UNIFORM, &range);
+    if (!block) return range;
+
+    block->model = model;
+    block->decode_scale = HMM_Vec4(decode.scale[0], decode.scale[1], decode.scale[2], lod_fade);
+    block->decode_bias = HMM_Vec4(decode.bias[0], decode.bias[1], decode.bias[2], 0.0f);
+    stream_unmap();
+    return range;
+}
+
+void set_model_block(stream_range_t block, mat4_t model, vertex_decode_t decode, float lod_fade)
+{
+    if (!block.buffer) return;
+
+    choks.mvp.data.model = model;
+    choks.mvp.data.decode_scale = HMM_Vec4(decode.scale[0], decode.scale[1], decode.scale[2], lod_fade);
+    choks.mvp.data.decode_bias = HMM_Vec4(decode.bias[0], decode.bias[1], decode.bias[2], 0.0f);
+    choks.mvp.model_bound = 1;
+    choks_bind_buffer_range(GL_UNIFORM_BUFFER, CHOKS_BINDING_MODEL, block.buffer, block.offset, block.size);
+}
+
+void set_view_and_projection_matrices(mat4_t view, mat4_t projection)
+{
+    if (choks.mvp.viewprojection_bound && !memcmp(&view, &choks.mvp.data.view, sizeof(mat4_t)) && !memcmp(&projection, &choks.mvp.data.proj, sizeof(mat4_t)))
+    {
+        choks.state.frame.elided++;
+        return;
+    }
+
+    choks.mvp.data.view = view;
+    choks.mvp.data.proj = projection;
+    choks.mvp.viewprojection_bound = 1;
+    stream_bind_uniform(&choks.mvp.data.view, sizeof(mat4_t) * 2, CHOKS_BINDING_VIEWPROJECTION);
+}
+
+// ASSETS
+// ------
+static void _assets_mount()
+{
+    int fd = open(CHOKS_ASSET_PACK, O_RDONLY);
+    if (fd < 0)
+    {
+        choks_debug_printf("no %s, loading loose files only.\n", CHOKS_ASSET_PACK);
+        return;
+    }
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (!fstat(fd, &st) && (size_t) st.st_size >= sizeof(pack_header_t))
+    {
+        data = mmap(nil, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd); // the mapping keeps the file alive
+
+    if (data == MAP_FAILED) return;
+
+    const pack_header_t* header = data;
+    if (header->magic != PACK_MAGIC || header->version != PACK_VERSION || sizeof(*header) + sizeof(pack_entry_t) * (size_t) header->count > (size_t) st.st_size)
+    {
+        choks_debug_printf("%s is not a valid pack (rebuild it)\n", CHOKS_ASSET_PACK);
+        munmap(data, st.st_size);
+        return;
+    }
+
+    // lookups compare names straight out of the mapping, a truncated pack would read past it
+    const pack_entry_t* entries = (const pack_entry_t*) (header + 1);
+    for (uint32_t i = 0; i < header->count; i++)
+    {
+        if ((uint64_t) entries[i].name_offset + entries[i].name_length >= (uint64_t) st.st_size ||
+            (uint64_t) entries[i].offset + entries[i].size >= (uint64_t) st.st_size)
+        {
+            choks_debug_printf("%s entry %u points past the end of the file, not mounting it (rebuild it)\n", CHOKS_ASSET_PACK, i);
+            munmap(data, st.st_size);
+            return;
+        }
+    }
+
+    choks.assets.pack = data;
+    choks.assets.pack_size = st.st_size;
+    choks.assets.entries = entries;
+    choks.assets.count = header->count;
+
+    choks_debug_printf("mounted %s, %u files\n", CHOKS_ASSET_PACK, choks.assets.count);
+}
+
+static void _assets_unmount()
+{
+    if (choks.assets.pack) munmap((void*) choks.assets.pack, choks.assets.pack_size);
+    choks.assets = (struct choks_assets_s) { 0 };
+}
+
+static asset_t _asset_read_loose(const char* path)
+{
+    asset_t this = { 0 };
+
+    FILE* f = fopen(path, "rb");
+    if (!f) return this;
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    unsigned char* buffer = length >= 0 ? malloc(length + 1) : nil; // + '\0'
+    if (buffer)
+    {
+        size_t size = fread(buffer, 1, length, f);
+        buffer[size] = '\0';
+
+        this.data = buffer;
+        this.size = size;
+        this.owned = 1;
+    }
+
+    fclose(f);
+    return this;
+}
+
+static const pack_entry_t* _asset_find(const char* path)
+{
+    uint64_t hash = pack_hash(path);
+    size_t length = strlen(path);
+
+    // lower bound, then walk the (very unlikely) run of equal hashes
+    uint32_t low = 0, high = choks.assets.count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (choks.assets.entries[middle].hash < hash) low = middle + 1;
+        else high = middle;
+    }
+
+    for (uint32_t i = low; i < choks.assets.count && choks.assets.entries[i].hash == hash; i++)
+    {
+        const pack_entry_t* entry = &choks.assets.entries[i];
+        if (entry->name_length == length && !memcmp(choks.assets.pack + entry->name_offset, path, length)) return entry;
+    }
+
+    return nil;
+}
+
+asset_t asset_open(const char* path)
+{
+    while (path[0] == '.' && path[1] == '/') path += 2;
+
+    #if CHOKS_LOOSE_ASSETS
+    struct stat st;
+    if (!stat(path, &st) && S_ISREG(st.st_mode)) return _asset_read_loose(path);
+    #endif
+
+    asset_t this = { 0 };
+    if (!choks.assets.pack) return this;
+
+    const pack_entry_t* entry = _asset_find(path);
+    if (!entry || (size_t) entry->offset + entry->size >= choks.assets.pack_size) return this;
+
+    this.data = choks.assets.pack + entry->offset;
+    this.size = entry->size;
+    return this;
+}
+
+void asset_close(asset_t* this)
+{
+    if (this->owned) free((void*) this->data);
+    *this = (asset_t) { 0 };
+}
+
+// PRIMITIVES
+// ----------
+static void _setup_vao_attr(vertex_layout_t layout)
+{
+    static const int components[VERTEX_ATTRIBUTES] = { 3, 2, 3, 4 };
+    int stride = vertex_layout_stride(layout);
+
+    for (int i = 0; i < VERTEX_ATTRIBUTES; i++)
+    {
+        void* offset = (void*) (uintptr_t) vertex_layout_offset(layout, i);
+
+        switch (layout.formats[i])
+        {
+            case VERTEX_FORMAT_FLOAT: glVertexAttribPointer(i, components[i], GL_FLOAT, GL_FALSE, stride, offset); break;
+            case VERTEX_FORMAT_HALF: glVertexAttribPointer(i, components[i], GL_HALF_FLOAT, GL_FALSE, stride, offset); break;
+            case VERTEX_FORMAT_UNORM16: glVertexAttribPointer(i, components[i], GL_UNSIGNED_SHORT, GL_TRUE, stride, offset); break;
+            case VERTEX_FORMAT_INT_2_10_10_10: glVertexAttribPointer(i, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset); break;
+            case VERTEX_FORMAT_UNORM8: glVertexAttribPointer(i, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, offset); break;
+            default:
+                glDisableVertexAttribArray(i);
+                continue;
+        }
+
+        glEnableVertexAttribArray(i);
+    }
+}
+
+static void _primitive_bounds(primitive_t* this, const void* vertices) // packed in this->layout
+{
+    this->min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    this->max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    int stride = vertex_layout_stride(this->layout);
+    for (int i = 0; i < this->vertex_count; i++)
+    {
+        float v[3];
+        vertex_unpack_position(this->layout, this->decode, (const unsigned char*) vertices + stride * i, v);
+        this->min = HMM_Vec3(HMM_MIN(this->min.x, v[0]), HMM_MIN(this->min.y, v[1]), HMM_MIN(this->min.z, v[2]));
+        this->max = HMM_Vec3(HMM_MAX(this->max.x, v[0]), HMM_MAX(this->max.y, v[1]), HMM_MAX(this->max.z, v[2]));
+    }
+
+    if (!this->vertex_count) this->min = this->max = HMM_Vec3(0.0f, 0.0f, 0.0f);
+}
+
+// geometry arena:
+static void _range_list_insert(struct choks_range_list_s* list, int at, int offset, int size)
+{
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->ranges = realloc(list->ranges, sizeof(struct choks_range_s) * list->capacity);
+    }
+
+    memmove(list->ranges + at + 1, list->ranges + at, sizeof(struct choks_range_s) * (list->count - at));
+    list->ranges[at] = (struct choks_range_s) { offset, size };
+    list->count++;
+}
+
+static void _range_list_remove(struct choks_range_list_s* list, int at)
+{
+    memmove(list->ranges + at, list->ranges + at + 1, sizeof(struct choks_range_s) * (list->count - at - 1));
+    list->count--;
+}
+
+static void _range_list_reset(struct choks_range_list_s* list, int used, int capacity)
+{
+    list->count = 0;
+    if (used < capacity) _range_list_insert(list, 0, used, capacity - used);
+}
+
+static int _range_alloc(struct choks_range_list_s* list, int size) // first fit, -1 if nothing fits
+{
+    if (!size) return 0;
+
+    for (int i = 0; i < list->count; i++)
+    {
+        struct choks_range_s* range = &list->ranges[i];
+        if (range->size < size) continue;
+
+        int offset = range->offset;
+        range->offset += size;
+        range->size -= size;
+        if (!range->size) _range_list_remove(list, i);
+
+        return offset;
+    }
+
+    return -1;
+}
+
+static void _range_free(struct choks_range_list_s* list, int offset, int size)
+{
+    if (!size) return;
+
+    int at = 0;
+    while (at < list->count && list->ranges[at].offset < offset) at++;
+
+    int joins_previous = at > 0 && list->ranges[at - 1].offset + list->ranges[at - 1].size == offset;
+    int joins_next = at < list->count && offset + size == list->ranges[at].offset;
+
+    if (joins_previous && joins_next)
+    {
+        list->ranges[at - 1].size += size + list->ranges[at].size;
+        _range_list_remove(list, at);
+    }
+    else if (joins_previous) list->ranges[at - 1].size += size;
+    else if (joins_next)
+    {
+        list->ranges[at].offset = offset;
+        list->ranges[at].size += size;
+    }
+    else _range_list_insert(list, at, offset, size);
+}
+
+static int _range_total(const struct choks_range_list_s* list)
+{
+    int total = 0;
+    for (int i = 0; i < list->count; i++) total += list->ranges[i].size;
+    return total;
+}
+
+static int _arena_new_block(vertex_layout_t layout, int vertex_capacity, int index_capacity)
+{
+    choks.arena.blocks = realloc(choks.arena.blocks, sizeof(struct choks_arena_block_s) * (choks.arena.block_count + 1));
+    struct choks_arena_block_s* block = &choks.arena.blocks[choks.arena.block_count];
+    memset(block, 0, sizeof(*block));
+
+    block->layout = layout;
+    block->stride = vertex_layout_stride(layout);
+    block->vertex_capacity = vertex_capacity;
+    block->index_capacity = index_capacity;
+    _range_list_reset(&block->free_vertices, 0, vertex_capacity);
+    _range_list_reset(&block->free_indices, 0, index_capacity);
+
+    glGenVertexArrays(1, &block->vao);
+    choks_bind_vertex_array(block->vao);
+
+    glGenBuffers(1, &block->vbo);
+    choks_bind_buffer(GL_ARRAY_BUFFER, block->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (size_t) block->stride * vertex_capacity, nil, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &block->ibo);
+    choks_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, block->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * index_capacity, nil, GL_STATIC_DRAW);
+
+    _setup_vao_attr(layout);
+
+    choks_debug_printf("new geometry arena block (%i vertices of %i bytes, %i indices).\n", vertex_capacity, block->stride, index_capacity);
+    return choks.arena.block_count++;
+}
+
+// copies every allocation of the block to the front of fresh buffers. fresh ones instead of
+// sliding in place since glCopyBufferSubData cant overlap its source and destination
+static void _arena_pack_block(int index)
+{
+    struct choks_arena_block_s* block = &choks.arena.blocks[index];
+
+    unsigned int vbo, ibo;
+    glGenBuffers(1, &vbo);
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t) block->stride * block->vertex_capacity, nil, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &ibo);
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, ibo);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * block->index_capacity, nil, GL_STATIC_DRAW);
+
+    int vertex_head = 0, index_head = 0;
+    for (int i = 0; i < choks.arena.allocation_count; i++)
+    {
+        struct choks_allocation_s* allocation = &choks.arena.allocations[i];
+        if (allocation->block != index) continue;
+
+        if (allocation->vertex_count)
+        {
+            choks_bind_buffer(GL_COPY_READ_BUFFER, block->vbo);
+            choks_bind_buffer(GL_COPY_WRITE_BUFFER, vbo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                (size_t) block->stride * allocation->first_vertex, (size_t) block->stride * vertex_head,
+                (size_t) block->stride * allocation->vertex_count);
+        }
+
+        // indices are relative to the base vertex, so they copy as they are
+        if (allocation->index_count)
+        {
+            choks_bind_buffer(GL_COPY_READ_BUFFER, block->ibo);
+            choks_bind_buffer(GL_COPY_WRITE_BUFFER, ibo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                sizeof(unsigned int) * allocation->first_index, sizeof(unsigned int) * index_head,
+                sizeof(unsigned int) * allocation->index_count);
+        }
+
+        allocation->first_vertex = vertex_head;
+        allocation->first_index = index_head;
+        vertex_head += allocation->vertex_count;
+        index_head += allocation->index_count;
+    }
+
+    choks_delete_buffer(block->vbo);
+    choks_delete_buffer(block->ibo);
+    block->vbo = vbo;
+    block->ibo = ibo;
+
+    // same vao, pointed at the new buffers
+    choks_bind_vertex_array(block->vao);
+    choks_bind_buffer(GL_ARRAY_BUFFER, block->vbo);
+    choks_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, block->ibo);
+    _setup_vao_attr(block->layout);
+
+    _range_list_reset(&block->free_vertices, vertex_head, block->vertex_capacity);
+    _range_list_reset(&block->free_indices, index_head, block->index_capacity);
+}
+
+static int _arena_block_alloc(int index, int vertex_count, int index_count, int* first_vertex, int* first_index)
+{
+    struct choks_arena_block_s* block = &choks.arena.blocks[index];
+
+    *first_vertex = _range_alloc(&block->free_vertices, vertex_count);
+    if (*first_vertex < 0) return 0;
+
+    *first_index = _range_alloc(&block->free_indices, index_count);
+    if (*first_index < 0)
+    {
+        _range_free(&block->free_vertices, *first_vertex, vertex_count);
+        return 0;
+    }
+
+    return 1;
+}
+
+static int _arena_alloc(vertex_layout_t layout, int vertex_count, int index_count) // index_count in slots
+{
+    int block = -1, first_vertex = 0, first_index = 0;
+
+    for (int i = 0; i < choks.arena.block_count && block < 0; i++)
+    {
+        if (!vertex_layout_equal(choks.arena.blocks[i].layout, layout)) continue;
+        if (_arena_block_alloc(i, vertex_count, index_count, &first_vertex, &first_index)) block = i;
+    }
+
+    // fragmented but big enough in total
+    for (int i = 0; i < choks.arena.block_count && block < 0; i++)
+    {
+        struct choks_arena_block_s* candidate = &choks.arena.blocks[i];
+        if (!vertex_layout_equal(candidate->layout, layout)) continue;
+        if (_range_total(&candidate->free_vertices) < vertex_count || _range_total(&candidate->free_indices) < index_count) continue;
+
+        _arena_pack_block(i);
+        if (_arena_block_alloc(i, vertex_count, index_count, &first_vertex, &first_index)) block = i;
+    }
+
+    if (block < 0)
+    {
+        block = _arena_new_block(layout, HMM_MAX(vertex_count, CHOKS_ARENA_BLOCK_VERTICES), HMM_MAX(index_count, CHOKS_ARENA_BLOCK_INDICES));
+        _arena_block_alloc(block, vertex_count, index_count, &first_vertex, &first_index);
+    }
+
+    int handle = choks.arena.free_allocation;
+    if (handle >= 0) choks.arena.free_allocation = choks.arena.allocations[handle].next_free;
+    else
+    {
+        if (choks.arena.allocation_count == choks.arena.allocation_capacity)
+        {
+            choks.arena.allocation_capacity = choks.arena.allocation_capacity ? choks.arena.allocation_capacity * 2 : 64;
+            choks.arena.allocations = realloc(choks.arena.allocations, sizeof(struct choks_allocation_s) * choks.arena.allocation_capacity);
+        }
+        handle = choks.arena.allocation_count++;
+    }
+
+    choks.arena.allocations[handle] = (struct choks_allocation_s) { block, first_vertex, vertex_count, first_index, index_count, -1 };
+    choks.arena.live++;
+    return handle + 1; // 0 stays free for zeroed primitives
+}
+
+static void _arena_free(int handle)
+{
+    handle--;
+    if (handle < 0 || handle >= choks.arena.allocation_count) return;
+
+    struct choks_allocation_s* allocation = &choks.arena.allocations[handle];
+    if (allocation->block < 0) return;
+
+    struct choks_arena_block_s* block = &choks.arena.blocks[allocation->block];
+    _range_free(&block->free_vertices, allocation->first_vertex, allocation->vertex_count);
+    _range_free(&block->free_indices, allocation->first_index, allocation->index_count);
+
+    allocation->block = -1;
+    allocation->next_free = choks.arena.free_allocation;
+    choks.arena.free_allocation = handle;
+    choks.arena.live--;
+}
+
+static void _arena_cleanup()
+{
+    for (int i = 0; i < choks.arena.block_count; i++)
+    {
+        struct choks_arena_block_s* block = &choks.arena.blocks[i];
+        choks_delete_buffer(block->ibo);
+        choks_delete_buffer(block->vbo);
+        choks_delete_vertex_array(block->vao);
+        free(block->free_vertices.ranges);
+        free(block->free_indices.ranges);
+    }
+
+    if (choks.arena.live) choks_debug_printf("%i primitives still in the geometry arena at cleanup.\n", choks.arena.live);
+
+    free(choks.arena.blocks);
+    free(choks.arena.allocations);
+    memset(&choks.arena, 0, sizeof(choks.arena));
+    choks.arena.free_allocation = -1;
+}
+
+void geometry_arena_defragment()
+{
+    for (int i = 0; i < choks.arena.block_count; i++)
+    {
+        struct choks_arena_block_s* block = &choks.arena.blocks[i];
+        if (block->free_vertices.count > 1 || block->free_indices.count > 1) _arena_pack_block(i);
+    }
+}
+
+geometry_arena_stats_t geometry_arena_stats()
+{
+    geometry_arena_stats_t stats = { 0 };
+    stats.blocks = choks.arena.block_count;
+    stats.allocations = choks.arena.live;
+
+    for (int i = 0; i < choks.arena.block_count; i++)
+    {
+        struct choks_arena_block_s* block = &choks.arena.blocks[i];
+        stats.vertices_capacity += block->vertex_capacity;
+        stats.vertices_used += block->vertex_capacity - _range_total(&block->free_vertices);
+        stats.indices_capacity += block->index_capacity;
+        stats.indices_used += block->index_capacity - _range_total(&block->free_indices);
+        stats.free_ranges += block->free_vertices.count + block->free_indices.count;
+    }
+
+    return stats;
+}
+
+// primitives:
+primitive_t primitive_load_packed(const void* vertices, int vertex_count, const void* indices, int index_count, int index_size, int draw_mode, vertex_layout_t layout, vertex_decode_t decode)
+{
+    primitive_t this = { 0 };
+    this.vertex_count = vertex_count;
+    this.index_count = index_count;
+    this.draw_mode = draw_mode;
+    this.layout = layout;
+    this.decode = decode;
+
+    // half the index bandwidth for anything under 65536 vertices
+    uint16_t* narrowed = nil;
+    if (index_count && index_size == 4 && meshopt_index_size(vertex_count) == 2)
+    {
+        narrowed = malloc(sizeof(uint16_t) * index_count);
+        meshopt_narrow_indices(indices, index_count, narrowed);
+        indices = narrowed;
+        index_size = 2;
+    }
+
+    this.index_size = index_size;
+    this.index_type = index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    int index_slots = (index_count * index_size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    this.allocation = _arena_alloc(layout, vertex_count, index_slots);
+    primitive_locate(&this);
+
+    // copy write so the element binding of whatever vao is bound stays put
+    size_t stride = vertex_layout_stride(layout);
+    choks_bind_buffer(GL_COPY_WRITE_BUFFER, this.vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, stride * this.base_vertex, stride * vertex_count, vertices);
+
+    if (index_count)
+    {
+        choks_bind_buffer(GL_COPY_WRITE_BUFFER, this.ibo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t) index_size * this.first_index, (size_t) index_size * index_count, indices);
+    }
+
+    free(narrowed);
+    _primitive_bounds(&this, vertices);
+    return this;
+}
+
+primitive_t primitive_load(float* data, int vertex_count, int draw_mode) // vertex: xyzst.
+{
+    return primitive_load_packed(data, vertex_count, nil, 0, 4, draw_mode, VERTEX_LAYOUT_STD, VERTEX_DECODE_IDENTITY);
+}
+
+primitive_t primitive_load_with_indices(float* vertices, int vertex_count, unsigned int* indices, int index_count, int draw_mode)
+{
+    return primitive_load_packed(vertices, vertex_count, indices, index_count, 4, draw_mode, VERTEX_LAYOUT_STD, VERTEX_DECODE_IDENTITY);
+}
+
+primitive_t primitive_load_vertices(const vertex_t* vertices, int vertex_count, const unsigned int* indices, int index_count, int draw_mode, vertex_layout_t layout)
+{
+    vertex_decode_t decode = VERTEX_DECODE_IDENTITY;
+    if (layout.formats[VERTEX_POSITION] == VERTEX_FORMAT_UNORM16 && !vertex_quantize_positions(vertices, vertex_count, &decode))
+    {
+        choks_debug_printf("mesh spans too much for 16 bit positions, keeping floats.\n");
+        layout.formats[VERTEX_POSITION] = VERTEX_FORMAT_FLOAT;
+    }
+
+    void* packed = malloc((size_t) vertex_layout_stride(layout) * vertex_count);
+    vertex_pack(layout, decode, vertices, vertex_count, packed);
+
+    primitive_t this = primitive_load_packed(packed, vertex_count, indices, index_count, 4, draw_mode, layout, decode);
+    free(packed);
+    return this;
+}
+
+void primitive_free(primitive_t* this)
+{
+    _arena_free(this->allocation);
+    *this = (primitive_t) { 0 };
+}
+
+void primitive_locate(primitive_t* this)
+{
+    if (this->allocation <= 0 || this->allocation > choks.arena.allocation_count) return;
+
+    const struct choks_allocation_s* allocation = &choks.arena.allocations[this->allocation - 1];
+    if (allocation->block < 0) return;
+
+    const struct choks_arena_block_s* block = &choks.arena.blocks[allocation->block];
+    this->vao = block->vao;
+    this->vbo = block->vbo;
+    this->ibo = block->ibo;
+    this->base_vertex = allocation->first_vertex;
+    this->first_index = allocation->first_index * (int) sizeof(uint32_t) / HMM_MAX(this->index_size, 1);
+}
+
+// DEPRECATED ---------------------------------------------------------------------------------
+#if 0
+void primitive_attach_indices(primitive_t* this, unsigned int* data, int index_count) // unused
+{
+    this->index_count = index_count;
+
+    choks_bind_vertex_array(this->vao);
+    glGenBuffers(1, &this->ibo);
+
+    choks_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * this->vertex_count, data, GL_STATIC_DRAW);
+}
+#endif
+
+void primitive_draw(primitive_t* this)
+{
+    primitive_locate(this);
+    choks_bind_vertex_array(this->vao);
+
+    if (this->index_count)
+    {
+        glDrawElementsBaseVertex(this->draw_mode, this->index_count, this->index_type, primitive_index_offset(this, 0), this->base_vertex);
+        return;
+    }
+
+    glDrawArrays(this->draw_mode, this->base_vertex, this->vertex_count);
+}
+
+// INSTANCING
+// ----------
+instance_buffer_t instance_buffer_load(const mat4_t* models, int count)
+{
+    instance_buffer_t this = { 0 };
+    this.count = count;
+    this.owned = 1;
+
+    glGenBuffers(1, &this.buffer);
+    choks_bind_buffer(GL_ARRAY_BUFFER, this.buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(mat4_t) * count, models, GL_STATIC_DRAW);
+
+    return this;
+}
+
+instance_buffer_t instance_buffer_stream(const mat4_t* models, int count)
+{
+    instance_buffer_t this = { 0 };
+
+    stream_range_t range = stream_upload(models, sizeof(mat4_t) * count, sizeof(vec4_t));
+    if (!range.buffer) return this; // too big for the ring, draws nothing
+
+    this.buffer = range.buffer;
+    this.offset = range.offset;
+    this.count = count;
+    return this;
+}
+
+void instance_buffer_update(instance_buffer_t* this, const mat4_t* models, int first, int count)
+{
+    if (!this->owned || first + count > this->count)
+    {
+        choks_debug_printf("instance_buffer_update out of range (%i + %i of %i).\n", first, count, this->count);
+        return;
+    }
+
+    choks_bind_buffer(GL_ARRAY_BUFFER, this->buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(mat4_t) * first, sizeof(mat4_t) * count, models);
+}
+
+void instance_buffer_free(instance_buffer_t* this)
+{
+    if (this->owned) choks_delete_buffer(this->buffer);
+    *this = (instance_buffer_t) { 0 };
+}
+
+void instance_buffer_bind(const instance_buffer_t* this)
+{
+    // stream ranges move every frame, so the pointers get set per draw rather than once per vao
+    choks_bind_buffer(GL_ARRAY_BUFFER, this->buffer);
+
+    for (int i = 0; i < 4; i++)
+    {
+        int location = CHOKS_ATTRIB_INSTANCE_MODEL + i;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(mat4_t), (void*) (uintptr_t) (this->offset + sizeof(vec4_t) * i));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+}
+
+void instance_buffer_unbind()
+{
+    for (int i = 0; i < 4; i++) glDisableVertexAttribArray(CHOKS_ATTRIB_INSTANCE_MODEL + i);
+}
+
+void primitive_draw_instanced(primitive_t* this, const instance_buffer_t* instances)
+{
+    if (!instances->count) return;
+
+    primitive_locate(this);
+    choks_bind_vertex_array(this->vao);
+    instance_buffer_bind(instances);
+
+    if (this->index_count) glDrawElementsInstancedBaseVertex(this->draw_mode, this->index_count, this->index_type, primitive_index_offset(this, 0), instances->count, this->base_vertex);
+    else glDrawArraysInstanced(this->draw_mode, this->base_vertex, this->vertex_count, instances->count);
+
+    instance_buffer_unbind();
+}
+
+// PROGRAMS
+// --------
+static void validate_shader(int id)
+{
+    int successful;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &successful);
+    if (!successful) {
+        static char log[512];
+        glGetShaderInfoLog(id, 512, NULL, log);
+        printf("%s\n", log);
+    }
+}
+
+// splices '#include "path"' lines (relative to the content directory, one level deep) into the
+// source so shaders can share snippets. malloced, nil if an include is missing
+static char* _shader_includes(const char* path, const char* source)
+{
+    size_t length = strlen(source), capacity = length + 1, used = 0;
+    char* out = malloc(capacity);
+
+    const char* line = source;
+    while (*line)
+    {
+        const char* end = strchr(line, '\n');
+        end = end ? end + 1 : line + strlen(line);
+
+        const char* chunk = line;
+        size_t chunk_length = end - line;
+        asset_t include = { 0 };
+
+        if (!strncmp(line, "#include \"", 10))
+        {
+            char name[256];
+            const char* quote = memchr(line + 10, '"', end - line - 10);
+            size_t name_length = quote ? (size_t) (quote - line - 10) : 0;
+            if (name_length && name_length < sizeof(name))
+            {
+                memcpy(name, line + 10, name_length);
+                name[name_length] = '\0';
+                include = asset_open(name);
+            }
+
+            if (!include.data)
             {
-                uint8_t* buf;
-                int timestamp;
-                WebPAnimDecoderGetNext(decoder, &buf, &timestamp); // this buffer is rgba
-                
-                glTexImage2D(
-                    GL_TEXTURE_CUBE_MAP_POSITIVE_X + index,
-                    0,
-                    GL_RGBA,
-                    anim_info.canvas_width,
-                    anim_info.canvas_height,
-                    0,
-                    GL_RGBA,
-                    GL_UNSIGNED_BYTE,
-                    buf
-                );
-                
-                index++;
-                #if CHOKS_DEBUG
-                choks_debug_printf("loaded %i\n", index);
-                #endif
+                choks_debug_printf("%s: cant resolve %.*s", path, (int) chunk_length, line);
+                free(out);
+                return nil;
             }
 
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        }
+            chunk = (const char*) include.data;
+            chunk_length = include.size;
+        }
+
+        if (used + chunk_length + 2 > capacity)
+        {
+            capacity = (used + chunk_length + 2) * 2;
+            out = realloc(out, capacity);
+        }
+        memcpy(out + used, chunk, chunk_length);
+        used += chunk_length;
+        if (include.data && chunk_length && chunk[chunk_length - 1] != '\n') out[used++] = '\n';
+
+        asset_close(&include);
+        line = end;
+    }
+
+    out[used] = '\0';
+    return out;
+}
+
+program_t program_load_from_files(const char* vertex_shader_path, const char* fragment_shader_path)
+{
+    asset_t vertex_source = asset_open(vertex_shader_path);
+    asset_t fragment_source = asset_open(fragment_shader_path);
+
+    // printf("%s (vertex):\n%s\n%s (fragment):\n%s\n", vertex_shader_path, vertex_source.data, fragment_shader_path, fragment_source.data);
+
+    if (!vertex_source.data || !fragment_source.data)
+    {
+        choks_debug_printf("program source paths not valid.\n");
+        asset_close(&vertex_source);
+        asset_close(&fragment_source);
+        return (program_t) { 0 }; // invalid program
+    }
+
+    // assets are always '\0' terminated
+    char* vertex = _shader_includes(vertex_shader_path, (const char*) vertex_source.data);
+    char* fragment = _shader_includes(fragment_shader_path, (const char*) fragment_source.data);
+    asset_close(&vertex_source);
+    asset_close(&fragment_source);
+
+    program_t this = { 0 };
+    if (vertex && fragment) this = program_load_from_source(vertex, fragment);
+
+    free(vertex);
+    free(fragment);
+    return this;
+}
+
+// program binary cache
+// cache/<hash>.bin = header + whatever glGetProgramBinary gave us
+typedef struct
+{
+    char magic[4]; // CHKP
+    uint32_t binary_format;
+    uint32_t length;
+    uint32_t _pad;
+    uint64_t hash;
+} program_cache_header_t;
+
+static uint64_t _program_hash(const char* vertex_source, const char* fragment_source)
+{
+    uint64_t hash = choks.programs.driver_hash;
+    hash = _hash_string(hash, vertex_source);
+    hash = _hash_string(hash, fragment_source);
+    return hash;
+}
+
+static void _program_cache_path(uint64_t hash, char* path, size_t size)
+{
+    snprintf(path, size, "%s/%016llx.bin", CHOKS_PROGRAM_CACHE_DIR, (unsigned long long) hash);
+}
+
+static unsigned int _program_cache_load(uint64_t hash)
+{
+    char path[256];
+    _program_cache_path(hash, path, sizeof(path));
+
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+
+    unsigned int id = 0;
+    void* binary = nil;
+
+    program_cache_header_t header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, "CHKP", 4) != 0 || header.hash != hash)
+    {
+        goto done;
+    }
+
+    binary = malloc(header.length);
+    if (!binary || fread(binary, 1, header.length, f) != header.length)
+    {
+        goto done;
+    }
+
+    id = glCreateProgram();
+    glProgramBinary(id, header.binary_format, binary, header.length);
+
+    // drivers are allowed to reject binaries whenever they want (updates etc.), so this check is required.
+    int successful;
+    glGetProgramiv(id, GL_LINK_STATUS, &successful);
+    if (!successful)
+    {
+        choks_debug_printf("cached program %s rejected by driver, recompiling.\n", path);
+        choks.programs.cache_rejected++;
+        choks_delete_program(id);
+        id = 0;
+    }
+
+    done:
+    free(binary);
+    fclose(f);
+    return id;
+}
+
+static void _program_cache_store(uint64_t hash, unsigned int id)
+{
+    int successful, length = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &successful);
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (!successful || length <= 0) return;
+
+    void* binary = malloc(length);
+    if (!binary) return;
+
+    program_cache_header_t header = { { 'C', 'H', 'K', 'P' } };
+    header.hash = hash;
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(id, length, &written, &format, binary);
+
+    header.binary_format = format;
+    header.length = written;
+
+    char path[256];
+    _program_cache_path(hash, path, sizeof(path));
+
+    FILE* f = fopen(path, "wb");
+    if (f)
+    {
+        fwrite(&header, sizeof(header), 1, f);
+        fwrite(binary, 1, written, f);
+        fclose(f);
+    }
+    else choks_debug_printf("could not write %s\n", path);
+
+    free(binary);
+}
+
+// submits the compile + link, doesnt wait for any of it
+static void _program_submit(struct choks_pending_program_s* pending, const char* vertex_source, const char* fragment_source)
+{
+    pending->id = glCreateProgram(); // put a finger down if you can squirt.....
+
+    // printf("vertex:\n%s\nfragment:\n%s\n", vertex_source, fragment_source);
+
+    pending->vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pending->vertex_shader, 1, &vertex_source, nil);
+    glCompileShader(pending->vertex_shader);
+    glAttachShader(pending->id, pending->vertex_shader);
+
+    pending->fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pending->fragment_shader, 1, &fragment_source, nil);
+    glCompileShader(pending->fragment_shader);
+    glAttachShader(pending->id, pending->fragment_shader);
+
+    #if CHOKS_PROGRAM_CACHE
+    if (choks.programs.cache_usable) glProgramParameteri(pending->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    #endif
+
+    glLinkProgram(pending->id);
+}
+
+// everything that has to wait for the link: validation, caching, uniform blocks
+static void _program_finish(struct choks_pending_program_s* pending)
+{
+    double start = _time_ms();
+
+    if (pending->vertex_shader)
+    {
+        #if CHOKS_DEBUG
+        choks_debug_printf("vert debug:\n");
+        validate_shader(pending->vertex_shader);
+        choks_debug_printf("frag debug:\n");
+        validate_shader(pending->fragment_shader);
+
+        int successful;
+        glGetProgramiv(pending->id, GL_LINK_STATUS, &successful);
+        if (!successful) {
+            static char log[512];
+            glGetProgramInfoLog(pending->id, 512, NULL, log);
+            printf("%s\n", log);
+        }
+        choks_debug_printf("program success!!!\n");
+        #endif
+
+        #if CHOKS_PROGRAM_CACHE
+        if (choks.programs.cache_usable) _program_cache_store(pending->hash, pending->id);
+        #endif
+
+        glDetachShader(pending->id, pending->vertex_shader);
+        glDetachShader(pending->id, pending->fragment_shader);
+        glDeleteShader(pending->vertex_shader);
+        glDeleteShader(pending->fragment_shader);
+    }
+
+    // bind uniform blocks.
+    unsigned int block = glGetUniformBlockIndex(pending->id, "mvp");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(pending->id, block, CHOKS_BINDING_MODEL);
+
+    block = glGetUniformBlockIndex(pending->id, "viewprojection");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(pending->id, block, CHOKS_BINDING_VIEWPROJECTION);
+
+    block = glGetUniformBlockIndex(pending->id, "lighting");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(pending->id, block, CHOKS_BINDING_LIGHTING);
+
+    choks.programs.milliseconds += _time_ms() - start;
+}
+
+program_t program_load_from_source(const char* vertex_source, const char* fragment_source)
+{
+    program_t this = { 0 };
+    double start = _time_ms();
+
+    struct choks_pending_program_s pending = { 0 };
+
+    #if CHOKS_PROGRAM_CACHE
+    if (choks.programs.cache_usable)
+    {
+        pending.hash = _program_hash(vertex_source, fragment_source);
+        pending.id = _program_cache_load(pending.hash);
+        if (pending.id) choks.programs.cache_hits++;
+    }
+    #endif
+
+    if (!pending.id) _program_submit(&pending, vertex_source, fragment_source);
+
+    this.id = pending.id;
+    choks.programs.loaded++;
+    choks.programs.milliseconds += _time_ms() - start;
+
+    // batched programs get finished in program_batch_poll/end
+    if (choks.programs.batching && choks.programs.pending_count < CHOKS_MAX_PENDING_PROGRAMS)
+    {
+        choks.programs.pending[choks.programs.pending_count++] = pending;
+        return this;
+    }
+
+    _program_finish(&pending);
+    return this;
+}
+
+// BATCHES
+void program_batch_begin()
+{
+    choks.programs.batching = 1;
+}
+
+int program_batch_poll()
+{
+    // without the parallel compile extensions any query would block, so leave everything for program_batch_end
+    if (!choks.programs.parallel) return choks.programs.pending_count;
+
+    int i = 0;
+    while (i < choks.programs.pending_count)
+    {
+        int done = 1;
+        glGetProgramiv(choks.programs.pending[i].id, GL_COMPLETION_STATUS_KHR, &done); // same enum for ARB
+
+        if (done)
+        {
+            _program_finish(&choks.programs.pending[i]);
+            choks.programs.pending[i] = choks.programs.pending[--choks.programs.pending_count];
+        }
+        else i++;
+    }
+
+    return choks.programs.pending_count;
+}
+
+void program_batch_end()
+{
+    program_batch_poll();
+
+    for (int i = 0; i < choks.programs.pending_count; i++)
+    {
+        _program_finish(&choks.programs.pending[i]);
+    }
+
+    choks.programs.pending_count = 0;
+    choks.programs.batching = 0;
+}
+
+void program_cache_report()
+{
+    printf("programs: %i loaded, %i from cache, %i rejected, %.3f ms total\n",
+        choks.programs.loaded, choks.programs.cache_hits, choks.programs.cache_rejected, choks.programs.milliseconds);
+}
+
+void program_free(program_t this)
+{
+    choks_delete_program(this.id);
+}
+
+// TEXTURES
+// --------
+// i think for this one ill be sticking to .webp
+#include <webp/decode.h>
+#include <webp/demux.h>
+
+// COOKED TEXTURES
+// ---------------
+// "media/misc/tiles.webp" -> "media/misc/tiles.ctex"
+static void _cooked_path(const char* path, char* out, size_t size)
+{
+    const char* dot = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    int length = dot && (!slash || dot > slash) ? (int) (dot - path) : (int) strlen(path);
+
+    snprintf(out, size, "%.*s.ctex", length, path);
+}
+
+static const ctex_header_t* _ctex_validate(const unsigned char* data, size_t size, ctex_type_t type)
+{
+    const ctex_header_t* header = (const ctex_header_t*) data;
+    if (size < sizeof(*header) || header->magic != CTEX_MAGIC || header->version != CTEX_VERSION) return nil;
+    if (header->type != type || header->format != CTEX_FORMAT_RGBA8) return nil;
+    if (header->faces != (type == CTEX_TYPE_CUBEMAP ? 6 : 1) || !header->levels || header->levels > CTEX_MAX_LEVELS) return nil;
+
+    size_t table_size = sizeof(ctex_level_t) * header->levels * header->faces;
+    if (size < sizeof(*header) + table_size) return nil;
+
+    const ctex_level_t* table = (const ctex_level_t*) (header + 1);
+    for (uint32_t i = 0; i < header->levels * header->faces; i++)
+    {
+        uint32_t level = i / header->faces;
+        size_t expected = (size_t) ctex_level_dimension(header->width, level) * ctex_level_dimension(header->height, level) * 4;
+        if (table[i].size != expected || (size_t) table[i].offset + table[i].size > size) return nil;
+    }
+
+    return header;
+}
+
+texture_t texture_load_cooked(const char* path)
+{
+    texture_t this = { 0 };
+
+    asset_t file = asset_open(path);
+    if (!file.data) return this;
+
+    const unsigned char* data = file.data;
+    const ctex_header_t* header = _ctex_validate(data, file.size, CTEX_TYPE_2D);
+    if (!header) header = _ctex_validate(data, file.size, CTEX_TYPE_CUBEMAP);
+
+    if (!header)
+    {
+        choks_debug_printf("%s is not a valid .ctex (recook it)\n", path);
+        asset_close(&file);
+        return this;
+    }
+
+    const ctex_level_t* table = (const ctex_level_t*) (header + 1);
+    int cubemap = header->type == CTEX_TYPE_CUBEMAP;
+    GLenum target = cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+
+    this.type = cubemap ? CHOKS_TEXTURETYPE_CUBEMAP : CHOKS_TEXTURETYPE_2D;
+    this.width = header->width;
+    this.height = header->height;
+
+    glGenTextures(1, &this.id);
+    choks_bind_texture(target, this.id);
+
+    // no decode, straight out of the page cache
+    for (uint32_t level = 0; level < header->levels; level++)
+    {
+        for (uint32_t face = 0; face < header->faces; face++)
+        {
+            const ctex_level_t* entry = &table[level * header->faces + face];
+            glTexImage2D(
+                cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D,
+                level,
+                GL_RGBA,
+                ctex_level_dimension(header->width, level),
+                ctex_level_dimension(header->height, level),
+                0,
+                GL_RGBA,
+                GL_UNSIGNED_BYTE,
+                data + entry->offset
+            );
+        }
+    }
+
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, header->levels - 1);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    GLenum wrap = cubemap ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap);
+    if (cubemap) glTexParameteri(target, GL_TEXTURE_WRAP_R, wrap);
+
+    asset_close(&file);
+    return this;
+}
+
+// IMAGES
+// ------
+image_t image_load_from_mem(const unsigned char* data, size_t size)
+{
+    image_t this = { 0 };
+
+    // use webp decode to load img and flip it (straight into our own buffer)
+    WebPDecoderConfig config;
+    WebPInitDecoderConfig(&config);
+
+    if (WebPGetFeatures(data, size, &config.input) != VP8_STATUS_OK)
+    {
+        return this;
+    }
+
+    int width = config.input.width;
+    int height = config.input.height;
+    unsigned char* pixels = malloc((size_t) width * height * 4);
+    if (!pixels) return this;
+
+    config.output.colorspace = MODE_RGBA;
+    config.output.is_external_memory = 1;
+    config.output.u.RGBA.rgba = pixels;
+    config.output.u.RGBA.stride = width * 4;
+    config.output.u.RGBA.size = (size_t) width * height * 4;
+
+    config.options.flip = 1;
+
+    if (WebPDecode(data, size, &config) != VP8_STATUS_OK)
+    {
+        free(pixels);
+        return this;
+    }
+
+    this.pixels = pixels;
+    this.width = width;
+    this.height = height;
+    return this;
+}
+
+image_t image_load_from_file(const char* path)
+{
+    image_t this = { 0 };
+
+    asset_t file = asset_open(path);
+
+    if (!file.data)
+    {
+        choks_debug_printf("invalid file\n");
+        return this;
+    }
+
+    this = image_load_from_mem(file.data, file.size);
+    if (!this.pixels) choks_debug_printf("failed to parse %s (not webp?)\n", path);
+
+    asset_close(&file);
+    return this;
+}
+
+void image_free(image_t* this)
+{
+    free(this->pixels);
+    this->pixels = nil;
+}
+
+texture_t texture_load_2d_from_image(image_t* image)
+{
+    texture_t this = { 0 };
+    this.type = CHOKS_TEXTURETYPE_2D;
+
+    if (!image->pixels) return this;
+
+    // A.O.K. proceed to load to gl
+    this.width = image->width;
+    this.height = image->height;
+
+    glGenTextures(1, &this.id);
+    choks_bind_texture(GL_TEXTURE_2D, this.id);
+
+    glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        GL_RGBA,
+        this.width,
+        this.height,
+        0,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        image->pixels
+    );
+
+    glGenerateMipmap(GL_TEXTURE_2D); // cooked textures ship their own
+
+    // image configs TODO: make these texture filtering settings configurable etc. etc.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    return this;
+}
+
+texture_t texture_load_2d_from_mem(const unsigned char* data, size_t size)
+{
+    image_t image = image_load_from_mem(data, size);
+    texture_t this = texture_load_2d_from_image(&image);
+    image_free(&image);
+
+    return this;
+}
+
+// prefers the cooked .ctex next to path, decodes the webp if there is none
+texture_t texture_load_2d_from_file(const char* path)
+{
+    char cooked[256];
+    _cooked_path(path, cooked, sizeof(cooked));
+
+    texture_t cooked_texture = texture_load_cooked(cooked);
+    if (cooked_texture.id && cooked_texture.type == CHOKS_TEXTURETYPE_2D) return cooked_texture;
+    if (cooked_texture.id) texture_free(cooked_texture);
+
+    choks_debug_printf("no cooked texture for %s, decoding\n", path);
+
+    image_t image = image_load_from_file(path);
+    texture_t this = texture_load_2d_from_image(&image);
+    image_free(&image);
+
+    return this;
+}
+
+
+// cubemap faces are independent frames, so they decode as separate jobs
+struct _cubemap_face_s
+{
+    const uint8_t* data;
+    size_t size;
+
+    uint8_t* out;
+    size_t out_size;
+    int stride;
 
-        WebPAnimDecoderDelete(decoder);
+    int ok;
+};
+
+static void _cubemap_face_worker(void* ptr, int first, int count)
+{
+    struct _cubemap_face_s* faces = ptr;
+    for (int i = first; i < first + count; i++)
+    {
+        faces[i].ok = WebPDecodeRGBAInto(faces[i].data, faces[i].size, faces[i].out, faces[i].out_size, faces[i].stride) != nil;
     }
-    else
+}
+
+static int _cubemap_decode_parallel(struct _cubemap_face_s* faces)
+{
+    job_counter_t done = { 0 };
+    job_parallel_for(_cubemap_face_worker, faces, 6, 1, &done);
+    job_wait(&done); // we decode some ourselves meanwhile
+
+    int ok = 1;
+    for (int i = 0; i < 6; i++) ok &= faces[i].ok;
+    return ok;
+}
+
+// fallback for files with partial/blended frames, WebPAnimDecoder composites them one by one
+static int _cubemap_decode_composited(const WebPData* webp_data, uint8_t* pixels, size_t face_size)
+{
+    WebPAnimDecoderOptions decoder_options;
+    WebPAnimDecoderOptionsInit(&decoder_options);
+    decoder_options.color_mode = MODE_RGBA;
+
+    WebPAnimDecoder* decoder = WebPAnimDecoderNew(webp_data, &decoder_options);
+    if (!decoder) return 0;
+
+    int index = 0;
+    while (index < 6 && WebPAnimDecoderHasMoreFrames(decoder))
+    {
+        uint8_t* buf;
+        int timestamp;
+        if (!WebPAnimDecoderGetNext(decoder, &buf, &timestamp)) break; // this buffer is rgba
+
+        memcpy(pixels + face_size * index, buf, face_size);
+        index++;
+    }
+
+    WebPAnimDecoderDelete(decoder);
+    return index == 6;
+}
+
+texture_t texture_load_cubemap_from_file(const char* path)
+{
+    char cooked[256];
+    _cooked_path(path, cooked, sizeof(cooked));
+
+    texture_t this = texture_load_cooked(cooked);
+    if (this.id && this.type == CHOKS_TEXTURETYPE_CUBEMAP) return this;
+    if (this.id) texture_free(this);
+
+    choks_debug_printf("no cooked cubemap for %s, decoding\n", path);
+
+    this = (texture_t) { 0 };
+    this.type = CHOKS_TEXTURETYPE_CUBEMAP;
+    
+    // load image
+    asset_t file = asset_open(path);
+
+    if (!file.data)
     {
         choks_debug_printf("file not found!!!\n");
         return this;
     }
 
+    choks_debug_printf("loaded file %s, size %i\n", path, (int) file.size);
+
+    double decode_start = _time_ms();
+
+    WebPData webp_data = { file.data, file.size };
+    WebPDemuxer* demux = WebPDemux(&webp_data);
+    uint8_t* pixels = nil;
+
+    if (!demux)
+    {
+        choks_debug_printf("demuxer did not parse webp.\n");
+        goto done;
+    }
+
+    int width = WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH);
+    int height = WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT);
+
+    // checks
+    if (WebPDemuxGetI(demux, WEBP_FF_FRAME_COUNT) != 6)
+    {
+        choks_debug_printf("cubemap webp does not have EXACTLY 6 frames.\n");
+        goto done;
+    }
+
+    if (width <= 0 || width != height)
+    {
+        choks_debug_printf("cubemap webp canvas is %ix%i, faces need to be square.\n", width, height);
+        goto done;
+    }
+
+    // after checks are done.
+    size_t face_size = (size_t) width * height * 4;
+    pixels = malloc(face_size * 6);
+    if (!pixels) goto done;
+
+    struct _cubemap_face_s faces[6];
+    int composite = 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+        WebPIterator iter;
+        if (!WebPDemuxGetFrame(demux, i + 1, &iter)) goto done;
+
+        // frames that dont cover the whole canvas or blend onto the previous one need the anim decoder
+        if (iter.x_offset || iter.y_offset || iter.width != width || iter.height != height) composite = 1;
+        if (i > 0 && iter.has_alpha && iter.blend_method == WEBP_MUX_BLEND) composite = 1;
+
+        faces[i] = (struct _cubemap_face_s) { iter.fragment.bytes, iter.fragment.size, pixels + face_size * i, face_size, width * 4, 0 };
+        WebPDemuxReleaseIterator(&iter);
+    }
+
+    int decoded = composite ? _cubemap_decode_composited(&webp_data, pixels, face_size) : _cubemap_decode_parallel(faces);
+    if (!decoded)
+    {
+        choks_debug_printf("failed to decode cubemap faces.\n");
+        goto done;
+    }
+
+    double upload_start = _time_ms();
+
+    this.width = width;
+    this.height = height;
+
+    // NOW generate opengl cubemap texture.
+    glGenTextures(1, &this.id);
+    choks_bind_texture(GL_TEXTURE_CUBE_MAP, this.id);
+
+    if (GLAD_GL_ARB_texture_storage) glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA8, width, height); // one immutable allocation
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (GLAD_GL_ARB_texture_storage)
+        {
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels + face_size * i);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels + face_size * i);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    choks_debug_printf("%s: decode %.2fms (%s), upload %.2fms\n", path, upload_start - decode_start, composite ? "composited" : "parallel", _time_ms() - upload_start);
+
     done:
-    free((void*) data);
+    free(pixels);
+    if (demux) WebPDemuxDelete(demux);
+    asset_close(&file);
     return this;
 }
 
 void texture_free(texture_t this)
 {
-    glDeleteTextures(1, &this.id);
-}
\ No newline at end of file
+    choks_delete_texture(this.id);
+}
+
+// ASYNC TEXTURES
+// --------------
+static void _texture_job_free_file(struct choks_texture_job_s* job)
+{
+    asset_close(&job->file);
+    job->cooked = 0;
+}
+
+// cooked: levels straight out of the mapped file. webp: level 0 only, mips get generated after the upload
+static int _texture_job_read(struct choks_texture_job_s* job)
+{
+    char cooked_path[256];
+    _cooked_path(job->path, cooked_path, sizeof(cooked_path));
+
+    asset_t cooked = asset_open(cooked_path);
+    const ctex_header_t* header = cooked.data ? _ctex_validate(cooked.data, cooked.size, CTEX_TYPE_2D) : nil;
+
+    if (header)
+    {
+        const ctex_level_t* table = (const ctex_level_t*) (header + 1);
+
+        job->file = cooked;
+        job->cooked = 1;
+        job->width = header->width;
+        job->height = header->height;
+        job->levels = header->levels;
+
+        for (int i = 0; i < job->levels; i++) job->level_offsets[i] = table[i].offset - table[0].offset;
+        job->buffer_size = table[job->levels - 1].offset + table[job->levels - 1].size - table[0].offset;
+        return 1;
+    }
+    asset_close(&cooked);
+
+    job->file = asset_open(job->path);
+
+    int width, height;
+    if (!job->file.data || !WebPGetInfo(job->file.data, job->file.size, &width, &height)) return 0;
+
+    job->width = width;
+    job->height = height;
+    job->levels = 1;
+    job->level_offsets[0] = 0;
+    job->buffer_size = (size_t) width * height * 4;
+    return 1;
+}
+
+static void _job_queue_push(struct choks_job_queue_s* queue, int job)
+{
+    queue->items[(queue->head + queue->count) % CHOKS_MAX_ASYNC_TEXTURES] = job;
+    queue->count++;
+}
+
+static int _job_queue_pop(struct choks_job_queue_s* queue)
+{
+    if (!queue->count) return -1;
+
+    int job = queue->items[queue->head];
+    queue->head = (queue->head + 1) % CHOKS_MAX_ASYNC_TEXTURES;
+    queue->count--;
+    return job;
+}
+
+// one step of one texture (read or decode), data is the job index
+static void _texture_worker(void* ptr, int first, int count)
+{
+    struct choks_textures_s* textures = &choks.textures;
+
+    int index = (int) (intptr_t) ptr;
+    struct choks_texture_job_s* job = &textures->jobs[index];
+
+    // the result stays private until the end, the render thread only looks at state once its in done
+    int state = job->state;
+    if (state == CHOKS_ASYNC_READ)
+    {
+        state = _texture_job_read(job) ? CHOKS_ASYNC_NEEDS_BUFFER : CHOKS_ASYNC_FAILED;
+    }
+    else if (state == CHOKS_ASYNC_DECODE && job->cooked)
+    {
+        const ctex_level_t* table = (const ctex_level_t*) ((const ctex_header_t*) job->file.data + 1);
+        memcpy(job->mapped, job->file.data + table[0].offset, job->buffer_size);
+        state = CHOKS_ASYNC_DECODED;
+    }
+    else if (state == CHOKS_ASYNC_DECODE)
+    {
+        WebPDecoderConfig config;
+        WebPInitDecoderConfig(&config);
+
+        config.output.colorspace = MODE_RGBA;
+        config.output.is_external_memory = 1;
+        config.output.u.RGBA.rgba = job->mapped;
+        config.output.u.RGBA.stride = job->width * 4;
+        config.output.u.RGBA.size = (size_t) job->width * job->height * 4;
+        config.options.flip = 1;
+
+        state = WebPDecode(job->file.data, job->file.size, &config) == VP8_STATUS_OK ? CHOKS_ASYNC_DECODED : CHOKS_ASYNC_FAILED;
+    }
+
+    if (state != CHOKS_ASYNC_NEEDS_BUFFER) _texture_job_free_file(job);
+
+    // last touch, published together with the hand back
+    pthread_mutex_lock(&textures->mutex);
+    job->state = state;
+    _job_queue_push(&textures->done, index);
+    pthread_mutex_unlock(&textures->mutex);
+}
+
+// background so a decode never lands on the render thread while it waits on frame jobs
+static void _texture_job_start(int index)
+{
+    choks.textures.jobs[index].busy = 1;
+    job_submit_background(_texture_worker, (void*) (intptr_t) index, &choks.textures.in_flight);
+}
+
+static void _texture_async_setup()
+{
+    static const unsigned char white[4] = { 255, 255, 255, 255 };
+
+    glGenTextures(1, &choks.textures.placeholder);
+    choks_bind_texture(GL_TEXTURE_2D, choks.textures.placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    pthread_mutex_init(&choks.textures.mutex, NULL);
+    choks.textures.in_flight.remaining = 0;
+
+    choks.textures.exhausted.type = CHOKS_TEXTURETYPE_2D;
+    choks.textures.exhausted.id = choks.textures.placeholder;
+    choks.textures.exhausted.width = 1;
+    choks.textures.exhausted.height = 1;
+}
+
+// frees the staging data but keeps the handle
+static void _texture_job_drop(struct choks_texture_job_s* job)
+{
+    if (job->pbo)
+    {
+        choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+        if (job->mapped) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        choks_delete_buffer(job->pbo);
+    }
+
+    _texture_job_free_file(job);
+
+    job->pbo = 0;
+    job->mapped = nil;
+}
+
+static void _texture_job_release(struct choks_texture_job_s* job)
+{
+    _texture_job_drop(job);
+    if (job->released && job->real_id) choks_delete_texture(job->real_id);
+
+    memset(job, 0, sizeof(*job)); // CHOKS_ASYNC_FREE
+}
+
+static void _texture_async_cleanup()
+{
+    // let the running steps finish, their results just get thrown away below
+    job_wait(&choks.textures.in_flight);
+
+    for (int i = 0; i < CHOKS_MAX_ASYNC_TEXTURES; i++)
+    {
+        struct choks_texture_job_s* job = &choks.textures.jobs[i];
+        if (job->state == CHOKS_ASYNC_FREE) continue;
+
+        job->released = 1; // everything goes
+        _texture_job_release(job);
+    }
+
+    pthread_mutex_destroy(&choks.textures.mutex);
+
+    choks_delete_texture(choks.textures.placeholder);
+}
+
+texture_t* texture_load_2d_async(const char* path)
+{
+    int index = -1;
+    for (int i = 0; i < CHOKS_MAX_ASYNC_TEXTURES; i++)
+    {
+        if (!choks.textures.jobs[i].busy && choks.textures.jobs[i].state == CHOKS_ASYNC_FREE)
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (index < 0)
+    {
+        choks_debug_printf("out of async texture slots (CHOKS_MAX_ASYNC_TEXTURES), %s stays a placeholder\n", path);
+        return &choks.textures.exhausted;
+    }
+
+    struct choks_texture_job_s* job = &choks.textures.jobs[index];
+    memset(job, 0, sizeof(*job));
+
+    job->texture.type = CHOKS_TEXTURETYPE_2D;
+    job->texture.id = choks.textures.placeholder;
+    job->texture.width = 1;
+    job->texture.height = 1;
+
+    snprintf(job->path, sizeof(job->path), "%s", path);
+    job->state = CHOKS_ASYNC_READ;
+
+    _texture_job_start(index);
+
+    return &job->texture;
+}
+
+static struct choks_texture_job_s* _texture_job_from_handle(texture_t* this)
+{
+    // the handle points into the job table
+    char* base = (char*) choks.textures.jobs;
+    size_t offset = (char*) this - base;
+    if ((char*) this < base || offset >= sizeof(choks.textures.jobs)) return nil;
+
+    return &choks.textures.jobs[offset / sizeof(struct choks_texture_job_s)];
+}
+
+int texture_is_loaded(texture_t* this)
+{
+    if (this == &choks.textures.exhausted) return 0;
+
+    struct choks_texture_job_s* job = _texture_job_from_handle(this);
+    return job ? !job->busy && job->state == CHOKS_ASYNC_DONE : this->id != 0;
+}
+
+void texture_async_free(texture_t* this)
+{
+    struct choks_texture_job_s* job = _texture_job_from_handle(this);
+    if (!job) return;
+
+    // only once _texture_async_update has it back, otherwise the worker could still be using it
+    if (!job->busy && (job->state == CHOKS_ASYNC_DONE || job->state == CHOKS_ASYNC_FAILED))
+    {
+        if (job->real_id) choks_delete_texture(job->real_id);
+        job->real_id = 0;
+        _texture_job_release(job);
+        return;
+    }
+
+    // in flight, whoever gets it next cleans it up
+    job->released = 1;
+}
+
+static void _texture_async_update()
+{
+    // hand over whatever the workers finished
+    int finished[CHOKS_MAX_ASYNC_TEXTURES];
+    int finished_count = 0;
+
+    pthread_mutex_lock(&choks.textures.mutex);
+    int index;
+    while ((index = _job_queue_pop(&choks.textures.done)) >= 0) finished[finished_count++] = index;
+    pthread_mutex_unlock(&choks.textures.mutex);
+
+    for (int i = 0; i < finished_count; i++)
+    {
+        struct choks_texture_job_s* job = &choks.textures.jobs[finished[i]];
+        job->busy = 0;
+
+        if (job->released || job->state == CHOKS_ASYNC_FAILED)
+        {
+            if (job->state == CHOKS_ASYNC_FAILED) choks_debug_printf("async texture %s failed to load\n", job->path);
+
+            if (job->released) _texture_job_release(job);
+            else
+            {
+                // keep the slot around (still bound to the placeholder) until its freed
+                _texture_job_drop(job);
+            }
+            continue;
+        }
+
+        if (job->state == CHOKS_ASYNC_NEEDS_BUFFER)
+        {
+            // workers decode (or copy the cooked levels) straight into this
+            size_t size = job->buffer_size;
+
+            glGenBuffers(1, &job->pbo);
+            choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nil, GL_STREAM_DRAW);
+            job->mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            job->state = job->mapped ? CHOKS_ASYNC_DECODE : CHOKS_ASYNC_FAILED;
+
+            if (job->mapped) _texture_job_start(finished[i]);
+            else
+            {
+                job->busy = 1;
+                pthread_mutex_lock(&choks.textures.mutex);
+                _job_queue_push(&choks.textures.done, finished[i]);
+                pthread_mutex_unlock(&choks.textures.mutex);
+            }
+        }
+        else if (job->state == CHOKS_ASYNC_DECODED)
+        {
+            choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            job->mapped = nil;
+
+            glGenTextures(1, &job->real_id);
+            choks_bind_texture(GL_TEXTURE_2D, job->real_id);
+            for (int level = 0; level < job->levels; level++)
+            {
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, ctex_level_dimension(job->width, level), ctex_level_dimension(job->height, level), 0, GL_RGBA, GL_UNSIGNED_BYTE, nil);
+            }
+
+            job->level = 0;
+            job->rows_uploaded = 0;
+            job->state = CHOKS_ASYNC_UPLOADING;
+            choks.textures.uploading[choks.textures.uploading_count++] = finished[i];
+        }
+    }
+
+    // upload a bounded amount, row bands at a time
+    size_t budget = CHOKS_UPLOAD_BUDGET;
+
+    int i = 0;
+    while (i < choks.textures.uploading_count && budget > 0)
+    {
+        struct choks_texture_job_s* job = &choks.textures.jobs[choks.textures.uploading[i]];
+
+        if (job->released)
+        {
+            _texture_job_release(job);
+            choks.textures.uploading[i] = choks.textures.uploading[--choks.textures.uploading_count];
+            continue;
+        }
+
+        int width = ctex_level_dimension(job->width, job->level);
+        int height = ctex_level_dimension(job->height, job->level);
+
+        size_t row_size = (size_t) width * 4;
+        int rows = (int) (budget / row_size);
+        if (rows < 1) rows = 1; // always make progress
+        if (rows > height - job->rows_uploaded) rows = height - job->rows_uploaded;
+
+        size_t offset = job->level_offsets[job->level] + row_size * job->rows_uploaded;
+
+        choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, job->pbo);
+        choks_bind_texture(GL_TEXTURE_2D, job->real_id);
+        glTexSubImage2D(GL_TEXTURE_2D, job->level, 0, job->rows_uploaded, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (void*) offset);
+        choks_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        job->rows_uploaded += rows;
+        budget = (size_t) rows * row_size >= budget ? 0 : budget - (size_t) rows * row_size;
+
+        if (job->rows_uploaded == height && job->level + 1 < job->levels)
+        {
+            job->level++;
+            job->rows_uploaded = 0;
+        }
+
+        if (job->rows_uploaded < height || job->level + 1 < job->levels)
+        {
+            continue; // out of budget, keep going next frame
+        }
+
+        // done: swap the handle over from the placeholder
+        if (job->levels == 1) glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, job->levels == 1 ? 1000 : job->levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        choks_delete_buffer(job->pbo);
+        job->pbo = 0;
+
+        job->texture.id = job->real_id;
+        job->texture.width = job->width;
+        job->texture.height = job->height;
+        job->state = CHOKS_ASYNC_DONE;
+
+        choks.textures.uploading[i] = choks.textures.uploading[--choks.textures.uploading_count];
+    }
+}
@@ -10,14 +10,110 @@
 #define CHOKS_WIDTH 1280
 #define CHOKS_HEIGHT 800
 
+#define CHOKS_FRAMES_IN_FLIGHT 3
+#define CHOKS_STREAM_SIZE (4 * 1024 * 1024) // bytes of streaming memory per frame in flight
+#define CHOKS_STREAM_PERSISTENT 1 // map the ring once for good when GL_ARB_buffer_storage is there, 0 forces the cpu copy path
+
+#define CHOKS_PROGRAM_CACHE 1 // store linked program binaries on disk (needs GL_ARB_get_program_binary)
+#define CHOKS_PROGRAM_CACHE_DIR "cache" // relative to the content directory
+#define CHOKS_MAX_PENDING_PROGRAMS 64
+
+#define CHOKS_ASSET_PACK "content.pak" // relative to the content directory, built by tooling/pack.c
+#define CHOKS_LOOSE_ASSETS 1 // loose files override the pack, turn off on shipping builds to skip a stat per load
+
+#define CHOKS_MAX_ASYNC_TEXTURES 1024
+#define CHOKS_UPLOAD_BUDGET (8 * 1024 * 1024) // bytes of async texture data uploaded per frame
+
+#define CHOKS_STATE_VALIDATE 0 // check the gl state cache against glGet* after every call. slow, for hunting desyncs
+#define CHOKS_STATE_TEXTURE_UNITS 8 // units above this arent cached
+#define CHOKS_STATE_UNIFORM_BINDINGS 8
+
+#define CHOKS_ARENA_BLOCK_VERTICES (1024 * 1024) // per shared vertex buffer, bigger meshes get a block of their own
+#define CHOKS_ARENA_BLOCK_INDICES (4 * 1024 * 1024)
+
 #include <glad/gl.h>
 #include "external/HandmadeMath.h"
+#include "vertex.h"
 
 // setup/cleanup
 // -------------
 extern void setup_choks();
 extern void cleanup_choks();
 
+extern void choks_end_frame(); // call once per frame after swapping (fences + recycles streaming memory, uploads async textures)
+
+// ASSETS
+// ------
+// zero copy views into the mmapped pack (or a loose file read into memory when overridden).
+// data is always '\0' terminated, size doesnt count it.
+typedef struct
+{
+    const unsigned char* data;
+    size_t size;
+    int owned; // loose file, asset_close frees it
+} asset_t;
+
+extern asset_t asset_open(const char* path); // relative to the content directory. data is NULL if not found
+extern void asset_close(asset_t* this);
+
+// STREAMING BUFFER
+// ----------------
+// one ring buffer split into CHOKS_FRAMES_IN_FLIGHT segments, each guarded by a fence.
+// anything allocated from here is only valid for the frame it was allocated in,
+// so its good for per-draw/per-frame data (matrices, text, sprites, lights, etc.)
+//
+// with GL_ARB_buffer_storage the ring stays mapped and writes go straight to the gpu, mapping
+// costs nothing. without it writes land in a cpu copy of the segment and stream_unmap uploads
+// them, unless a batch is open: then everything up to stream_batch_end goes up in one call.
+typedef struct stream_range_s
+{
+    unsigned int buffer;
+    unsigned int offset;
+    unsigned int size;
+} stream_range_t;
+
+#define CHOKS_STREAM_ALIGN_UNIFORM 0 // pass as alignment to get GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+
+extern void* stream_map(unsigned int size, unsigned int alignment, stream_range_t* range); // write, then stream_unmap() before drawing
+extern void stream_unmap();
+extern void stream_batch_begin(); // defer uploads: fill everything, stream_batch_end, then draw
+extern void stream_batch_end();
+extern stream_range_t stream_upload(const void* data, unsigned int size, unsigned int alignment);
+extern stream_range_t stream_bind_uniform(const void* data, unsigned int size, unsigned int binding);
+
+// GL STATE CACHE
+// --------------
+// shadows the gl state we touch all the time and skips calls that wouldnt change anything.
+// use these instead of the raw gl calls, or call choks_state_invalidate() after something
+// changes state behind the cache's back.
+typedef struct choks_state_stats_s
+{
+    int issued, elided;
+} choks_state_stats_t;
+
+extern void choks_use_program(unsigned int program);
+extern void choks_bind_vertex_array(unsigned int vao);
+extern void choks_active_texture(unsigned int unit); // GL_TEXTURE0 + n
+extern void choks_bind_texture(unsigned int target, unsigned int texture); // on the active unit
+extern void choks_bind_buffer(unsigned int target, unsigned int buffer);
+extern void choks_bind_buffer_range(unsigned int target, unsigned int index, unsigned int buffer, unsigned int offset, unsigned int size);
+extern void choks_enable(unsigned int cap, int enabled);
+extern int choks_is_enabled(unsigned int cap); // from the cache, no glIsEnabled for the cached caps
+extern void choks_blend_func(unsigned int source, unsigned int destination);
+extern void choks_depth_func(unsigned int func);
+extern void choks_depth_mask(int write);
+extern void choks_viewport(int x, int y, int width, int height);
+
+// deleting through these keeps a dead (and possibly reused) name from looking bound
+extern void choks_delete_program(unsigned int program);
+extern void choks_delete_vertex_array(unsigned int vao);
+extern void choks_delete_buffer(unsigned int buffer);
+extern void choks_delete_texture(unsigned int texture);
+
+extern void choks_state_invalidate(); // forget everything, the next call of each kind always goes through
+extern int choks_state_validate(); // compares the shadow with glGet*, prints and returns the number of mismatches
+extern choks_state_stats_t choks_state_stats(); // of the last frame
+
 // state machine :D
 // ----------------
 
@@ -25,21 +121,52 @@ extern void cleanup_choks();
 // layout (std140) uniform mvp
 // {
 //     mat4 model;
+//     vec4 position_scale; // quantized positions (see vertex.h): position * scale + bias
+//     vec4 position_bias;
+// };
+//
+// layout (std140) uniform viewprojection
+// {
 //     mat4 view;
 //     mat4 projection;
 // };
+//
+// and for instancing, a per instance model matrix on top of the mvp one. outside of instanced
+// draws the attribute is disabled and reads back the identity, so shaders can always use
+// projection * view * model * instance_model:
+// layout (location = 8) in mat4 instance_model;
+#define CHOKS_BINDING_MODEL 0
+#define CHOKS_BINDING_VIEWPROJECTION 1
+#define CHOKS_BINDING_LIGHTING 2 // lolita.h
+#define CHOKS_ATTRIB_INSTANCE_MODEL 8 // takes 8 - 11
 
-extern void set_model_matrix(mat4_t model);
+extern void set_model_matrix(mat4_t model); // identity position decode
+extern void set_model_matrix_decoded(mat4_t model, vertex_decode_t decode);
+extern void set_model_matrix_faded(mat4_t model, vertex_decode_t decode, float lod_fade); // dithered lod transitions, see lod_fade in upper_graphics.h
+extern stream_range_t stream_model_block(mat4_t model, vertex_decode_t decode, float lod_fade); // write a model block now and bind it later, for filling a whole batch up front
+extern void set_model_block(stream_range_t block, mat4_t model, vertex_decode_t decode, float lod_fade); // same values it was streamed with, they feed the elision
 extern void set_view_and_projection_matrices(mat4_t view, mat4_t projection);
 
 // PRIMITIVES
 // ----------
+// every primitive lives in the geometry arena (below), so vao/vbo/ibo are shared with the
+// other primitives in the same block and base_vertex/first_index say where this one starts.
 typedef struct primitive_s
 {
     unsigned int vao, vbo, ibo;
     int draw_mode;
     int vertex_count;
     int index_count;
+    unsigned int index_type; // GL_UNSIGNED_SHORT whenever the vertices fit, else GL_UNSIGNED_INT
+    int index_size; // bytes, 2 or 4
+
+    vertex_layout_t layout;
+    vertex_decode_t decode; // pass to set_model_matrix_decoded when drawing
+
+    int allocation; // arena handle, 0 for none
+    int base_vertex, first_index; // can go stale after a defragment, see primitive_locate. first_index is in index_size units
+
+    vec3_t min, max; // object space bounds, worked out from the vertices at load
 } primitive_t;
 
 typedef struct primitive_std_vertex_s
@@ -50,9 +177,59 @@ typedef struct primitive_std_vertex_s
 
 extern primitive_t primitive_load(float* data, int vertex_count, int draw_mode); // vertex: xyzst.
 extern primitive_t primitive_load_with_indices(float* vertices, int vertex_count, unsigned int* indices, int index_count, int draw_mode);
+extern primitive_t primitive_load_vertices(const vertex_t* vertices, int vertex_count, const unsigned int* indices, int index_count, int draw_mode, vertex_layout_t layout); // packs into layout
+extern primitive_t primitive_load_packed(const void* vertices, int vertex_count, const void* indices, int index_count, int index_size, int draw_mode, vertex_layout_t layout, vertex_decode_t decode); // already packed (cooked). 4 byte indices get narrowed when they can be
 extern void primitive_free(primitive_t* this);
 
 extern void primitive_draw(primitive_t* this);
+extern void primitive_locate(primitive_t* this); // refresh buffers/offsets of a copy from the arena. the draw functions do this themselves
+
+static inline void* primitive_index_offset(const primitive_t* this, int first_index) // element pointer for a draw starting first_index into the primitive
+{
+    return (void*) (uintptr_t) ((size_t) this->index_size * (this->first_index + first_index));
+}
+
+// GEOMETRY ARENA
+// --------------
+// vertex and index ranges are sub allocated (first fit, coalescing free list) from a few big
+// buffers with one vao per block and vertex layout, so going from mesh to mesh in the same
+// block is just a different base vertex. a block that cant fit a new mesh but has enough free space in total
+// gets packed before another block is made. index ranges are counted in 4 byte slots so
+// 16 and 32 bit indices can share a buffer.
+typedef struct geometry_arena_stats_s
+{
+    int blocks, allocations;
+    int vertices_used, vertices_capacity;
+    int indices_used, indices_capacity; // 4 byte slots, two 16 bit indices each
+    int free_ranges; // fragmentation, at most 2 per block when packed
+} geometry_arena_stats_t;
+
+extern void geometry_arena_defragment(); // packs every block, allocations move but keep their handles
+extern geometry_arena_stats_t geometry_arena_stats();
+
+// INSTANCING
+// ----------
+// one model matrix per instance, either in its own buffer (things that dont move) or
+// streamed for the current frame only.
+typedef struct instance_buffer_s
+{
+    unsigned int buffer;
+    unsigned int offset; // bytes
+    int count;
+    int owned; // 0 for stream ranges, those dont get freed
+} instance_buffer_t;
+
+extern instance_buffer_t instance_buffer_load(const mat4_t* models, int count);
+extern instance_buffer_t instance_buffer_stream(const mat4_t* models, int count); // valid this frame only
+extern void instance_buffer_update(instance_buffer_t* this, const mat4_t* models, int first, int count); // loaded buffers only
+extern void instance_buffer_free(instance_buffer_t* this);
+
+// points the instance attributes of the bound vao at this / turns them back off. for custom
+// draws, primitive_draw_instanced does both
+extern void instance_buffer_bind(const instance_buffer_t* this);
+extern void instance_buffer_unbind();
+
+extern void primitive_draw_instanced(primitive_t* this, const instance_buffer_t* instances);
 
 // PROGRAMS
 // --------
@@ -66,9 +243,17 @@ extern program_t program_load_from_source(const char* vertex_source, const char*
 extern program_t program_load_from_source_ex(const char* vertex_source, const char* fragment_source);
 extern void program_free(program_t this);
 
+// batch loading: between begin and end, loads only submit the compile/link and return right away.
+// the ids are valid immediately, but dont touch the programs (uniforms etc.) until program_batch_end.
+extern void program_batch_begin();
+extern int program_batch_poll(); // finishes what the driver is done with, returns how many are still pending
+extern void program_batch_end(); // waits for + finishes everything
+
+extern void program_cache_report(); // prints how many programs were loaded/cached and how long it took
+
 // TEXTURES
 // --------
-// i think for this one ill be sticking to .webp
+// .webp for authoring, cooked .ctex (src/ctex.h) for shipping
 typedef enum
 {
     CHOKS_TEXTURETYPE_2D,
@@ -82,7 +267,28 @@ typedef struct
     int width, height;
 } texture_t;
 
-extern texture_t texture_load_2d_from_mem(unsigned char* data);
+// cpu side rgba8 pixels, flipped for gl
+typedef struct
+{
+    unsigned char* pixels;
+    int width, height;
+} image_t;
+
+extern image_t image_load_from_mem(const unsigned char* data, size_t size);
+extern image_t image_load_from_file(const char* path);
+extern void image_free(image_t* this);
+
+extern texture_t texture_load_2d_from_image(image_t* image);
+extern texture_t texture_load_2d_from_mem(const unsigned char* data, size_t size);
 extern texture_t texture_load_2d_from_file(const char* path);
-extern texture_t texture_load_cubemap_from_file(const char* path);
-extern void texture_free(texture_t this);
\ No newline at end of file
+extern texture_t texture_load_cubemap_from_file(const char* path); // both of these use the cooked .ctex next to path when there is one
+extern texture_t texture_load_cooked(const char* path); // .ctex from tooling/texcook.c, mipped, no decode
+extern void texture_free(texture_t this);
+
+// async loading: the returned handle is valid right away and binds a 1x1 white placeholder
+// until its decoded on a worker thread and uploaded (CHOKS_UPLOAD_BUDGET bytes per frame).
+// always read ->id when binding, it changes once the real texture is in. never NULL: with
+// every CHOKS_MAX_ASYNC_TEXTURES slot taken you get a handle that stays on the placeholder.
+extern texture_t* texture_load_2d_async(const char* path);
+extern int texture_is_loaded(texture_t* this);
+extern void texture_async_free(texture_t* this);
\ No newline at end of file
@@ -1,4 +1,13 @@
 #include "upper_graphics.h"
+#include "jobs.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#if defined(__AVX__) || defined(__SSE__) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // little transform/camera utilities - moved from turan_choks.c
 // ------------------------------------------------------------
@@ -22,6 +31,433 @@ mat4_t transform_to_matrix(transform_t* this)
     return matrix;
 }
 
+void transforms_to_matrices(transform_t* transforms, int count, mat4_t* out)
+{
+    for (int i = 0; i < count; i++) out[i] = transform_to_matrix(&transforms[i]);
+}
+
+// FRUSTUM CULLING
+// ---------------
+frustum_t frustum_from_matrix(mat4_t m)
+{
+    // gribb/hartmann: planes are sums/differences of the clip matrix rows.
+    // m.elements is [column][row]
+    vec4_t rows[4];
+    for (int i = 0; i < 4; i++) rows[i] = HMM_Vec4(m.elements[0][i], m.elements[1][i], m.elements[2][i], m.elements[3][i]);
+
+    frustum_t this;
+    this.planes[0] = HMM_AddVec4(rows[3], rows[0]);
+    this.planes[1] = HMM_SubtractVec4(rows[3], rows[0]);
+    this.planes[2] = HMM_AddVec4(rows[3], rows[1]);
+    this.planes[3] = HMM_SubtractVec4(rows[3], rows[1]);
+    this.planes[4] = HMM_AddVec4(rows[3], rows[2]);
+    this.planes[5] = HMM_SubtractVec4(rows[3], rows[2]);
+
+    // normalized so the w + dot is an actual distance (spheres need that)
+    for (int i = 0; i < 6; i++) this.planes[i] = HMM_MultiplyVec4f(this.planes[i], 1.0f / HMM_LengthVec3(this.planes[i].xyz));
+
+    return this;
+}
+
+int frustum_test_sphere(const frustum_t* this, vec3_t center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (HMM_DotVec3(this->planes[i].xyz, center) + this->planes[i].w < -radius) return 0;
+    }
+
+    return 1;
+}
+
+int frustum_test_box(const frustum_t* this, vec3_t min, vec3_t max)
+{
+    vec3_t center = HMM_MultiplyVec3f(HMM_AddVec3(min, max), 0.5f);
+    vec3_t extent = HMM_MultiplyVec3f(HMM_SubtractVec3(max, min), 0.5f);
+
+    for (int i = 0; i < 6; i++)
+    {
+        vec4_t plane = this->planes[i];
+        float reach = fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+        if (HMM_DotVec3(plane.xyz, center) + plane.w < -reach) return 0;
+    }
+
+    return 1;
+}
+
+void bounds_transform(vec3_t min, vec3_t max, mat4_t transform, vec3_t* out_min, vec3_t* out_max)
+{
+    *out_min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    *out_max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    for (int i = 0; i < 8; i++)
+    {
+        vec4_t corner = HMM_Vec4(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f);
+        corner = HMM_MultiplyMat4ByVec4(transform, corner);
+
+        *out_min = HMM_Vec3(HMM_MIN(out_min->x, corner.x), HMM_MIN(out_min->y, corner.y), HMM_MIN(out_min->z, corner.z));
+        *out_max = HMM_Vec3(HMM_MAX(out_max->x, corner.x), HMM_MAX(out_max->y, corner.y), HMM_MAX(out_max->z, corner.z));
+    }
+}
+
+int cull_set_add(cull_set_t* this, vec3_t min, vec3_t max)
+{
+    if (this->count == this->capacity)
+    {
+        this->capacity = this->capacity ? this->capacity * 2 : 256;
+
+        float** arrays[] = { &this->center_x, &this->center_y, &this->center_z, &this->extent_x, &this->extent_y, &this->extent_z, &this->radius };
+        for (int i = 0; i < 7; i++) *arrays[i] = realloc(*arrays[i], sizeof(float) * this->capacity);
+        this->visible = realloc(this->visible, sizeof(int) * this->capacity);
+    }
+
+    vec3_t extent = HMM_MultiplyVec3f(HMM_SubtractVec3(max, min), 0.5f);
+
+    int index = this->count++;
+    this->center_x[index] = (min.x + max.x) * 0.5f;
+    this->center_y[index] = (min.y + max.y) * 0.5f;
+    this->center_z[index] = (min.z + max.z) * 0.5f;
+    this->extent_x[index] = extent.x;
+    this->extent_y[index] = extent.y;
+    this->extent_z[index] = extent.z;
+    this->radius[index] = HMM_LengthVec3(extent);
+
+    return index;
+}
+
+void cull_set_clear(cull_set_t* this)
+{
+    this->count = 0;
+    this->visible_count = 0;
+}
+
+void cull_set_free(cull_set_t* this)
+{
+    free(this->center_x);
+    free(this->center_y);
+    free(this->center_z);
+    free(this->extent_x);
+    free(this->extent_y);
+    free(this->extent_z);
+    free(this->radius);
+    free(this->visible);
+    memset(this, 0, sizeof(*this));
+}
+
+static int _cull_one(const frustum_t* this, const cull_set_t* set, int i, int boxes)
+{
+    for (int p = 0; p < 6; p++)
+    {
+        vec4_t plane = this->planes[p];
+        float reach = boxes ? fabsf(plane.x) * set->extent_x[i] + fabsf(plane.y) * set->extent_y[i] + fabsf(plane.z) * set->extent_z[i] : set->radius[i];
+        if (plane.x * set->center_x[i] + plane.y * set->center_y[i] + plane.z * set->center_z[i] + plane.w < -reach) return 0;
+    }
+
+    return 1;
+}
+
+// every lane in [i, end) that survives all six planes gets appended to visible, in order
+static int _cull_range(const frustum_t* this, const cull_set_t* set, int boxes, int i, int end, int* visible)
+{
+    int visible_count = 0;
+
+#if defined(__AVX__)
+    __m256 plane[6][4], plane_abs[6][3];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int c = 0; c < 4; c++) plane[p][c] = _mm256_set1_ps(this->planes[p].elements[c]);
+        for (int c = 0; c < 3; c++) plane_abs[p][c] = _mm256_set1_ps(fabsf(this->planes[p].elements[c]));
+    }
+
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(set->center_x + i);
+        __m256 y = _mm256_loadu_ps(set->center_y + i);
+        __m256 z = _mm256_loadu_ps(set->center_z + i);
+        __m256 ex = boxes ? _mm256_loadu_ps(set->extent_x + i) : _mm256_setzero_ps();
+        __m256 ey = boxes ? _mm256_loadu_ps(set->extent_y + i) : _mm256_setzero_ps();
+        __m256 ez = boxes ? _mm256_loadu_ps(set->extent_z + i) : _mm256_setzero_ps();
+        __m256 radius = boxes ? _mm256_setzero_ps() : _mm256_loadu_ps(set->radius + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane[p][0], x), _mm256_mul_ps(plane[p][1], y)), _mm256_add_ps(_mm256_mul_ps(plane[p][2], z), plane[p][3]));
+            __m256 reach = boxes ? _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_abs[p][0], ex), _mm256_mul_ps(plane_abs[p][1], ey)), _mm256_mul_ps(plane_abs[p][2], ez)) : radius;
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+            if (!_mm256_movemask_ps(inside)) break; // most groups are gone after a plane or two
+        }
+
+        unsigned int mask = _mm256_movemask_ps(inside);
+        while (mask)
+        {
+            visible[visible_count++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE__)
+    __m128 plane[6][4], plane_abs[6][3];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int c = 0; c < 4; c++) plane[p][c] = _mm_set1_ps(this->planes[p].elements[c]);
+        for (int c = 0; c < 3; c++) plane_abs[p][c] = _mm_set1_ps(fabsf(this->planes[p].elements[c]));
+    }
+
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(set->center_x + i);
+        __m128 y = _mm_loadu_ps(set->center_y + i);
+        __m128 z = _mm_loadu_ps(set->center_z + i);
+        __m128 ex = boxes ? _mm_loadu_ps(set->extent_x + i) : _mm_setzero_ps();
+        __m128 ey = boxes ? _mm_loadu_ps(set->extent_y + i) : _mm_setzero_ps();
+        __m128 ez = boxes ? _mm_loadu_ps(set->extent_z + i) : _mm_setzero_ps();
+        __m128 radius = boxes ? _mm_setzero_ps() : _mm_loadu_ps(set->radius + i);
+
+        __m128 inside = _mm_cmpeq_ps(x, x); // all ones unless nan, and a nan center shouldnt draw anyway
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[p][0], x), _mm_mul_ps(plane[p][1], y)), _mm_add_ps(_mm_mul_ps(plane[p][2], z), plane[p][3]));
+            __m128 reach = boxes ? _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_abs[p][0], ex), _mm_mul_ps(plane_abs[p][1], ey)), _mm_mul_ps(plane_abs[p][2], ez)) : radius;
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+            if (!_mm_movemask_ps(inside)) break; // most groups are gone after a plane or two
+        }
+
+        unsigned int mask = _mm_movemask_ps(inside);
+        while (mask)
+        {
+            visible[visible_count++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // leftovers (or everything, without simd)
+    for (; i < end; i++)
+    {
+        if (_cull_one(this, set, i, boxes)) visible[visible_count++] = i;
+    }
+
+    return visible_count;
+}
+
+struct _cull_job_s
+{
+    const frustum_t* frustum;
+    cull_set_t* set;
+    int boxes;
+    int chunk;
+    int counts[CULL_MAX_JOBS];
+};
+
+static void _cull_job(void* data, int first, int count)
+{
+    struct _cull_job_s* job = data;
+    for (int c = first; c < first + count; c++)
+    {
+        int start = c * job->chunk, end = HMM_MIN(start + job->chunk, job->set->count);
+        job->counts[c] = _cull_range(job->frustum, job->set, job->boxes, start, end, job->set->visible + start);
+    }
+}
+
+static int _cull(const frustum_t* this, cull_set_t* set, int boxes)
+{
+    if (set->count < CULL_PARALLEL_THRESHOLD || jobs_thread_count() == 1)
+    {
+        set->visible_count = _cull_range(this, set, boxes, 0, set->count, set->visible);
+        return set->visible_count;
+    }
+
+    // every chunk writes from its own start, then they get packed down in order
+    struct _cull_job_s job = { this, set, boxes };
+    job.chunk = HMM_MAX((set->count + CULL_MAX_JOBS - 1) / CULL_MAX_JOBS, CULL_PARALLEL_THRESHOLD / 4);
+    job.chunk = (job.chunk + 7) & ~7; // whole simd groups
+    int chunks = (set->count + job.chunk - 1) / job.chunk;
+
+    job_counter_t done = { 0 };
+    job_parallel_for(_cull_job, &job, chunks, 1, &done);
+    job_wait(&done);
+
+    int visible_count = job.counts[0];
+    for (int c = 1; c < chunks; c++)
+    {
+        memmove(set->visible + visible_count, set->visible + c * job.chunk, sizeof(int) * job.counts[c]);
+        visible_count += job.counts[c];
+    }
+
+    set->visible_count = visible_count;
+    return visible_count;
+}
+
+int frustum_cull_spheres(const frustum_t* this, cull_set_t* set)
+{
+    return _cull(this, set, 0);
+}
+
+int frustum_cull_boxes(const frustum_t* this, cull_set_t* set)
+{
+    return _cull(this, set, 1);
+}
+
+// SPHERES VS BOXES
+// ----------------
+int sphere_set_add(sphere_set_t* this, vec3_t center, float radius)
+{
+    if (this->count + SPHERE_SET_PAD > this->capacity)
+    {
+        this->capacity = this->capacity ? this->capacity * 2 : 256;
+
+        float** arrays[] = { &this->center_x, &this->center_y, &this->center_z, &this->radius_sq };
+        for (int i = 0; i < 4; i++) *arrays[i] = realloc(*arrays[i], sizeof(float) * this->capacity);
+    }
+
+    int index = this->count++;
+    this->center_x[index] = center.x;
+    this->center_y[index] = center.y;
+    this->center_z[index] = center.z;
+    this->radius_sq[index] = radius * radius;
+
+    // the next slot is padding until someone adds to it: distance is never below 0, so it never hits
+    int end = (this->count + SPHERE_SET_PAD - 1) & ~(SPHERE_SET_PAD - 1);
+    for (int i = this->count; i < end; i++)
+    {
+        this->center_x[i] = this->center_y[i] = this->center_z[i] = 0.0f;
+        this->radius_sq[i] = -1.0f;
+    }
+
+    return index;
+}
+
+void sphere_set_clear(sphere_set_t* this)
+{
+    this->count = 0;
+}
+
+void sphere_set_free(sphere_set_t* this)
+{
+    free(this->center_x);
+    free(this->center_y);
+    free(this->center_z);
+    free(this->radius_sq);
+    memset(this, 0, sizeof(*this));
+}
+
+// squared distance from the box per axis is max(min - p, 0) + max(p - max, 0), no branches
+static int _spheres_scalar(const sphere_set_t* this, vec3_t min, vec3_t max, unsigned int* hits, int max_hits)
+{
+    int hit_count = 0;
+    for (int i = 0; i < this->count && hit_count < max_hits; i++)
+    {
+        float dx = HMM_MAX(min.x - this->center_x[i], 0.0f) + HMM_MAX(this->center_x[i] - max.x, 0.0f);
+        float dy = HMM_MAX(min.y - this->center_y[i], 0.0f) + HMM_MAX(this->center_y[i] - max.y, 0.0f);
+        float dz = HMM_MAX(min.z - this->center_z[i], 0.0f) + HMM_MAX(this->center_z[i] - max.z, 0.0f);
+
+        if (dx * dx + dy * dy + dz * dz <= this->radius_sq[i])
+        {
+            if (hits) hits[hit_count] = i;
+            hit_count++;
+        }
+    }
+    return hit_count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+static int _spheres_sse2(const sphere_set_t* this, vec3_t min, vec3_t max, unsigned int* hits, int max_hits)
+{
+    __m128 min_x = _mm_set1_ps(min.x), min_y = _mm_set1_ps(min.y), min_z = _mm_set1_ps(min.z);
+    __m128 max_x = _mm_set1_ps(max.x), max_y = _mm_set1_ps(max.y), max_z = _mm_set1_ps(max.z);
+    __m128 zero = _mm_setzero_ps();
+
+    int hit_count = 0;
+    for (int i = 0; i < this->count; i += 4) // the padding covers the tail
+    {
+        __m128 x = _mm_loadu_ps(this->center_x + i);
+        __m128 y = _mm_loadu_ps(this->center_y + i);
+        __m128 z = _mm_loadu_ps(this->center_z + i);
+
+        __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(min_x, x), zero), _mm_max_ps(_mm_sub_ps(x, max_x), zero));
+        __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(min_y, y), zero), _mm_max_ps(_mm_sub_ps(y, max_y), zero));
+        __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(min_z, z), zero), _mm_max_ps(_mm_sub_ps(z, max_z), zero));
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+        unsigned int mask = _mm_movemask_ps(_mm_cmple_ps(distance, _mm_loadu_ps(this->radius_sq + i)));
+        while (mask)
+        {
+            if (hits) hits[hit_count] = i + __builtin_ctz(mask);
+            if (++hit_count == max_hits) return hit_count;
+            mask &= mask - 1;
+        }
+    }
+    return hit_count;
+}
+
+__attribute__((target("avx2")))
+static int _spheres_avx2(const sphere_set_t* this, vec3_t min, vec3_t max, unsigned int* hits, int max_hits)
+{
+    __m256 min_x = _mm256_set1_ps(min.x), min_y = _mm256_set1_ps(min.y), min_z = _mm256_set1_ps(min.z);
+    __m256 max_x = _mm256_set1_ps(max.x), max_y = _mm256_set1_ps(max.y), max_z = _mm256_set1_ps(max.z);
+    __m256 zero = _mm256_setzero_ps();
+
+    int hit_count = 0;
+    for (int i = 0; i < this->count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(this->center_x + i);
+        __m256 y = _mm256_loadu_ps(this->center_y + i);
+        __m256 z = _mm256_loadu_ps(this->center_z + i);
+
+        __m256 dx = _mm256_add_ps(_mm256_max_ps(_mm256_sub_ps(min_x, x), zero), _mm256_max_ps(_mm256_sub_ps(x, max_x), zero));
+        __m256 dy = _mm256_add_ps(_mm256_max_ps(_mm256_sub_ps(min_y, y), zero), _mm256_max_ps(_mm256_sub_ps(y, max_y), zero));
+        __m256 dz = _mm256_add_ps(_mm256_max_ps(_mm256_sub_ps(min_z, z), zero), _mm256_max_ps(_mm256_sub_ps(z, max_z), zero));
+        __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+        unsigned int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_loadu_ps(this->radius_sq + i), _CMP_LE_OQ));
+        while (mask)
+        {
+            if (hits) hits[hit_count] = i + __builtin_ctz(mask);
+            if (++hit_count == max_hits) return hit_count;
+            mask &= mask - 1;
+        }
+    }
+    return hit_count;
+}
+#endif
+
+typedef int (*_spheres_kernel_t)(const sphere_set_t* this, vec3_t min, vec3_t max, unsigned int* hits, int max_hits);
+static _spheres_kernel_t _spheres_kernel; // atomic, NULL until the first call
+
+int spheres_kernel(int level)
+{
+    int best = SIMD_SCALAR;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) best = SIMD_SSE2;
+    if (__builtin_cpu_supports("avx2")) best = SIMD_AVX2;
+#endif
+    if (level < 0 || level > best) level = best;
+
+    _spheres_kernel_t kernel = _spheres_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    if (level == SIMD_SSE2) kernel = _spheres_sse2;
+    if (level == SIMD_AVX2) kernel = _spheres_avx2;
+#endif
+
+    __atomic_store_n(&_spheres_kernel, kernel, __ATOMIC_RELEASE);
+    return level;
+}
+
+int spheres_touching_box(const sphere_set_t* this, vec3_t min, vec3_t max, unsigned int* hits, int max_hits)
+{
+    if (max_hits <= 0) return 0;
+
+    _spheres_kernel_t kernel = __atomic_load_n(&_spheres_kernel, __ATOMIC_ACQUIRE);
+    if (!kernel)
+    {
+        spheres_kernel(-1);
+        kernel = __atomic_load_n(&_spheres_kernel, __ATOMIC_ACQUIRE);
+    }
+
+    return kernel(this, min, max, hits, max_hits);
+}
+
 // CAMERA CAMERA CAMERA !!
 // -----------------------
 void camera_update_view(camera_t* this)
@@ -37,10 +473,65 @@ void camera_update_view(camera_t* this)
     static vec3_t up = (vec3_t) { 0.0f, 1.0f, 0.0f }; // TODO: IMPLEMENT CAMERA ROLLING.
 
     this->matrices.view = HMM_LookAt(this->transform.position, HMM_AddVec3(this->transform.position, this->front), up); // rotate some of this stuff
-    
+    this->frustum = frustum_from_matrix(HMM_MultiplyMat4(this->matrices.projection, this->matrices.view));
 }
 
 void camera_update_projection(camera_t* this)
 {
     this->matrices.projection = HMM_Perspective(this->fov / 2, this->aspect, this->near, this->far);
-}
\ No newline at end of file
+    this->frustum = frustum_from_matrix(HMM_MultiplyMat4(this->matrices.projection, this->matrices.view));
+}
+
+// LEVELS OF DETAIL
+// ----------------
+float lod_pixel_scale(const camera_t* camera, float viewport_height)
+{
+    // same half angle camera_update_projection ends up with
+    return viewport_height * 0.5f / HMM_TanF(HMM_ToRadians(camera->fov / 2) * 0.5f);
+}
+
+int lod_select(const lod_chain_t* chain, int current, float distance, float pixel_scale)
+{
+    if (distance <= 0.0f) return 0;
+
+    for (int i = chain->level_count - 1; i > 0; i--)
+    {
+        float pixels = chain->levels[i].error * pixel_scale / distance;
+        float limit = i > current ? LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS) : LOD_PIXEL_ERROR;
+        if (pixels <= limit) return i;
+    }
+
+    return 0;
+}
+
+void lod_update(lod_state_t* this, const lod_chain_t* chain, float distance, float pixel_scale, float delta)
+{
+    this->transition = HMM_MAX(this->transition - delta, 0.0f);
+    if (this->transition > 0.0f) return; // one change at a time
+
+    int level = lod_select(chain, this->level, distance, pixel_scale);
+    if (level == this->level) return;
+
+    this->previous = this->level;
+    this->level = level;
+    this->transition = LOD_FADE_TIME;
+}
+
+float lod_fade(const lod_state_t* this, int incoming)
+{
+    if (this->transition <= 0.0f) return 0.0f;
+
+    // > 0 keeps the pixels whose dither threshold is under it, < 0 the rest. 0 is no dither at all
+    float progress = HMM_MAX(1.0f - this->transition / LOD_FADE_TIME, 1.0f / 64.0f);
+    return incoming ? progress : -progress;
+}
+
+float bounds_distance(vec3_t min, vec3_t max, vec3_t point)
+{
+    vec3_t outside = HMM_Vec3(
+        HMM_MAX(HMM_MAX(min.x - point.x, point.x - max.x), 0.0f),
+        HMM_MAX(HMM_MAX(min.y - point.y, point.y - max.y), 0.0f),
+        HMM_MAX(HMM_MAX(min.z - point.z, point.z - max.z), 0.0f)
+    );
+    return HMM_LengthVec3(outside);
+}
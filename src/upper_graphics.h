@@ -6,6 +6,8 @@
 #include "turan_choks.h"
 #include "external/HandmadeMath.h"
 
+#include <stdlib.h>
+
 // little transform/camera utilities - moved from turan_choks
 // ----------------------------------------------------------
 typedef struct transform_s
@@ -16,6 +18,99 @@ typedef struct transform_s
 } transform_t;
 
 extern mat4_t transform_to_matrix(transform_t* this);
+extern void transforms_to_matrices(transform_t* transforms, int count, mat4_t* out);
+
+// instance buffers straight from transforms, for primitive_draw_instanced. inline so
+// upper_graphics.c stays free of gl calls (bvhbench links it without turan_choks.c)
+static inline instance_buffer_t instance_buffer_from_transforms(transform_t* transforms, int count)
+{
+    mat4_t* models = malloc(sizeof(mat4_t) * count);
+    transforms_to_matrices(transforms, count, models);
+
+    instance_buffer_t buffer = instance_buffer_load(models, count);
+    free(models);
+    return buffer;
+}
+
+static inline instance_buffer_t instance_buffer_stream_transforms(transform_t* transforms, int count) // this frame only
+{
+    instance_buffer_t buffer = { 0 };
+
+    // straight into the ring, no temp copy
+    stream_range_t range;
+    mat4_t* models = stream_map(sizeof(mat4_t) * count, sizeof(vec4_t), &range);
+    if (!models) return buffer;
+
+    transforms_to_matrices(transforms, count, models);
+    stream_unmap();
+
+    buffer.buffer = range.buffer;
+    buffer.offset = range.offset;
+    buffer.count = count;
+    return buffer;
+}
+
+// FRUSTUM CULLING
+// ---------------
+typedef struct frustum_s
+{
+    vec4_t planes[6]; // left, right, bottom, top, near, far. xyz = normal pointing in, w = distance
+} frustum_t;
+
+extern frustum_t frustum_from_matrix(mat4_t view_projection);
+extern int frustum_test_sphere(const frustum_t* this, vec3_t center, float radius);
+extern int frustum_test_box(const frustum_t* this, vec3_t min, vec3_t max);
+
+extern void bounds_transform(vec3_t min, vec3_t max, mat4_t transform, vec3_t* out_min, vec3_t* out_max); // aabb of the transformed box
+
+// lots of objects at once: bounds go in soa arrays, the kernels test 4 (sse) or 8 (avx)
+// at a time and write the indices of whatever passed into visible. big sets get split
+// into jobs, visible comes out in the same order either way.
+#define CULL_PARALLEL_THRESHOLD 16384
+#define CULL_MAX_JOBS 64
+typedef struct cull_set_s
+{
+    float *center_x, *center_y, *center_z;
+    float *extent_x, *extent_y, *extent_z; // half size
+    float *radius;
+    int count, capacity;
+
+    int* visible;
+    int visible_count;
+} cull_set_t;
+
+extern int cull_set_add(cull_set_t* this, vec3_t min, vec3_t max); // returns the index
+extern void cull_set_clear(cull_set_t* this);
+extern void cull_set_free(cull_set_t* this);
+
+extern int frustum_cull_spheres(const frustum_t* this, cull_set_t* set); // returns visible_count
+extern int frustum_cull_boxes(const frustum_t* this, cull_set_t* set); // tighter, a bit slower
+
+// spheres against one box, 4 (sse2) or 8 (avx2) spheres per step. the kernel is picked from
+// cpuid the first time, so one build uses avx2 where its there and still runs where it isnt.
+#define SPHERE_SET_PAD 8 // arrays run to a multiple of this, the padding never touches anything
+
+enum
+{
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2,
+};
+
+typedef struct sphere_set_s
+{
+    float *center_x, *center_y, *center_z;
+    float *radius_sq;
+    int count, capacity;
+} sphere_set_t;
+
+extern int sphere_set_add(sphere_set_t* this, vec3_t center, float radius); // returns the index
+extern void sphere_set_clear(sphere_set_t* this);
+extern void sphere_set_free(sphere_set_t* this);
+
+// indices of the spheres touching min/max, lowest first, stops after max_hits. hits can be NULL to only count
+extern int spheres_touching_box(const sphere_set_t* this, vec3_t min, vec3_t max, unsigned int* hits, int max_hits);
+extern int spheres_kernel(int level); // SIMD_*, clamped to what the cpu has. -1 picks the best. returns the one in use
 
 // CAMERA CAMERA CAMERA !!
 // -----------------------
@@ -36,7 +131,44 @@ typedef struct camera_s
     {
         mat4_t view, projection;
     } matrices;
+
+    frustum_t frustum; // world space, kept up to date by the two functions below
 } camera_t;
 
 extern void camera_update_view(camera_t* this); // for every frame/when u change transform
-extern void camera_update_projection(camera_t* this); // only when you need to/when u change frustrum/viewport
\ No newline at end of file
+extern void camera_update_projection(camera_t* this); // only when you need to/when u change frustrum/viewport
+
+// LEVELS OF DETAIL
+// ----------------
+// a chain of index ranges into one primitive, full detail first. the level is whatever
+// coarsest one keeps its error under LOD_PIXEL_ERROR on screen, and a change dithers from
+// the old level into the new one over LOD_FADE_TIME (draw both, see lod_fade).
+#define LOD_MAX_LEVELS 4
+#define LOD_PIXEL_ERROR 1.0f
+#define LOD_HYSTERESIS 0.25f // a coarser level has to be this much under the limit before it gets picked, so levels dont flicker at the boundary
+#define LOD_FADE_TIME 0.25f // seconds
+
+typedef struct lod_level_s
+{
+    int first_index, index_count; // into the primitive
+    float error; // object space distance from full detail
+} lod_level_t;
+
+typedef struct lod_chain_s
+{
+    lod_level_t levels[LOD_MAX_LEVELS];
+    int level_count;
+} lod_chain_t;
+
+typedef struct lod_state_s
+{
+    int level, previous;
+    float transition; // seconds left of the dither from previous to level, 0 when settled
+} lod_state_t;
+
+extern float lod_pixel_scale(const camera_t* camera, float viewport_height); // pixels an object space unit covers at distance 1
+extern int lod_select(const lod_chain_t* chain, int current, float distance, float pixel_scale);
+extern void lod_update(lod_state_t* this, const lod_chain_t* chain, float distance, float pixel_scale, float delta);
+extern float lod_fade(const lod_state_t* this, int incoming); // for set_model_matrix_faded, draw previous with 0 and level with 1 while transitioning
+
+extern float bounds_distance(vec3_t min, vec3_t max, vec3_t point); // 0 inside
@@ -0,0 +1,249 @@
+#pragma once
+
+// VERTEX LAYOUTS
+// --------------
+// how a primitive stores each of its attributes. shared by the engine and tooling/mapc.c,
+// which packs vertices at cook time so they go to gl straight out of the .cmap.
+//
+// attributes always sit in this order inside a vertex, and their index is also the shader location:
+// layout (location = 0) in vec3 position;
+// layout (location = 1) in vec2 texture;
+// layout (location = 2) in vec3 normal;
+// layout (location = 3) in vec4 color;
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define VERTEX_POSITION_STEP (1.0f / 512.0f) // quantized positions snap to this grid everywhere, so neighbouring meshes stay watertight
+#define VERTEX_HALF_TEXCOORD_LIMIT 4.0f // half texcoords only when every |st| is under this (1/512 steps near the top)
+
+enum
+{
+    VERTEX_POSITION,
+    VERTEX_TEXCOORD,
+    VERTEX_NORMAL,
+    VERTEX_COLOR,
+    VERTEX_ATTRIBUTES,
+};
+
+typedef enum vertex_format_e
+{
+    VERTEX_FORMAT_NONE, // attribute left out
+    VERTEX_FORMAT_FLOAT,
+    VERTEX_FORMAT_HALF, // texcoords
+    VERTEX_FORMAT_UNORM16, // positions, against the grid above. see vertex_decode_t
+    VERTEX_FORMAT_INT_2_10_10_10, // normals
+    VERTEX_FORMAT_UNORM8, // colors
+} vertex_format_t;
+
+typedef struct vertex_layout_s
+{
+    uint8_t formats[VERTEX_ATTRIBUTES]; // vertex_format_t per attribute
+} vertex_layout_t;
+
+#define VERTEX_LAYOUT_STD ((vertex_layout_t) {{ VERTEX_FORMAT_FLOAT, VERTEX_FORMAT_FLOAT }}) // xyzst, primitive_std_vertex_t
+
+// quantized positions come out of the vertex shader as stored * scale + bias
+typedef struct vertex_decode_s
+{
+    float scale[3], bias[3];
+} vertex_decode_t;
+
+#define VERTEX_DECODE_IDENTITY ((vertex_decode_t) { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } })
+
+// full precision, what loaders fill in before packing
+typedef struct vertex_s
+{
+    float position[3];
+    float texcoord[2];
+    float normal[3];
+    float color[4];
+} vertex_t;
+
+static inline int vertex_attribute_size(int attribute, int format)
+{
+    static const int components[VERTEX_ATTRIBUTES] = { 3, 2, 3, 4 };
+
+    switch (format)
+    {
+        case VERTEX_FORMAT_FLOAT: return 4 * components[attribute];
+        case VERTEX_FORMAT_HALF: return (2 * components[attribute] + 3) & ~3;
+        case VERTEX_FORMAT_UNORM16: return (2 * components[attribute] + 3) & ~3; // xyz padded to 4 shorts
+        case VERTEX_FORMAT_INT_2_10_10_10: return 4;
+        case VERTEX_FORMAT_UNORM8: return 4;
+        default: return 0;
+    }
+}
+
+static inline int vertex_layout_offset(vertex_layout_t layout, int attribute)
+{
+    int offset = 0;
+    for (int i = 0; i < attribute; i++) offset += vertex_attribute_size(i, layout.formats[i]);
+    return offset;
+}
+
+static inline int vertex_layout_stride(vertex_layout_t layout)
+{
+    return vertex_layout_offset(layout, VERTEX_ATTRIBUTES);
+}
+
+static inline int vertex_layout_equal(vertex_layout_t a, vertex_layout_t b)
+{
+    return !memcmp(&a, &b, sizeof(a));
+}
+
+// works out the grid range for the positions, 0 if they span too much for 16 bits
+static inline int vertex_quantize_positions(const vertex_t* vertices, int count, vertex_decode_t* decode)
+{
+    *decode = VERTEX_DECODE_IDENTITY;
+    if (!count) return 0;
+
+    vertex_decode_t result;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float min = vertices[0].position[axis], max = min;
+        for (int i = 1; i < count; i++)
+        {
+            min = fminf(min, vertices[i].position[axis]);
+            max = fmaxf(max, vertices[i].position[axis]);
+        }
+
+        // bias on the grid too, otherwise two meshes would round the same point differently
+        result.bias[axis] = floorf(min / VERTEX_POSITION_STEP) * VERTEX_POSITION_STEP;
+        result.scale[axis] = 65535.0f * VERTEX_POSITION_STEP;
+        if ((max - result.bias[axis]) / VERTEX_POSITION_STEP > 65535.0f) return 0;
+    }
+
+    *decode = result;
+    return 1;
+}
+
+// the tightest layout that keeps positions on the grid and texcoords within half precision
+static inline vertex_layout_t vertex_layout_pick(const vertex_t* vertices, int count, int normals, int colors, vertex_decode_t* decode)
+{
+    vertex_layout_t layout = VERTEX_LAYOUT_STD;
+
+    if (vertex_quantize_positions(vertices, count, decode)) layout.formats[VERTEX_POSITION] = VERTEX_FORMAT_UNORM16;
+
+    int half = 1;
+    for (int i = 0; i < count && half; i++)
+    {
+        half = fabsf(vertices[i].texcoord[0]) < VERTEX_HALF_TEXCOORD_LIMIT && fabsf(vertices[i].texcoord[1]) < VERTEX_HALF_TEXCOORD_LIMIT;
+    }
+    if (half) layout.formats[VERTEX_TEXCOORD] = VERTEX_FORMAT_HALF;
+
+    if (normals) layout.formats[VERTEX_NORMAL] = VERTEX_FORMAT_INT_2_10_10_10;
+
+    if (colors)
+    {
+        // hdr colors keep their floats
+        int unorm = 1;
+        for (int i = 0; i < count && unorm; i++)
+        {
+            for (int c = 0; c < 4; c++) unorm &= vertices[i].color[c] >= 0.0f && vertices[i].color[c] <= 1.0f;
+        }
+        layout.formats[VERTEX_COLOR] = unorm ? VERTEX_FORMAT_UNORM8 : VERTEX_FORMAT_FLOAT;
+    }
+
+    return layout;
+}
+
+static inline uint16_t vertex_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = bits >> 16 & 0x8000;
+    int exponent = (int) (bits >> 23 & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (exponent <= 0) return sign; // too small, flush to zero
+    if (exponent >= 31) return sign | 0x7c00; // too big (or nan), inf
+
+    // round to nearest, a carry out of the mantissa bumps the exponent like it should
+    return (sign | exponent << 10 | mantissa >> 13) + (mantissa >> 12 & 1);
+}
+
+static inline uint32_t vertex_unorm(float value, float max)
+{
+    value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+    return (uint32_t) (value * max + 0.5f);
+}
+
+static inline uint32_t vertex_snorm10(float value)
+{
+    value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+    return (uint32_t) (int32_t) lrintf(value * 511.0f) & 0x3ff;
+}
+
+static inline void vertex_pack(vertex_layout_t layout, vertex_decode_t decode, const vertex_t* vertices, int count, void* out)
+{
+    int stride = vertex_layout_stride(layout);
+
+    for (int i = 0; i < count; i++)
+    {
+        const vertex_t* vertex = &vertices[i];
+        unsigned char* at = (unsigned char*) out + stride * i;
+
+        const float* sources[VERTEX_ATTRIBUTES] = { vertex->position, vertex->texcoord, vertex->normal, vertex->color };
+        static const int components[VERTEX_ATTRIBUTES] = { 3, 2, 3, 4 };
+
+        for (int a = 0; a < VERTEX_ATTRIBUTES; a++)
+        {
+            const float* source = sources[a];
+            int size = vertex_attribute_size(a, layout.formats[a]);
+
+            switch (layout.formats[a])
+            {
+                case VERTEX_FORMAT_FLOAT:
+                    memcpy(at, source, size);
+                    break;
+                case VERTEX_FORMAT_HALF:
+                {
+                    uint16_t halfs[4] = { 0 };
+                    for (int c = 0; c < components[a]; c++) halfs[c] = vertex_half(source[c]);
+                    memcpy(at, halfs, size);
+                    break;
+                }
+                case VERTEX_FORMAT_UNORM16:
+                {
+                    uint16_t shorts[4] = { 0 };
+                    for (int c = 0; c < components[a]; c++) shorts[c] = vertex_unorm((source[c] - decode.bias[c]) / decode.scale[c], 65535.0f);
+                    memcpy(at, shorts, size);
+                    break;
+                }
+                case VERTEX_FORMAT_INT_2_10_10_10:
+                {
+                    uint32_t packed = vertex_snorm10(source[0]) | vertex_snorm10(source[1]) << 10 | vertex_snorm10(source[2]) << 20;
+                    memcpy(at, &packed, size);
+                    break;
+                }
+                case VERTEX_FORMAT_UNORM8:
+                {
+                    uint8_t bytes[4];
+                    for (int c = 0; c < 4; c++) bytes[c] = vertex_unorm(source[c], 255.0f);
+                    memcpy(at, bytes, size);
+                    break;
+                }
+                default: break;
+            }
+
+            at += size;
+        }
+    }
+}
+
+// position of a packed vertex, for cpu side use (bounds, collision)
+static inline void vertex_unpack_position(vertex_layout_t layout, vertex_decode_t decode, const void* vertex, float* out)
+{
+    if (layout.formats[VERTEX_POSITION] == VERTEX_FORMAT_UNORM16)
+    {
+        uint16_t shorts[3];
+        memcpy(shorts, vertex, sizeof(shorts));
+        for (int c = 0; c < 3; c++) out[c] = shorts[c] / 65535.0f * decode.scale[c] + decode.bias[c];
+        return;
+    }
+
+    memcpy(out, vertex, sizeof(float) * 3);
+}
@@ -1,6 +1,16 @@
 #include "world.h"
 
 #include "turan_choks.h"
+#include "cmap.h"
+#include "meshopt.h"
+#include "rqueue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
 
 // temp primitive data (x, y, z, u, v)
 static float tempworlddata[] = {
@@ -15,27 +25,822 @@ static unsigned int tempworldindicies[] = {
     2, 1, 3
 };
 
-static primitive_t terrain_mesh;
-static program_t basic_program;
-static texture_t tiles_texture;
+static program_t basic_program; // owned by whoever called world_generate_test
+
+static struct world_s
+{
+    // static meshes waiting for world_build_batches, already in world space
+    struct world_pending_s
+    {
+        primitive_std_vertex_t* vertices;
+        int vertex_count;
+        unsigned int* indices;
+        int index_count;
+
+        unsigned int program;
+        texture_t* texture;
+    } *pending;
+    int pending_count, pending_capacity;
+
+    world_batch_t* batches;
+    int batch_count;
+
+    // every texture the world references, loaded once per path
+    struct world_texture_s
+    {
+        char path[CMAP_PATH_SIZE];
+        texture_t* texture;
+    } *textures;
+    int texture_count;
+
+    // chunks of a .cworld around the camera, see CHUNK STREAMING
+    struct world_stream_s
+    {
+        struct world_chunk_s
+        {
+            enum { WORLD_CHUNK_UNLOADED, WORLD_CHUNK_LOADING, WORLD_CHUNK_LOADED, WORLD_CHUNK_RESIDENT, WORLD_CHUNK_FAILED } state;
+            int cancelled; // went out of range while the io thread had it
+
+            cmap_chunk_t info;
+            char path[256];
+
+            asset_t file; // filled by the io thread, kept until every material is uploaded
+            const cmap_header_t* header;
+
+            world_batch_t* batches;
+            int batch_count;
+            uint32_t next_material;
+        } *chunks;
+        int chunk_count;
+
+        float radius, hysteresis;
+        world_stream_stats_t stats;
+
+        // single io thread, requests and results are chunk indices
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        int* requests;
+        int request_head, request_tail;
+        int* results;
+        int result_head, result_tail;
+        int running;
+    } stream;
+
+    // bounds of every submesh (static + streamed), rebuilt when batches come or go
+    cull_set_t cull;
+    world_submesh_t** cull_submeshes;
+    int cull_dirty;
+
+    // triangles of every batch for the queries, same idea
+    bvh_t bvh;
+    vec3_t* bvh_triangles;
+    int bvh_dirty;
+} world = { .stream = { .radius = WORLD_STREAM_RADIUS, .hysteresis = WORLD_STREAM_HYSTERESIS } };
+
+static texture_t* _world_texture(const char* path)
+{
+    if (!path[0]) return NULL;
+
+    for (int i = 0; i < world.texture_count; i++)
+    {
+        if (!strcmp(world.textures[i].path, path)) return world.textures[i].texture;
+    }
+
+    world.textures = realloc(world.textures, sizeof(*world.textures) * (world.texture_count + 1));
+    struct world_texture_s* entry = &world.textures[world.texture_count++];
+
+    snprintf(entry->path, sizeof(entry->path), "%s", path);
+    entry->texture = texture_load_2d_async(path);
+    return entry->texture;
+}
+
+// STATIC BATCHING
+// ---------------
+static void _world_lod_chain_init(world_batch_t* batch, int index_count)
+{
+    batch->lods = (lod_chain_t) { .level_count = 1 };
+    batch->lods.levels[0] = (lod_level_t) { 0, index_count, 0.0f };
+    batch->lod = (lod_state_t) { 0 };
+}
+
+static void _world_lod_chain_add(world_batch_t* batch, int first_index, int index_count, float error)
+{
+    if (batch->lods.level_count < LOD_MAX_LEVELS) batch->lods.levels[batch->lods.level_count++] = (lod_level_t) { first_index, index_count, error };
+}
+
+void world_add_static(const primitive_std_vertex_t* vertices, int vertex_count, const unsigned int* indices, int index_count, mat4_t transform, program_t program, texture_t* texture)
+{
+    if (world.pending_count == world.pending_capacity)
+    {
+        world.pending_capacity = world.pending_capacity ? world.pending_capacity * 2 : 64;
+        world.pending = realloc(world.pending, sizeof(*world.pending) * world.pending_capacity);
+    }
+
+    struct world_pending_s* mesh = &world.pending[world.pending_count++];
+    mesh->vertices = malloc(sizeof(primitive_std_vertex_t) * vertex_count);
+    mesh->vertex_count = vertex_count;
+    mesh->indices = malloc(sizeof(unsigned int) * index_count);
+    mesh->index_count = index_count;
+    mesh->program = program.id;
+    mesh->texture = texture;
+
+    // bake the transform in, batches are drawn with an identity model matrix
+    for (int i = 0; i < vertex_count; i++)
+    {
+        vec4_t position = HMM_MultiplyMat4ByVec4(transform, HMM_Vec4(vertices[i].x, vertices[i].y, vertices[i].z, 1.0f));
+        mesh->vertices[i] = (primitive_std_vertex_t) { position.x, position.y, position.z, vertices[i].s, vertices[i].t };
+    }
+
+    memcpy(mesh->indices, indices, sizeof(unsigned int) * index_count);
+}
+
+static int _pending_compare(const void* a, const void* b)
+{
+    const struct world_pending_s* x = a;
+    const struct world_pending_s* y = b;
+
+    if (x->program != y->program) return x->program < y->program ? -1 : 1;
+    if (x->texture != y->texture) return x->texture < y->texture ? -1 : 1;
+    return 0;
+}
+
+void world_build_batches()
+{
+    // same program + texture end up next to each other
+    qsort(world.pending, world.pending_count, sizeof(*world.pending), _pending_compare);
+
+    int first = 0;
+    while (first < world.pending_count)
+    {
+        int last = first;
+        int vertex_count = 0, index_count = 0;
+        while (last < world.pending_count && !_pending_compare(&world.pending[first], &world.pending[last]))
+        {
+            vertex_count += world.pending[last].vertex_count;
+            index_count += world.pending[last].index_count;
+            last++;
+        }
+
+        world.batches = realloc(world.batches, sizeof(world_batch_t) * (world.batch_count + 1));
+        world_batch_t* batch = &world.batches[world.batch_count++];
+
+        batch->program = world.pending[first].program;
+        batch->texture = world.pending[first].texture;
+        batch->submesh_count = last - first;
+        batch->submeshes = malloc(sizeof(world_submesh_t) * batch->submesh_count);
+        batch->min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+        batch->max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+        primitive_std_vertex_t* vertices = malloc(sizeof(primitive_std_vertex_t) * vertex_count);
+        unsigned int* indices = malloc(sizeof(unsigned int) * index_count * 3); // lods take at most twice the full detail
+
+        int base_vertex = 0, base_index = 0;
+        for (int i = first; i < last; i++)
+        {
+            struct world_pending_s* mesh = &world.pending[i];
+            world_submesh_t* submesh = &batch->submeshes[i - first];
+
+            submesh->first_index = base_index;
+            submesh->index_count = mesh->index_count;
+            submesh->visible = 1;
+            submesh->min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+            submesh->max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+            for (int v = 0; v < mesh->vertex_count; v++)
+            {
+                primitive_std_vertex_t* vertex = &mesh->vertices[v];
+                submesh->min = HMM_Vec3(HMM_MIN(submesh->min.x, vertex->x), HMM_MIN(submesh->min.y, vertex->y), HMM_MIN(submesh->min.z, vertex->z));
+                submesh->max = HMM_Vec3(HMM_MAX(submesh->max.x, vertex->x), HMM_MAX(submesh->max.y, vertex->y), HMM_MAX(submesh->max.z, vertex->z));
+            }
+
+            batch->min = HMM_Vec3(HMM_MIN(batch->min.x, submesh->min.x), HMM_MIN(batch->min.y, submesh->min.y), HMM_MIN(batch->min.z, submesh->min.z));
+            batch->max = HMM_Vec3(HMM_MAX(batch->max.x, submesh->max.x), HMM_MAX(batch->max.y, submesh->max.y), HMM_MAX(batch->max.z, submesh->max.z));
+
+            // submeshes get culled on their own, so triangles only reorder within one
+            meshopt_vertex_cache(mesh->indices, mesh->index_count, mesh->vertex_count);
+
+            memcpy(vertices + base_vertex, mesh->vertices, sizeof(primitive_std_vertex_t) * mesh->vertex_count);
+            for (int n = 0; n < mesh->index_count; n++) indices[base_index + n] = mesh->indices[n] + base_vertex;
+
+            base_vertex += mesh->vertex_count;
+            base_index += mesh->index_count;
+
+            free(mesh->vertices);
+            free(mesh->indices);
+        }
+
+        // lods of the whole batch right after the submeshes, same vertices
+        meshopt_lod_t lods[MESHOPT_LOD_LEVELS - 1];
+        int lod_count = meshopt_build_lods(indices, index_count, &vertices[0].x, sizeof(primitive_std_vertex_t), vertex_count, indices + index_count, lods);
+
+        _world_lod_chain_init(batch, index_count);
+        for (int l = 0; l < lod_count; l++) _world_lod_chain_add(batch, index_count + lods[l].first_index, lods[l].index_count, lods[l].error);
+
+        int lod_index_count = lod_count ? lods[lod_count - 1].first_index + lods[lod_count - 1].index_count : 0;
+        batch->primitive = primitive_load_with_indices((float*) vertices, vertex_count, indices, index_count + lod_index_count, GL_TRIANGLES);
+        batch->primitive.index_count = index_count; // lods are only drawn by range
+
+        batch->triangle_count = index_count / 3;
+        batch->triangles = malloc(sizeof(vec3_t) * batch->triangle_count * 3);
+        for (int n = 0; n < batch->triangle_count * 3; n++) batch->triangles[n] = HMM_Vec3(vertices[indices[n]].x, vertices[indices[n]].y, vertices[indices[n]].z);
+
+        free(vertices);
+        free(indices);
+
+        first = last;
+    }
+
+    printf("world: %i static meshes -> %i batches\n", world.pending_count, world.batch_count);
+    world.cull_dirty = world.bvh_dirty = 1;
+
+    free(world.pending);
+    world.pending = NULL;
+    world.pending_count = world.pending_capacity = 0;
+}
+
+int world_get_batches(world_batch_t** batches)
+{
+    *batches = world.batches;
+    return world.batch_count;
+}
+
+static void _world_free_batches(world_batch_t** batches, int* batch_count)
+{
+    for (int i = 0; i < *batch_count; i++)
+    {
+        primitive_free(&(*batches)[i].primitive);
+        free((*batches)[i].submeshes);
+        free((*batches)[i].triangles);
+    }
+
+    free(*batches);
+    *batches = NULL;
+    *batch_count = 0;
+    world.cull_dirty = world.bvh_dirty = 1;
+}
+
+// COOKED MAPS
+// -----------
+// the compiler already grouped everything per material, so each one is a batch as is
+static void _world_batch_from_cmap(world_batch_t* batch, const unsigned char* data, const cmap_header_t* header, const cmap_material_t* material)
+{
+    const cmap_mesh_t* meshes = (const cmap_mesh_t*) (data + header->mesh_offset);
+    const unsigned char* vertices = data + header->vertex_offset + material->vertex_offset;
+    const unsigned char* indices = data + header->index_offset + material->index_offset;
+    int stride = vertex_layout_stride(material->layout);
+
+    batch->program = basic_program.id;
+    batch->texture = _world_texture(material->texture);
+
+    // straight from the mapping into gl, already packed. lods ride along after the full detail
+    batch->primitive = primitive_load_packed(
+        vertices, material->vertex_count,
+        indices, material->index_count + material->lod_index_count, material->index_size,
+        GL_TRIANGLES, material->layout, material->decode
+    );
+    batch->primitive.index_count = material->index_count; // lods are only drawn by range
+
+    _world_lod_chain_init(batch, material->index_count);
+    for (uint32_t l = 0; l < material->lod_count; l++) _world_lod_chain_add(batch, material->lods[l].first_index, material->lods[l].index_count, material->lods[l].error);
+
+    batch->submesh_count = material->mesh_count;
+    batch->submeshes = malloc(sizeof(world_submesh_t) * batch->submesh_count);
+    batch->min = HMM_Vec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    batch->max = HMM_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    world.cull_dirty = world.bvh_dirty = 1;
+
+    batch->triangle_count = material->index_count / 3;
+    batch->triangles = malloc(sizeof(vec3_t) * batch->triangle_count * 3);
+    for (int n = 0; n < batch->triangle_count * 3; n++)
+    {
+        float position[3];
+        uint32_t index = material->index_size == 2 ? ((const uint16_t*) indices)[n] : ((const uint32_t*) indices)[n];
+        vertex_unpack_position(material->layout, material->decode, vertices + stride * index, position);
+        batch->triangles[n] = HMM_Vec3(position[0], position[1], position[2]);
+    }
+
+    for (uint32_t i = 0; i < material->mesh_count; i++)
+    {
+        const cmap_mesh_t* mesh = &meshes[material->first_mesh + i];
+        world_submesh_t* submesh = &batch->submeshes[i];
+
+        submesh->first_index = mesh->first_index;
+        submesh->index_count = mesh->index_count;
+        submesh->visible = 1;
+        submesh->min = HMM_Vec3(mesh->min[0], mesh->min[1], mesh->min[2]);
+        submesh->max = HMM_Vec3(mesh->max[0], mesh->max[1], mesh->max[2]);
+
+        batch->min = HMM_Vec3(HMM_MIN(batch->min.x, submesh->min.x), HMM_MIN(batch->min.y, submesh->min.y), HMM_MIN(batch->min.z, submesh->min.z));
+        batch->max = HMM_Vec3(HMM_MAX(batch->max.x, submesh->max.x), HMM_MAX(batch->max.y, submesh->max.y), HMM_MAX(batch->max.z, submesh->max.z));
+    }
+}
+
+static size_t _cmap_material_bytes(const cmap_material_t* material)
+{
+    return (size_t) vertex_layout_stride(material->layout) * material->vertex_count + (size_t) material->index_size * (material->index_count + material->lod_index_count);
+}
+
+int world_load_map(const char* path)
+{
+    asset_t file = asset_open(path);
+    if (!file.data) return 0;
+
+    const cmap_header_t* header = cmap_validate(file.data, file.size);
+    if (!header)
+    {
+        printf("%s is not a valid .cmap (recompile it with mapc)\n", path);
+        asset_close(&file);
+        return 0;
+    }
+
+    const cmap_material_t* materials = (const cmap_material_t*) (file.data + header->material_offset);
+    for (uint32_t m = 0; m < header->material_count; m++)
+    {
+        if (!materials[m].index_count) continue;
+
+        world.batches = realloc(world.batches, sizeof(world_batch_t) * (world.batch_count + 1));
+        _world_batch_from_cmap(&world.batches[world.batch_count++], file.data, header, &materials[m]);
+    }
+
+    printf("world: loaded %s (%u vertices, %u materials, %u meshes)\n", path, header->vertex_count, header->material_count, header->mesh_count);
+
+    asset_close(&file);
+    return 1;
+}
+
+// CHUNK STREAMING
+// ---------------
+// the io thread only opens + validates chunk files and faults their pages in, gl uploads
+// happen in world_stream_update on the main thread, a material at a time under the budget.
+static void* _world_stream_worker(void* arg)
+{
+    (void) arg;
+    struct world_stream_s* stream = &world.stream;
+
+    pthread_mutex_lock(&stream->mutex);
+    for (;;)
+    {
+        while (stream->running && stream->request_head == stream->request_tail) pthread_cond_wait(&stream->cond, &stream->mutex);
+        if (!stream->running) break;
+
+        int index = stream->requests[stream->request_head];
+        stream->request_head = (stream->request_head + 1) % (stream->chunk_count + 1);
+        struct world_chunk_s* chunk = &stream->chunks[index];
+        pthread_mutex_unlock(&stream->mutex);
+
+        // the main thread doesnt touch a LOADING chunk except for the cancelled flag
+        chunk->file = asset_open(chunk->path);
+        chunk->header = chunk->file.data ? cmap_validate(chunk->file.data, chunk->file.size) : NULL;
+
+        // touch every page so the upload doesnt stall on the disk
+        if (chunk->header)
+        {
+            volatile unsigned char sum = 0;
+            for (size_t offset = 0; offset < chunk->file.size; offset += 4096) sum += chunk->file.data[offset];
+            (void) sum;
+        }
+
+        pthread_mutex_lock(&stream->mutex);
+        stream->results[stream->result_tail] = index;
+        stream->result_tail = (stream->result_tail + 1) % (stream->chunk_count + 1);
+    }
+    pthread_mutex_unlock(&stream->mutex);
+
+    return NULL;
+}
+
+int world_stream_open(const char* path)
+{
+    asset_t file = asset_open(path);
+    if (!file.data) return 0;
+
+    const cmap_world_t* header = (const cmap_world_t*) file.data;
+    if (file.size < sizeof(*header) || header->magic != CMAP_WORLD_MAGIC || header->version != CMAP_VERSION ||
+        sizeof(*header) + sizeof(cmap_chunk_t) * (uint64_t) header->chunk_count > file.size)
+    {
+        printf("%s is not a valid .cworld (recompile it with mapc -chunk)\n", path);
+        asset_close(&file);
+        return 0;
+    }
+
+    world_stream_close();
+    struct world_stream_s* stream = &world.stream;
 
-void world_generate_test()
+    // chunk paths are relative to the index
+    const char* slash = strrchr(path, '/');
+    int directory_length = slash ? (int) (slash - path + 1) : 0;
+
+    const cmap_chunk_t* chunks = (const cmap_chunk_t*) (file.data + sizeof(*header));
+    stream->chunk_count = header->chunk_count;
+    stream->chunks = calloc(stream->chunk_count ? stream->chunk_count : 1, sizeof(*stream->chunks));
+
+    for (int i = 0; i < stream->chunk_count; i++)
+    {
+        struct world_chunk_s* chunk = &stream->chunks[i];
+        chunk->info = chunks[i];
+        chunk->info.path[CMAP_PATH_SIZE - 1] = '\0';
+        snprintf(chunk->path, sizeof(chunk->path), "%.*s%s", directory_length, path, chunk->info.path);
+    }
+
+    // every chunk is in at most one of the queues at a time, + 1 so full != empty
+    stream->requests = malloc(sizeof(int) * (stream->chunk_count + 1));
+    stream->results = malloc(sizeof(int) * (stream->chunk_count + 1));
+    stream->request_head = stream->request_tail = 0;
+    stream->result_head = stream->result_tail = 0;
+    stream->stats = (world_stream_stats_t) { .chunks = stream->chunk_count };
+
+    pthread_mutex_init(&stream->mutex, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+    stream->running = 1;
+    pthread_create(&stream->thread, NULL, _world_stream_worker, NULL);
+
+    printf("world: streaming %s (%i chunks of %g units)\n", path, stream->chunk_count, header->chunk_size);
+
+    asset_close(&file);
+    return 1;
+}
+
+static void _world_chunk_evict(struct world_chunk_s* chunk)
+{
+    if (chunk->state == WORLD_CHUNK_RESIDENT) world.stream.stats.resident--;
+    _world_free_batches(&chunk->batches, &chunk->batch_count);
+    asset_close(&chunk->file);
+
+    chunk->header = NULL;
+    chunk->next_material = 0;
+    chunk->cancelled = 0;
+    chunk->state = WORLD_CHUNK_UNLOADED;
+}
+
+void world_stream_close()
+{
+    struct world_stream_s* stream = &world.stream;
+    if (!stream->chunks) return;
+
+    pthread_mutex_lock(&stream->mutex);
+    stream->running = 0;
+    pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->mutex);
+    pthread_join(stream->thread, NULL);
+
+    pthread_mutex_destroy(&stream->mutex);
+    pthread_cond_destroy(&stream->cond);
+
+    // anything the worker got to is safe to free now, the rest never got opened
+    for (int i = 0; i < stream->chunk_count; i++) _world_chunk_evict(&stream->chunks[i]);
+
+    free(stream->chunks);
+    free(stream->requests);
+    free(stream->results);
+    stream->chunks = NULL;
+    stream->requests = stream->results = NULL;
+    stream->chunk_count = 0;
+    stream->stats = (world_stream_stats_t) { 0 };
+}
+
+void world_stream_set_radius(float radius, float hysteresis)
 {
-    terrain_mesh = primitive_load_with_indices(tempworlddata, 4, tempworldindicies, 6, GL_TRIANGLES);
-    basic_program = program_load_from_files("gfx/src/textured.v.glsl", "gfx/src/textured.f.glsl");
-    tiles_texture = texture_load_2d_from_file("media/misc/tiles.webp");
+    world.stream.radius = radius;
+    world.stream.hysteresis = hysteresis;
+}
+
+// distance on xz from the position to the chunk bounds, 0 inside
+static float _world_chunk_distance(const struct world_chunk_s* chunk, vec3_t position)
+{
+    float dx = HMM_MAX(HMM_MAX(chunk->info.min[0] - position.x, position.x - chunk->info.max[0]), 0.0f);
+    float dz = HMM_MAX(HMM_MAX(chunk->info.min[2] - position.z, position.z - chunk->info.max[2]), 0.0f);
+    return sqrtf(dx * dx + dz * dz);
+}
+
+void world_stream_update(vec3_t position)
+{
+    struct world_stream_s* stream = &world.stream;
+    if (!stream->chunks) return;
+
+    // finished reads
+    pthread_mutex_lock(&stream->mutex);
+    while (stream->result_head != stream->result_tail)
+    {
+        struct world_chunk_s* chunk = &stream->chunks[stream->results[stream->result_head]];
+        stream->result_head = (stream->result_head + 1) % (stream->chunk_count + 1);
+
+        if (chunk->cancelled)
+        {
+            _world_chunk_evict(chunk);
+        }
+        else if (!chunk->header)
+        {
+            printf("world: cant stream %s\n", chunk->path);
+            asset_close(&chunk->file);
+            chunk->state = WORLD_CHUNK_FAILED;
+        }
+        else
+        {
+            chunk->state = WORLD_CHUNK_LOADED;
+        }
+    }
+
+    // load what came into range, drop what left it. the gap between the two radii keeps
+    // chunks on the border from flipping every frame
+    int requested = 0;
+    for (int i = 0; i < stream->chunk_count; i++)
+    {
+        struct world_chunk_s* chunk = &stream->chunks[i];
+        float distance = _world_chunk_distance(chunk, position);
+
+        if (chunk->state == WORLD_CHUNK_UNLOADED && distance <= stream->radius)
+        {
+            chunk->state = WORLD_CHUNK_LOADING;
+            stream->requests[stream->request_tail] = i;
+            stream->request_tail = (stream->request_tail + 1) % (stream->chunk_count + 1);
+            requested = 1;
+        }
+        else if (distance > stream->radius + stream->hysteresis)
+        {
+            if (chunk->state == WORLD_CHUNK_LOADING) chunk->cancelled = 1;
+            else if (chunk->state == WORLD_CHUNK_LOADED || chunk->state == WORLD_CHUNK_RESIDENT) _world_chunk_evict(chunk);
+        }
+        else if (chunk->state == WORLD_CHUNK_LOADING)
+        {
+            chunk->cancelled = 0; // came back before the read finished
+        }
+    }
+    if (requested) pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->mutex);
+
+    // upload closest first, a material at a time. always at least one so a single huge
+    // material cant stall streaming forever
+    size_t budget = WORLD_STREAM_UPLOAD_BUDGET, uploaded = 0;
+    for (;;)
+    {
+        struct world_chunk_s* closest = NULL;
+        float closest_distance = FLT_MAX;
+        for (int i = 0; i < stream->chunk_count; i++)
+        {
+            struct world_chunk_s* chunk = &stream->chunks[i];
+            if (chunk->state != WORLD_CHUNK_LOADED) continue;
+
+            float distance = _world_chunk_distance(chunk, position);
+            if (distance < closest_distance)
+            {
+                closest = chunk;
+                closest_distance = distance;
+            }
+        }
+        if (!closest) break;
+
+        const cmap_header_t* header = closest->header;
+        const cmap_material_t* materials = (const cmap_material_t*) (closest->file.data + header->material_offset);
+
+        while (closest->next_material < header->material_count)
+        {
+            const cmap_material_t* material = &materials[closest->next_material];
+            size_t bytes = _cmap_material_bytes(material);
+            if (uploaded && uploaded + bytes > budget) break;
+
+            closest->next_material++;
+            if (!material->index_count) continue;
+
+            closest->batches = realloc(closest->batches, sizeof(world_batch_t) * (closest->batch_count + 1));
+            _world_batch_from_cmap(&closest->batches[closest->batch_count++], closest->file.data, header, material);
+
+            uploaded += bytes;
+            stream->stats.bytes_streamed += bytes;
+        }
+
+        if (closest->next_material < header->material_count) break; // out of budget
+
+        // everything is in gl now, the file isnt needed anymore
+        asset_close(&closest->file);
+        closest->header = NULL;
+        closest->state = WORLD_CHUNK_RESIDENT;
+        stream->stats.resident++;
+    }
+
+    stream->stats.pending = 0;
+    for (int i = 0; i < stream->chunk_count; i++)
+    {
+        int state = stream->chunks[i].state;
+        if (state == WORLD_CHUNK_LOADING || state == WORLD_CHUNK_LOADED) stream->stats.pending++;
+    }
+}
+
+world_stream_stats_t world_stream_stats()
+{
+    return world.stream.stats;
+}
+
+// TEST WORLD
+// ----------
+void world_generate_test(program_t program)
+{
+    basic_program = program;
+
+    if (world_stream_open("map/test.cworld")) return;
+    if (world_load_map("map/test.cmap")) return;
+
+    // not compiled yet, fall back to the hardcoded floor
+    world_add_static((primitive_std_vertex_t*) tempworlddata, 4, tempworldindicies, 6, HMM_Mat4d(1.0f), basic_program, _world_texture("media/misc/tiles.webp"));
+    world_build_batches();
 }
 
 void world_cleanup()
 {
-    texture_free(tiles_texture);
-    program_free(basic_program);
-    primitive_free(&terrain_mesh);
+    world_stream_close();
+    _world_free_batches(&world.batches, &world.batch_count);
+
+    cull_set_free(&world.cull);
+    free(world.cull_submeshes);
+    world.cull_submeshes = NULL;
+
+    bvh_free(&world.bvh);
+    free(world.bvh_triangles);
+    world.bvh_triangles = NULL;
+
+    for (int i = 0; i < world.texture_count; i++) texture_async_free(world.textures[i].texture);
+    free(world.textures);
+    world.textures = NULL;
+    world.texture_count = 0;
+}
+
+// QUERIES
+// -------
+static int _world_gather_triangles(world_batch_t* batches, int batch_count, int count)
+{
+    for (int i = 0; i < batch_count; i++)
+    {
+        world.bvh_triangles = realloc(world.bvh_triangles, sizeof(vec3_t) * 3 * (count + batches[i].triangle_count));
+        memcpy(world.bvh_triangles + count * 3, batches[i].triangles, sizeof(vec3_t) * 3 * batches[i].triangle_count);
+        count += batches[i].triangle_count;
+    }
+
+    return count;
+}
+
+const bvh_t* world_get_bvh(vec3_t** triangles)
+{
+    if (world.bvh_dirty)
+    {
+        int count = _world_gather_triangles(world.batches, world.batch_count, 0);
+        for (int i = 0; i < world.stream.chunk_count; i++) count = _world_gather_triangles(world.stream.chunks[i].batches, world.stream.chunks[i].batch_count, count);
+
+        bvh_bounds_t* bounds = malloc(sizeof(bvh_bounds_t) * (count ? count : 1));
+        for (int i = 0; i < count; i++)
+        {
+            vec3_t a = world.bvh_triangles[i * 3], b = world.bvh_triangles[i * 3 + 1], c = world.bvh_triangles[i * 3 + 2];
+            bounds[i].min = HMM_Vec3(HMM_MIN(a.x, HMM_MIN(b.x, c.x)), HMM_MIN(a.y, HMM_MIN(b.y, c.y)), HMM_MIN(a.z, HMM_MIN(b.z, c.z)));
+            bounds[i].max = HMM_Vec3(HMM_MAX(a.x, HMM_MAX(b.x, c.x)), HMM_MAX(a.y, HMM_MAX(b.y, c.y)), HMM_MAX(a.z, HMM_MAX(b.z, c.z)));
+        }
+
+        bvh_free(&world.bvh);
+        bvh_build(&world.bvh, bounds, count);
+        free(bounds);
+
+        world.bvh_dirty = 0;
+    }
+
+    if (triangles) *triangles = world.bvh_triangles;
+    return &world.bvh;
+}
+
+static float _world_ray_triangle(void* user, int item, vec3_t origin, vec3_t direction, float max_distance)
+{
+    (void) max_distance;
+    vec3_t* triangles = user;
+    return bvh_ray_triangle(origin, direction, triangles[item * 3], triangles[item * 3 + 1], triangles[item * 3 + 2]);
+}
+
+int world_raycast(vec3_t origin, vec3_t direction, float max_distance, float* distance)
+{
+    vec3_t* triangles;
+    const bvh_t* bvh = world_get_bvh(&triangles);
+
+    return bvh_raycast(bvh, origin, direction, max_distance, _world_ray_triangle, triangles, distance) >= 0;
+}
+
+// CULLING
+// -------
+static void _world_cull_add_batches(world_batch_t* batches, int batch_count)
+{
+    for (int i = 0; i < batch_count; i++)
+    {
+        for (int s = 0; s < batches[i].submesh_count; s++)
+        {
+            world_submesh_t* submesh = &batches[i].submeshes[s];
+            int index = cull_set_add(&world.cull, submesh->min, submesh->max);
+
+            world.cull_submeshes = realloc(world.cull_submeshes, sizeof(world_submesh_t*) * world.cull.capacity);
+            world.cull_submeshes[index] = submesh;
+        }
+    }
+}
+
+int world_cull(const frustum_t* frustum)
+{
+    if (world.cull_dirty)
+    {
+        cull_set_clear(&world.cull);
+        _world_cull_add_batches(world.batches, world.batch_count);
+        for (int i = 0; i < world.stream.chunk_count; i++) _world_cull_add_batches(world.stream.chunks[i].batches, world.stream.chunks[i].batch_count);
+        world.cull_dirty = 0;
+    }
+
+    int visible_count = frustum_cull_boxes(frustum, &world.cull);
+
+    for (int i = 0; i < world.cull.count; i++) world.cull_submeshes[i]->visible = 0;
+    for (int i = 0; i < visible_count; i++) world.cull_submeshes[world.cull.visible[i]]->visible = 1;
+
+    return visible_count;
+}
+
+// LEVELS OF DETAIL
+// ----------------
+// a batch is one distance from the camera, lods of streamed chunks are what actually kicks in
+static void _world_update_lods(world_batch_t* batches, int batch_count, vec3_t position, float pixel_scale, float delta)
+{
+    for (int i = 0; i < batch_count; i++)
+    {
+        world_batch_t* batch = &batches[i];
+        if (batch->lods.level_count < 2) continue;
+
+        lod_update(&batch->lod, &batch->lods, bounds_distance(batch->min, batch->max, position), pixel_scale, delta);
+    }
+}
+
+void world_update_lods(const camera_t* camera, float viewport_height, float delta)
+{
+    float pixel_scale = lod_pixel_scale(camera, viewport_height);
+
+    _world_update_lods(world.batches, world.batch_count, camera->transform.position, pixel_scale, delta);
+    for (int i = 0; i < world.stream.chunk_count; i++) _world_update_lods(world.stream.chunks[i].batches, world.stream.chunks[i].batch_count, camera->transform.position, pixel_scale, delta);
+}
+
+// DRAWING
+// -------
+static void _world_draw_level(const world_batch_t* batch, rqueue_item_t* item, int level, float fade)
+{
+    item->lod_fade = fade;
+
+    // coarser levels span every submesh, so they go whole as soon as any of them is visible
+    if (level > 0)
+    {
+        for (int s = 0; s < batch->submesh_count; s++)
+        {
+            if (!batch->submeshes[s].visible) continue;
+
+            item->first_index = batch->lods.levels[level].first_index;
+            item->index_count = batch->lods.levels[level].index_count;
+            rqueue_submit(item);
+            return;
+        }
+        return;
+    }
+
+    // one draw per run of visible sub-meshes, so everything visible is one draw
+    int s = 0;
+    while (s < batch->submesh_count)
+    {
+        if (!batch->submeshes[s].visible)
+        {
+            s++;
+            continue;
+        }
+
+        item->first_index = batch->submeshes[s].first_index;
+        item->index_count = 0;
+        while (s < batch->submesh_count && batch->submeshes[s].visible) item->index_count += batch->submeshes[s++].index_count;
+
+        rqueue_submit(item);
+    }
+}
+
+static void _world_draw_batches(world_batch_t* batches, int batch_count)
+{
+    for (int i = 0; i < batch_count; i++)
+    {
+        world_batch_t* batch = &batches[i];
+
+        rqueue_item_t item = { 0 };
+        item.primitive = batch->primitive;
+        item.program = batch->program;
+        item.texture = batch->texture ? batch->texture->id : 0;
+        item.transform = HMM_Mat4d(1.0f); // batches are in world space
+
+        // mid transition both levels draw, dithered into complementary pixels
+        if (batch->lod.transition > 0.0f) _world_draw_level(batch, &item, batch->lod.previous, lod_fade(&batch->lod, 0));
+        _world_draw_level(batch, &item, batch->lod.level, lod_fade(&batch->lod, 1));
+    }
 }
 
 void world_draw()
 {
-    glBindTexture(GL_TEXTURE_2D, tiles_texture.id);
-    glUseProgram(basic_program.id);
-    primitive_draw(&terrain_mesh);
-}
\ No newline at end of file
+    _world_draw_batches(world.batches, world.batch_count);
+
+    // partially uploaded chunks draw whatever materials made it already
+    for (int i = 0; i < world.stream.chunk_count; i++)
+    {
+        struct world_chunk_s* chunk = &world.stream.chunks[i];
+        _world_draw_batches(chunk->batches, chunk->batch_count);
+    }
+}
@@ -1,6 +1,76 @@
 #pragma once
 
-extern void world_generate_test();
+#include "turan_choks.h"
+#include "upper_graphics.h"
+#include "bvh.h"
+
+// STATIC BATCHING
+// ---------------
+// static meshes sharing a program + texture get merged into one buffer at load time.
+// sub-mesh ranges are kept so visibility can still be decided per mesh, world_draw
+// issues one draw per run of visible sub-meshes.
+typedef struct world_submesh_s
+{
+    int first_index, index_count; // into the batch index buffer
+    vec3_t min, max; // world space bounds
+    int visible;
+} world_submesh_t;
+
+typedef struct world_batch_s
+{
+    primitive_t primitive;
+    unsigned int program;
+    texture_t* texture;
+
+    world_submesh_t* submeshes;
+    int submesh_count;
+    vec3_t min, max;
+
+    vec3_t* triangles; // positions kept on the cpu for queries, 3 per triangle
+    int triangle_count;
+
+    lod_chain_t lods; // level 0 draws the visible submeshes, coarser ones the whole batch
+    lod_state_t lod;
+} world_batch_t;
+
+extern void world_add_static(const primitive_std_vertex_t* vertices, int vertex_count, const unsigned int* indices, int index_count, mat4_t transform, program_t program, texture_t* texture); // copied + transformed
+extern void world_build_batches(); // call once every static mesh is added
+extern int world_get_batches(world_batch_t** batches);
+
+extern int world_load_map(const char* path); // cooked .cmap from tooling/mapc.c, returns 0 if missing/invalid
+
+// CHUNK STREAMING
+// ---------------
+// a .cworld (mapc -chunk) is an index of per-cell .cmaps, chunks within the radius of the
+// camera get read on a background thread and uploaded a bit every frame, chunks further than
+// radius + hysteresis get dropped.
+#define WORLD_STREAM_RADIUS 96.0f
+#define WORLD_STREAM_HYSTERESIS 16.0f
+#define WORLD_STREAM_UPLOAD_BUDGET (1024 * 1024) // bytes of chunk geometry sent to gl per frame
+
+typedef struct world_stream_stats_s
+{
+    int chunks;
+    int resident; // fully uploaded
+    int pending; // being read or uploaded
+    size_t bytes_streamed; // total uploaded since open
+} world_stream_stats_t;
+
+extern int world_stream_open(const char* path); // returns 0 if missing/invalid
+extern void world_stream_close();
+extern void world_stream_set_radius(float radius, float hysteresis);
+extern void world_stream_update(vec3_t position); // once per frame before world_draw
+extern world_stream_stats_t world_stream_stats();
+
+extern void world_generate_test(program_t program); // everything in the world draws with it, the caller frees it
 extern void world_cleanup();
 
-extern void world_draw();
+// QUERIES
+// -------
+// every loaded triangle (static + streamed) goes into a bvh, rebuilt lazily after batches change
+extern const bvh_t* world_get_bvh(vec3_t** triangles); // items are triangles, 3 positions each
+extern int world_raycast(vec3_t origin, vec3_t direction, float max_distance, float* distance); // 1 on hit
+
+extern int world_cull(const frustum_t* frustum); // sets submesh visibility for world_draw, returns how many passed
+extern void world_update_lods(const camera_t* camera, float viewport_height, float delta); // picks every batch's level for world_draw
+extern void world_draw(); // submits to the render queue
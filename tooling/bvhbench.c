@@ -0,0 +1,154 @@
+// bvhbench: cpu-only throughput numbers for src/bvh.c, no window or gl context needed
+//
+// USAGE:
+// bvhbench [triangle count, default 1M]
+//
+// builds a bvh over a noisy heightfield and times the build, refit and each query type.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "bvh.h"
+#include "jobs.h"
+
+static double now_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static float random_float(float min, float max)
+{
+    return min + (max - min) * (rand() / (float) RAND_MAX);
+}
+
+static vec3_t* triangles; // 3 per triangle
+
+static float ray_test(void* user, int item, vec3_t origin, vec3_t direction, float max_distance)
+{
+    (void) user;
+    (void) max_distance;
+    return bvh_ray_triangle(origin, direction, triangles[item * 3], triangles[item * 3 + 1], triangles[item * 3 + 2]);
+}
+
+static void fill_bounds(bvh_bounds_t* bounds, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        vec3_t a = triangles[i * 3], b = triangles[i * 3 + 1], c = triangles[i * 3 + 2];
+        bounds[i].min = HMM_Vec3(HMM_MIN(a.x, HMM_MIN(b.x, c.x)), HMM_MIN(a.y, HMM_MIN(b.y, c.y)), HMM_MIN(a.z, HMM_MIN(b.z, c.z)));
+        bounds[i].max = HMM_Vec3(HMM_MAX(a.x, HMM_MAX(b.x, c.x)), HMM_MAX(a.y, HMM_MAX(b.y, c.y)), HMM_MAX(a.z, HMM_MAX(b.z, c.z)));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int wanted = argc > 1 ? atoi(argv[1]) : 1000000;
+    int side = (int) sqrtf(wanted / 2.0f);
+    int count = side * side * 2;
+    float size = 2000.0f, cell = size / side;
+
+    srand(1);
+    triangles = malloc(sizeof(vec3_t) * 3 * count);
+    for (int z = 0, t = 0; z < side; z++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            vec3_t corner[4];
+            for (int i = 0; i < 4; i++)
+            {
+                float px = (x + (i & 1)) * cell - size / 2, pz = (z + (i >> 1)) * cell - size / 2;
+                corner[i] = HMM_Vec3(px, sinf(px * 0.01f) * cosf(pz * 0.013f) * 40.0f, pz);
+            }
+
+            triangles[t++] = corner[0], triangles[t++] = corner[2], triangles[t++] = corner[1];
+            triangles[t++] = corner[1], triangles[t++] = corner[2], triangles[t++] = corner[3];
+        }
+    }
+
+    bvh_bounds_t* bounds = malloc(sizeof(bvh_bounds_t) * count);
+    fill_bounds(bounds, count);
+
+    jobs_setup();
+
+    bvh_t bvh;
+    double start = now_ms();
+    bvh_build(&bvh, bounds, count);
+    printf("build: %i triangles, %i nodes in %.1f ms (%i threads)\n", count, bvh.node_count, now_ms() - start, jobs_thread_count());
+
+    // everything moves a bit, same topology
+    for (int i = 0; i < count * 3; i++) triangles[i].y += 1.0f;
+    fill_bounds(bounds, count);
+    start = now_ms();
+    bvh_refit(&bvh, bounds);
+    printf("refit: %.1f ms\n", now_ms() - start);
+
+    int* results = malloc(sizeof(int) * count);
+    int queries = 1000;
+
+    // frustums from cameras scattered over the field looking at random directions
+    camera_t camera = { 0 };
+    camera.fov = 90.0f;
+    camera.aspect = 16.0f / 9.0f;
+    camera.near = 0.1f;
+    camera.far = 300.0f;
+    camera_update_projection(&camera);
+
+    long long found = 0;
+    double elapsed = 0.0;
+    for (int q = 0; q < queries; q++)
+    {
+        camera.transform.position = HMM_Vec3(random_float(-900, 900), 60.0f, random_float(-900, 900));
+        camera.transform.rotate = HMM_Vec3(random_float(-40, 0), random_float(0, 360), 0.0f);
+        camera_update_view(&camera);
+
+        start = now_ms();
+        found += bvh_query_frustum(&bvh, &camera.frustum, results, count);
+        elapsed += now_ms() - start;
+    }
+    printf("frustum: %.0f queries/s, %lld triangles per query\n", queries / elapsed * 1000.0, found / queries);
+
+    found = 0;
+    start = now_ms();
+    for (int q = 0; q < queries * 10; q++)
+    {
+        vec3_t center = HMM_Vec3(random_float(-900, 900), 0.0f, random_float(-900, 900));
+        found += bvh_query_sphere(&bvh, center, 20.0f, results, count);
+    }
+    elapsed = now_ms() - start;
+    printf("sphere (r 20): %.0f queries/s, %lld triangles per query\n", queries * 10 / elapsed * 1000.0, found / (queries * 10));
+
+    found = 0;
+    start = now_ms();
+    for (int q = 0; q < queries * 10; q++)
+    {
+        vec3_t center = HMM_Vec3(random_float(-900, 900), 0.0f, random_float(-900, 900));
+        found += bvh_query_aabb(&bvh, HMM_SubtractVec3(center, HMM_Vec3(10, 50, 10)), HMM_AddVec3(center, HMM_Vec3(10, 50, 10)), results, count);
+    }
+    elapsed = now_ms() - start;
+    printf("aabb (20x100x20): %.0f queries/s, %lld triangles per query\n", queries * 10 / elapsed * 1000.0, found / (queries * 10));
+
+    // picking style rays from above
+    int rays = 100000, hits = 0;
+    start = now_ms();
+    for (int q = 0; q < rays; q++)
+    {
+        vec3_t origin = HMM_Vec3(random_float(-900, 900), 100.0f, random_float(-900, 900));
+        vec3_t direction = HMM_NormalizeVec3(HMM_Vec3(random_float(-1, 1), -1.0f, random_float(-1, 1)));
+        float distance;
+        hits += bvh_raycast(&bvh, origin, direction, 1000.0f, ray_test, NULL, &distance) >= 0;
+    }
+    elapsed = now_ms() - start;
+    printf("raycast: %.2f million rays/s, %i/%i hit\n", rays / elapsed / 1000.0, hits, rays);
+
+    jobs_cleanup();
+
+    bvh_free(&bvh);
+    free(results);
+    free(bounds);
+    free(triangles);
+    return 0;
+}
@@ -0,0 +1,195 @@
+// lightbench: cpu-only throughput numbers for the light vs cluster test, no window or gl context needed
+//
+// USAGE:
+// lightbench [light count, default 1024] [frames, default 50]
+//
+// builds a cluster grid the same shape as lolita's (KIM_* in lolita.h) and assigns random lights to it
+// with the old per-cluster transform + branchy test and with every spheres_touching_box kernel the cpu has.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "upper_graphics.h"
+#include "jobs.h"
+#include "lolita.h" // only for the grid shape, nothing from it gets called
+
+#define HORIZONTAL KIM_HORIZONTAL_SLICES
+#define VERTICAL KIM_VERTICAL_SLICES
+#define DEPTH KIM_DEPTH_SLICES
+#define CLUSTERS KIM_CLUSTER_COUNT
+#define MAX_IN_CLUSTER KIM_MAX_LIGHTS_IN_CLUSTER
+
+static double now_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static float random_float(float min, float max)
+{
+    return min + (max - min) * (rand() / (float) RAND_MAX);
+}
+
+static vec3_t cluster_min[CLUSTERS], cluster_max[CLUSTERS];
+
+static vec3_t* light_positions; // world space
+static float* light_radii;
+static int light_count;
+
+static mat4_t view;
+static sphere_set_t spheres;
+
+static unsigned int hits[CLUSTERS][MAX_IN_CLUSTER];
+static int hit_counts[CLUSTERS];
+
+// viewspace aabbs of a frustum split up like lolitas grid, exponential in depth
+static void build_grid(const camera_t* camera)
+{
+    float tan_y = tanf(HMM_ToRadians(camera->fov / 2) * 0.5f), tan_x = tan_y * camera->aspect;
+    for (int i = 0; i < CLUSTERS; i++)
+    {
+        int x = i % HORIZONTAL, y = (i / HORIZONTAL) % VERTICAL, z = i / (HORIZONTAL * VERTICAL);
+        float near = camera->near * powf(camera->far / camera->near, (float) z / DEPTH);
+        float far = camera->near * powf(camera->far / camera->near, (float) (z + 1) / DEPTH);
+
+        float x0 = -tan_x + 2.0f * tan_x * x / HORIZONTAL, x1 = -tan_x + 2.0f * tan_x * (x + 1) / HORIZONTAL;
+        float y0 = -tan_y + 2.0f * tan_y * y / VERTICAL, y1 = -tan_y + 2.0f * tan_y * (y + 1) / VERTICAL;
+
+        cluster_min[i] = HMM_Vec3(HMM_MIN(x0 * near, x0 * far), HMM_MIN(y0 * near, y0 * far), -far);
+        cluster_max[i] = HMM_Vec3(HMM_MAX(x1 * near, x1 * far), HMM_MAX(y1 * near, y1 * far), -near);
+    }
+}
+
+// what software_clustering did before: the light goes through the view matrix again for every cluster
+static void assign_legacy()
+{
+    for (int c = 0; c < CLUSTERS; c++)
+    {
+        hit_counts[c] = 0;
+        for (int j = 0; j < light_count && hit_counts[c] < MAX_IN_CLUSTER; j++)
+        {
+            vec3_t center = HMM_MultiplyMat4ByVec4(view, HMM_Vec4v(light_positions[j], 1.0f)).xyz;
+
+            float distance = 0.0f;
+            for (int a = 0; a < 3; a++)
+            {
+                float v = center.elements[a];
+                if (v < cluster_min[c].elements[a]) distance += (cluster_min[c].elements[a] - v) * (cluster_min[c].elements[a] - v);
+                if (v > cluster_max[c].elements[a]) distance += (v - cluster_max[c].elements[a]) * (v - cluster_max[c].elements[a]);
+            }
+
+            if (distance <= light_radii[j] * light_radii[j]) hits[c][hit_counts[c]++] = j;
+        }
+    }
+}
+
+static void transform_lights()
+{
+    sphere_set_clear(&spheres);
+    for (int j = 0; j < light_count; j++)
+    {
+        sphere_set_add(&spheres, HMM_MultiplyMat4ByVec4(view, HMM_Vec4v(light_positions[j], 1.0f)).xyz, light_radii[j]);
+    }
+}
+
+static void assign_range(void* data, int first, int count)
+{
+    for (int c = first; c < first + count; c++)
+    {
+        hit_counts[c] = spheres_touching_box(&spheres, cluster_min[c], cluster_max[c], hits[c], MAX_IN_CLUSTER);
+    }
+}
+
+static void assign_kernel()
+{
+    transform_lights();
+    assign_range(NULL, 0, CLUSTERS);
+}
+
+static void assign_jobs()
+{
+    transform_lights();
+
+    job_counter_t done = { 0 };
+    job_parallel_for(assign_range, NULL, CLUSTERS, 64, &done);
+    job_wait(&done);
+}
+
+static unsigned long long checksum()
+{
+    unsigned long long sum = 0;
+    for (int c = 0; c < CLUSTERS; c++)
+    {
+        sum = sum * 31 + hit_counts[c];
+        for (int i = 0; i < hit_counts[c]; i++) sum = sum * 31 + hits[c][i];
+    }
+    return sum;
+}
+
+static unsigned long long run(const char* name, void (*assign)(), int frames, unsigned long long expected)
+{
+    double start = now_ms();
+    for (int f = 0; f < frames; f++) assign();
+    double elapsed = (now_ms() - start) / frames;
+
+    long long assigned = 0;
+    for (int c = 0; c < CLUSTERS; c++) assigned += hit_counts[c];
+
+    unsigned long long sum = checksum();
+    printf("%-8s %7.3f ms/frame, %7.1f M tests/s, %lld assigned%s\n", name, elapsed, (double) CLUSTERS * light_count / elapsed / 1000.0, assigned, expected && sum != expected ? " MISMATCH" : "");
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    light_count = argc > 1 ? atoi(argv[1]) : 1024;
+    int frames = argc > 2 ? atoi(argv[2]) : 50;
+
+    camera_t camera = { 0 };
+    camera.fov = 90.0f;
+    camera.aspect = 16.0f / 10.0f;
+    camera.near = 0.1f;
+    camera.far = 300.0f;
+    camera.transform.rotate = HMM_Vec3(-10.0f, 30.0f, 0.0f);
+    camera_update_projection(&camera);
+    camera_update_view(&camera);
+    view = camera.matrices.view;
+
+    build_grid(&camera);
+
+    srand(1);
+    light_positions = malloc(sizeof(vec3_t) * light_count);
+    light_radii = malloc(sizeof(float) * light_count);
+    for (int j = 0; j < light_count; j++)
+    {
+        light_positions[j] = HMM_Vec3(random_float(-150, 150), random_float(-10, 30), random_float(-150, 150));
+        light_radii[j] = random_float(2.0f, 12.0f);
+    }
+
+    printf("%i clusters x %i lights\n", CLUSTERS, light_count);
+    unsigned long long expected = run("legacy", assign_legacy, frames, 0);
+
+    static const char* names[] = { "scalar", "sse2", "avx2" };
+    int best = spheres_kernel(-1);
+    for (int level = SIMD_SCALAR; level <= best; level++)
+    {
+        spheres_kernel(level);
+        run(names[level], assign_kernel, frames, expected);
+    }
+
+    jobs_setup();
+    char name[32];
+    snprintf(name, sizeof(name), "%s x%i", names[best], jobs_thread_count());
+    spheres_kernel(best);
+    run(name, assign_jobs, frames, expected);
+    jobs_cleanup();
+
+    sphere_set_free(&spheres);
+    free(light_positions);
+    free(light_radii);
+    return 0;
+}
@@ -0,0 +1,681 @@
+// mapc: compiles content/map text maps into .cmap (see src/cmap.h)
+//
+// USAGE:
+// mapc in.txt out.cmap
+// mapc -chunk size in.txt out.cworld                 streamed, see CHUNKS below
+//
+// FORMAT:
+// materials
+// {
+//     "media/misc/tiles.webp"            texture per material id, in order. optional
+// }
+//
+// vertices
+// {
+//     x y z                              positions, indexed from 0
+// }
+//
+// planes
+// {
+//     vertex(0 1 2 3) uv(su sv ou ov) material(0),
+//     ...
+// }
+//
+// plane vertices are listed in strip order (0 1 2, 2 1 3, ...), any count >= 3.
+// uvs are projected along the plane's dominant axis, scaled by su/sv and offset by ou/ov.
+// uv() or no uv means scale 1, offset 0. material defaults to 0.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+#include <float.h>
+
+#include "../src/cmap.h"
+#include "../src/meshopt.h"
+
+#define MAX_PLANE_VERTICES 64
+#define MAX_MATERIALS 256
+
+typedef struct
+{
+    int vertices[MAX_PLANE_VERTICES];
+    int vertex_count;
+    float uv[4]; // su sv ou ov
+    int material;
+} plane_t;
+
+static struct
+{
+    const char* path;
+    const char* text;
+    const char* at;
+    int line;
+
+    float* positions; // xyz
+    int position_count, position_capacity;
+
+    plane_t* planes;
+    int plane_count, plane_capacity;
+
+    char materials[MAX_MATERIALS][CMAP_PATH_SIZE];
+    int material_count;
+} map;
+
+static int chunk_size; // 0 unless -chunk
+
+static void fail(const char* message)
+{
+    printf("%s:%i: %s\n", map.path, map.line, message);
+    exit(1);
+}
+
+// TOKENIZER
+// ---------
+static void skip_space()
+{
+    while (*map.at)
+    {
+        if (*map.at == '\n') map.line++;
+
+        if (isspace((unsigned char) *map.at)) map.at++;
+        else if (map.at[0] == '/' && map.at[1] == '/')
+        {
+            while (*map.at && *map.at != '\n') map.at++;
+        }
+        else break;
+    }
+}
+
+static int accept(char c)
+{
+    skip_space();
+    if (*map.at != c) return 0;
+    map.at++;
+    return 1;
+}
+
+static void expect(char c)
+{
+    if (!accept(c))
+    {
+        char message[64];
+        snprintf(message, sizeof(message), "expected '%c'", c);
+        fail(message);
+    }
+}
+
+static float number()
+{
+    skip_space();
+    char* end;
+    float value = strtof(map.at, &end);
+    if (end == map.at) fail("expected a number");
+    map.at = end;
+    return value;
+}
+
+static void identifier(char* out, int size)
+{
+    skip_space();
+    int length = 0;
+    while (isalnum((unsigned char) *map.at) || *map.at == '_')
+    {
+        if (length < size - 1) out[length++] = *map.at;
+        map.at++;
+    }
+    out[length] = '\0';
+    if (!length) fail("expected a name");
+}
+
+// PARSER
+// ------
+static void parse_materials()
+{
+    expect('{');
+    while (!accept('}'))
+    {
+        if (accept(',')) continue;
+        if (!accept('"')) fail("expected a quoted texture path");
+        if (map.material_count == MAX_MATERIALS) fail("too many materials");
+
+        char* out = map.materials[map.material_count++];
+        int length = 0;
+        while (*map.at && *map.at != '"' && *map.at != '\n')
+        {
+            if (length == CMAP_PATH_SIZE - 1) fail("texture path too long");
+            out[length++] = *map.at++;
+        }
+        out[length] = '\0';
+        expect('"');
+    }
+}
+
+static void parse_vertices()
+{
+    expect('{');
+    while (!accept('}'))
+    {
+        if (map.position_count == map.position_capacity)
+        {
+            map.position_capacity = map.position_capacity ? map.position_capacity * 2 : 1024;
+            map.positions = realloc(map.positions, sizeof(float) * 3 * map.position_capacity);
+        }
+
+        float* position = map.positions + 3 * map.position_count++;
+        position[0] = number();
+        position[1] = number();
+        position[2] = number();
+        accept(',');
+    }
+}
+
+static void parse_planes()
+{
+    expect('{');
+    while (!accept('}'))
+    {
+        if (map.plane_count == map.plane_capacity)
+        {
+            map.plane_capacity = map.plane_capacity ? map.plane_capacity * 2 : 1024;
+            map.planes = realloc(map.planes, sizeof(plane_t) * map.plane_capacity);
+        }
+
+        plane_t* plane = &map.planes[map.plane_count++];
+        *plane = (plane_t) { .uv = { 1.0f, 1.0f, 0.0f, 0.0f } };
+
+        // items until the separating comma or the end of the block
+        while (1)
+        {
+            skip_space();
+            if (*map.at == ',' || *map.at == '}') break;
+
+            char name[32];
+            identifier(name, sizeof(name));
+            expect('(');
+
+            if (!strcmp(name, "vertex"))
+            {
+                while (!accept(')'))
+                {
+                    if (plane->vertex_count == MAX_PLANE_VERTICES) fail("too many vertices in plane");
+                    float index = number();
+                    if (index < 0 || index >= map.position_count || index != (int) index) fail("vertex index out of range");
+                    plane->vertices[plane->vertex_count++] = (int) index;
+                }
+            }
+            else if (!strcmp(name, "uv"))
+            {
+                int count = 0;
+                float values[4];
+                while (!accept(')'))
+                {
+                    if (count == 4) fail("uv takes at most 4 numbers");
+                    values[count++] = number();
+                }
+
+                // uv(s) -> uniform scale, uv(su sv), uv(su sv ou ov)
+                if (count == 1) plane->uv[0] = plane->uv[1] = values[0];
+                else if (count >= 2) plane->uv[0] = values[0], plane->uv[1] = values[1];
+                if (count == 4) plane->uv[2] = values[2], plane->uv[3] = values[3];
+                else if (count == 3) fail("uv takes 0, 1, 2 or 4 numbers");
+            }
+            else if (!strcmp(name, "material"))
+            {
+                plane->material = (int) number();
+                expect(')');
+            }
+            else fail("unknown plane item (vertex, uv, material)");
+        }
+
+        if (plane->vertex_count < 3) fail("plane needs at least 3 vertices");
+        accept(',');
+    }
+}
+
+static void parse(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        printf("cant open %s\n", path);
+        exit(1);
+    }
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char* text = malloc(length + 1);
+    text[fread(text, 1, length, f)] = '\0';
+    fclose(f);
+
+    map.path = path;
+    map.text = map.at = text;
+    map.line = 1;
+
+    while (1)
+    {
+        skip_space();
+        if (!*map.at) break;
+
+        char name[32];
+        identifier(name, sizeof(name));
+
+        if (!strcmp(name, "materials")) parse_materials();
+        else if (!strcmp(name, "vertices")) parse_vertices();
+        else if (!strcmp(name, "planes")) parse_planes();
+        else fail("unknown block (materials, vertices, planes)");
+    }
+}
+
+// COMPILE
+// -------
+static int compare_material(const void* a, const void* b)
+{
+    const plane_t* x = a;
+    const plane_t* y = b;
+    return (x->material > y->material) - (x->material < y->material);
+}
+
+static uint32_t align(uint32_t offset)
+{
+    return (offset + 15) / 16 * 16;
+}
+
+// read back what was just written and run it through the same checks world_load_map does,
+// a file the runtime refuses is a compiler bug
+static int verify_cmap(const char* path)
+{
+    FILE* in = fopen(path, "rb");
+    if (!in)
+    {
+        printf("cant open %s to verify it\n", path);
+        return 0;
+    }
+
+    fseek(in, 0, SEEK_END);
+    size_t size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    unsigned char* data = malloc(size ? size : 1);
+    size_t read = fread(data, 1, size, in);
+    fclose(in);
+
+    int valid = read == size && cmap_validate(data, size) != NULL;
+    if (!valid) printf("%s: written file doesnt pass cmap_validate, world_load_map would refuse it\n", path);
+    free(data);
+    return valid;
+}
+
+// writes one .cmap for a set of planes, returns its bounds
+static int write_cmap(const char* path, plane_t* planes, int plane_count, float* bounds_min, float* bounds_max)
+{
+    // group by material. mergesort would keep file order but it doesnt matter for drawing
+    qsort(planes, plane_count, sizeof(plane_t), compare_material);
+
+    int vertex_total = 0, index_total = 0;
+    for (int i = 0; i < plane_count; i++)
+    {
+        vertex_total += planes[i].vertex_count;
+        index_total += (planes[i].vertex_count - 2) * 3;
+    }
+
+    vertex_t* vertices = calloc(vertex_total ? vertex_total : 1, sizeof(vertex_t));
+    uint32_t* indices = malloc(sizeof(uint32_t) * (index_total ? index_total : 1));
+    cmap_mesh_t* meshes = malloc(sizeof(cmap_mesh_t) * (plane_count ? plane_count : 1));
+    cmap_material_t* materials = calloc(map.material_count, sizeof(cmap_material_t));
+
+    cmap_header_t header = { 0 };
+    header.magic = CMAP_MAGIC;
+    header.version = CMAP_VERSION;
+    header.material_count = map.material_count;
+    for (int i = 0; i < 3; i++)
+    {
+        header.min[i] = FLT_MAX;
+        header.max[i] = -FLT_MAX;
+    }
+
+    for (int m = 0; m < map.material_count; m++) strcpy(materials[m].texture, map.materials[m]);
+
+    int vertex_count = 0, index_count = 0;
+    for (int p = 0; p < plane_count; p++)
+    {
+        plane_t* plane = &planes[p];
+        cmap_material_t* material = &materials[plane->material];
+        cmap_mesh_t* mesh = &meshes[p];
+
+        if (!material->mesh_count)
+        {
+            material->first_vertex = vertex_count;
+            material->first_index = index_count;
+            material->first_mesh = p;
+        }
+
+        // plane normal picks the projection axis for the uvs
+        float* a = map.positions + 3 * plane->vertices[0];
+        float* b = map.positions + 3 * plane->vertices[1];
+        float* c = map.positions + 3 * plane->vertices[2];
+        float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float normal[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+        float n[3] = { fabsf(normal[0]), fabsf(normal[1]), fabsf(normal[2]) };
+
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int i = 0; i < 3; i++) normal[i] = length > 0.0f ? normal[i] / length : 0.0f;
+
+        int u_axis = 0, v_axis = 2; // y up
+        if (n[0] >= n[1] && n[0] >= n[2]) u_axis = 2, v_axis = 1;
+        else if (n[2] >= n[1]) u_axis = 0, v_axis = 1;
+
+        mesh->first_index = index_count - material->first_index;
+        mesh->index_count = (plane->vertex_count - 2) * 3;
+        for (int i = 0; i < 3; i++)
+        {
+            mesh->min[i] = FLT_MAX;
+            mesh->max[i] = -FLT_MAX;
+        }
+
+        int base = vertex_count - material->first_vertex;
+        for (int v = 0; v < plane->vertex_count; v++)
+        {
+            float* position = map.positions + 3 * plane->vertices[v];
+            vertices[vertex_count++] = (vertex_t) {
+                { position[0], position[1], position[2] },
+                { position[u_axis] * plane->uv[0] + plane->uv[2], position[v_axis] * plane->uv[1] + plane->uv[3] },
+                { normal[0], normal[1], normal[2] },
+            };
+
+            for (int i = 0; i < 3; i++)
+            {
+                mesh->min[i] = fminf(mesh->min[i], position[i]);
+                mesh->max[i] = fmaxf(mesh->max[i], position[i]);
+                header.min[i] = fminf(header.min[i], position[i]);
+                header.max[i] = fmaxf(header.max[i], position[i]);
+            }
+        }
+
+        // strip order, flip every other triangle to keep the winding
+        for (int t = 0; t < plane->vertex_count - 2; t++)
+        {
+            int odd = t & 1;
+            indices[index_count++] = base + t + odd;
+            indices[index_count++] = base + t + 1 - odd;
+            indices[index_count++] = base + t + 2;
+        }
+
+        material->vertex_count = vertex_count - material->first_vertex;
+        material->index_count = index_count - material->first_index;
+        material->mesh_count++;
+    }
+
+    header.index_count = index_count;
+    header.mesh_count = plane_count;
+
+    // optimize and pack each material in the tightest layout it fits
+    unsigned char* packed = malloc(sizeof(vertex_t) * (vertex_total ? vertex_total : 1)); // no layout is bigger than vertex_t
+    unsigned char* packed_indices = calloc(1, sizeof(uint32_t) * index_total * 3 + 16 * map.material_count + 1); // lods take at most twice the full detail, + alignment between materials
+    uint32_t* lod_indices = malloc(sizeof(uint32_t) * (index_total ? index_total : 1) * 2);
+    uint32_t* lod_source = malloc(sizeof(uint32_t) * (index_total ? index_total : 1));
+    unsigned int* remap = malloc(sizeof(unsigned int) * (vertex_total ? vertex_total : 1));
+    meshopt_report_t total = { 0 };
+    vertex_count = 0;
+    for (int m = 0; m < map.material_count; m++)
+    {
+        cmap_material_t* material = &materials[m];
+        vertex_t* first = vertices + material->first_vertex;
+        uint32_t* material_indices = indices + material->first_index;
+        material->first_vertex = vertex_count;
+        if (!material->vertex_count)
+        {
+            // declared but no planes here (or in this chunk), still has to pass validation
+            material->index_size = 2;
+            material->vertex_offset = material->index_offset = 0;
+            material->index_count = material->lod_index_count = material->lod_count = 0;
+            continue;
+        }
+
+        // planes get culled one by one, so triangles cant move between meshes. the cache and
+        // overdraw order work inside each plane (its own vertices, before welding shares them),
+        // welding and fetch order over the whole material
+        meshopt_report_t report = { 0 };
+        report.vertices_before = material->vertex_count;
+        report.before = meshopt_analyze(material_indices, material->index_count, material->vertex_count);
+
+        for (uint32_t i = 0; i < material->mesh_count; i++)
+        {
+            cmap_mesh_t* mesh = &meshes[material->first_mesh + i];
+            uint32_t* mesh_indices = material_indices + mesh->first_index;
+
+            uint32_t base = UINT32_MAX, end = 0;
+            for (uint32_t n = 0; n < mesh->index_count; n++) base = mesh_indices[n] < base ? mesh_indices[n] : base;
+            for (uint32_t n = 0; n < mesh->index_count; n++) end = mesh_indices[n] + 1 > end ? mesh_indices[n] + 1 : end;
+            for (uint32_t n = 0; n < mesh->index_count; n++) mesh_indices[n] -= base;
+
+            meshopt_vertex_cache(mesh_indices, mesh->index_count, end - base);
+            report.clusters += meshopt_overdraw(mesh_indices, mesh->index_count, first + base, end - base, MESHOPT_OVERDRAW_THRESHOLD);
+            for (uint32_t n = 0; n < mesh->index_count; n++) mesh_indices[n] += base;
+        }
+
+        int count = meshopt_weld(first, material->vertex_count, material_indices, material->index_count);
+        count = meshopt_vertex_fetch(first, count, material_indices, material->index_count);
+
+        report.vertices_after = material->vertex_count = count;
+        report.after = meshopt_analyze(material_indices, material->index_count, count);
+        if (!chunk_size) meshopt_print_report(material->texture[0] ? material->texture : "(no texture)", &report);
+
+        total.vertices_before += report.vertices_before;
+        total.vertices_after += report.vertices_after;
+        vertex_count += count;
+
+        // lods of the whole material on the same vertices, culling per plane doesnt apply to them.
+        // planes are flat shaded so no vertex is shared between two, welding by position alone
+        // lets the simplifier work across them. the normals/uvs it picks are off at the creases,
+        // which is fine that far away
+        meshopt_lod_t lods[MESHOPT_LOD_LEVELS - 1];
+        meshopt_position_remap(first[0].position, sizeof(vertex_t), count, remap);
+        for (uint32_t n = 0; n < material->index_count; n++) lod_source[n] = remap[material_indices[n]];
+        material->lod_count = meshopt_build_lods(lod_source, material->index_count, first[0].position, sizeof(vertex_t), count, lod_indices, lods);
+        material->lod_index_count = 0;
+        for (uint32_t l = 0; l < material->lod_count && l < CMAP_LODS; l++)
+        {
+            material->lods[l] = (cmap_lod_t) { material->index_count + lods[l].first_index, lods[l].index_count, lods[l].error };
+            material->lod_index_count = lods[l].first_index + lods[l].index_count;
+            if (!chunk_size) printf("  lod %u: %u triangles, error %f\n", l + 1, lods[l].index_count / 3, lods[l].error);
+        }
+        material->lod_count = material->lod_count < CMAP_LODS ? material->lod_count : CMAP_LODS;
+
+        material->index_size = meshopt_index_size(count);
+        material->index_offset = header.index_bytes;
+        uint32_t material_index_count = material->index_count + material->lod_index_count;
+        if (material->index_size == 2)
+        {
+            meshopt_narrow_indices(material_indices, material->index_count, (uint16_t*) (packed_indices + header.index_bytes));
+            meshopt_narrow_indices(lod_indices, material->lod_index_count, (uint16_t*) (packed_indices + header.index_bytes) + material->index_count);
+        }
+        else
+        {
+            memcpy(packed_indices + header.index_bytes, material_indices, sizeof(uint32_t) * material->index_count);
+            memcpy((uint32_t*) (packed_indices + header.index_bytes) + material->index_count, lod_indices, sizeof(uint32_t) * material->lod_index_count);
+        }
+        header.index_bytes = align(header.index_bytes + material->index_size * material_index_count); // keeps the next run aligned for 4 byte indices
+
+        // textures repeat, so whole texcoords can go. keeps tiled uvs small enough for halfs
+        for (int axis = 0; axis < 2; axis++)
+        {
+            float min = FLT_MAX;
+            for (uint32_t v = 0; v < material->vertex_count; v++) min = fminf(min, first[v].texcoord[axis]);
+            for (uint32_t v = 0; v < material->vertex_count; v++) first[v].texcoord[axis] -= floorf(min);
+        }
+
+        material->layout = vertex_layout_pick(first, material->vertex_count, 1, 0, &material->decode);
+        material->vertex_offset = header.vertex_bytes;
+        vertex_pack(material->layout, material->decode, first, material->vertex_count, packed + header.vertex_bytes);
+        header.vertex_bytes += vertex_layout_stride(material->layout) * material->vertex_count;
+    }
+
+    header.vertex_count = vertex_count;
+    if (!chunk_size && total.vertices_before) printf("welded %i -> %i vertices\n", total.vertices_before, total.vertices_after);
+
+    uint32_t offset = align(sizeof(header));
+    header.material_offset = offset;
+    offset = align(offset + sizeof(cmap_material_t) * header.material_count);
+    header.mesh_offset = offset;
+    offset = align(offset + sizeof(cmap_mesh_t) * header.mesh_count);
+    header.vertex_offset = offset;
+    offset = align(offset + header.vertex_bytes);
+    header.index_offset = offset;
+    offset += header.index_bytes;
+
+    FILE* out = fopen(path, "wb");
+    if (!out)
+    {
+        printf("cant open %s for writing\n", path);
+        return 0;
+    }
+
+    static const unsigned char zeros[16] = { 0 };
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(zeros, 1, header.material_offset - ftell(out), out);
+    fwrite(materials, sizeof(cmap_material_t), header.material_count, out);
+    fwrite(zeros, 1, header.mesh_offset - ftell(out), out);
+    fwrite(meshes, sizeof(cmap_mesh_t), header.mesh_count, out);
+    fwrite(zeros, 1, header.vertex_offset - ftell(out), out);
+    fwrite(packed, 1, header.vertex_bytes, out);
+    fwrite(zeros, 1, header.index_offset - ftell(out), out);
+    fwrite(packed_indices, 1, header.index_bytes, out);
+    fclose(out);
+
+    if (!verify_cmap(path)) return 0;
+
+    if (!chunk_size) printf("%s: %u vertices (%u bytes), %u indices (%u bytes), %u materials, %u meshes, %u bytes\n", path, header.vertex_count, header.vertex_bytes, header.index_count, header.index_bytes, header.material_count, header.mesh_count, offset);
+    free(vertices);
+    free(packed);
+    free(packed_indices);
+    free(lod_indices);
+    free(lod_source);
+    free(remap);
+    free(indices);
+    free(meshes);
+    free(materials);
+
+    memcpy(bounds_min, header.min, sizeof(header.min));
+    memcpy(bounds_max, header.max, sizeof(header.max));
+    return 1;
+}
+
+// CHUNKS
+// ------
+// -chunk splits the map into a grid of size x size cells on xz (by plane center) and writes
+// one .cmap per cell next to a .cworld index the runtime streams from.
+static void plane_cell(plane_t* plane, int* x, int* z)
+{
+    float cx = 0.0f, cz = 0.0f;
+    for (int v = 0; v < plane->vertex_count; v++)
+    {
+        cx += map.positions[3 * plane->vertices[v] + 0];
+        cz += map.positions[3 * plane->vertices[v] + 2];
+    }
+
+    *x = (int) floorf(cx / plane->vertex_count / chunk_size);
+    *z = (int) floorf(cz / plane->vertex_count / chunk_size);
+}
+
+static int compare_cell(const void* a, const void* b)
+{
+    int ax, az, bx, bz;
+    plane_cell((plane_t*) a, &ax, &az);
+    plane_cell((plane_t*) b, &bx, &bz);
+
+    if (ax != bx) return ax < bx ? -1 : 1;
+    return (az > bz) - (az < bz);
+}
+
+static int write_chunks(const char* path)
+{
+    qsort(map.planes, map.plane_count, sizeof(plane_t), compare_cell);
+
+    // "map/big.cworld" -> "big_x_z.cmap" (relative to the index)
+    const char* slash = strrchr(path, '/');
+    const char* name = slash ? slash + 1 : path;
+    int directory_length = (int) (name - path);
+    int name_length = strrchr(name, '.') ? (int) (strrchr(name, '.') - name) : (int) strlen(name);
+
+    cmap_chunk_t* chunks = NULL;
+    int chunk_count = 0;
+
+    int first = 0;
+    while (first < map.plane_count)
+    {
+        int x, z, last = first;
+        plane_cell(&map.planes[first], &x, &z);
+
+        int lx, lz;
+        while (last < map.plane_count && (plane_cell(&map.planes[last], &lx, &lz), lx == x && lz == z)) last++;
+
+        chunks = realloc(chunks, sizeof(cmap_chunk_t) * (chunk_count + 1));
+        cmap_chunk_t* chunk = &chunks[chunk_count++];
+        memset(chunk, 0, sizeof(*chunk));
+        chunk->x = x;
+        chunk->z = z;
+        snprintf(chunk->path, sizeof(chunk->path), "%.*s_%i_%i.cmap", name_length, name, x, z);
+
+        char chunk_path[1024];
+        snprintf(chunk_path, sizeof(chunk_path), "%.*s%s", directory_length, path, chunk->path);
+        if (!write_cmap(chunk_path, map.planes + first, last - first, chunk->min, chunk->max)) return 0;
+
+        first = last;
+    }
+
+    FILE* out = fopen(path, "wb");
+    if (!out)
+    {
+        printf("cant open %s for writing\n", path);
+        return 0;
+    }
+
+    cmap_world_t header = { CMAP_WORLD_MAGIC, CMAP_VERSION, (float) chunk_size, chunk_count };
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(chunks, sizeof(cmap_chunk_t), chunk_count, out);
+    fclose(out);
+
+    printf("%s: %i chunks of %i units\n", path, chunk_count, chunk_size);
+    free(chunks);
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    int chunked = argc == 5 && !strcmp(argv[1], "-chunk");
+    if (chunked)
+    {
+        chunk_size = atoi(argv[2]);
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc != 3 || (chunked && chunk_size <= 0))
+    {
+        printf("usage: mapc in.txt out.cmap\n");
+        printf("       mapc -chunk size in.txt out.cworld\n");
+        return 1;
+    }
+
+    parse(argv[1]);
+
+    if (!map.material_count) map.material_count = 1; // one untextured material
+    for (int i = 0; i < map.plane_count; i++)
+    {
+        if (map.planes[i].material < 0 || map.planes[i].material >= map.material_count)
+        {
+            printf("%s: plane %i uses material %i, only %i defined\n", argv[1], i, map.planes[i].material, map.material_count);
+            return 1;
+        }
+    }
+
+    if (chunked) return write_chunks(argv[2]) ? 0 : 1;
+
+    float min[3], max[3];
+    return write_cmap(argv[2], map.planes, map.plane_count, min, max) ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// pack: bundles a content directory into a .pak (see src/pack.h)
+//
+// USAGE:
+// pack content content/content.pak
+//
+// skips dotfiles, the program binary cache and other .paks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../src/pack.h"
+
+typedef struct
+{
+    char* name; // relative to the root
+    char* path; // on disk
+    uint64_t hash;
+    uint32_t size;
+} file_t;
+
+static struct
+{
+    file_t* items;
+    int count, capacity;
+} files;
+
+static int ends_with(const char* string, const char* suffix)
+{
+    size_t a = strlen(string), b = strlen(suffix);
+    return a >= b && !strcmp(string + a - b, suffix);
+}
+
+static void collect(const char* root, const char* relative)
+{
+    char directory[1024];
+    snprintf(directory, sizeof(directory), "%s%s%s", root, *relative ? "/" : "", relative);
+
+    DIR* dir = opendir(directory);
+    if (!dir) return;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)))
+    {
+        if (entry->d_name[0] == '.') continue;
+        if (!*relative && !strcmp(entry->d_name, "cache")) continue; // CHOKS_PROGRAM_CACHE_DIR, per machine
+        if (ends_with(entry->d_name, ".pak")) continue;
+
+        char name[1024], path[2048];
+        snprintf(name, sizeof(name), "%s%s%s", relative, *relative ? "/" : "", entry->d_name);
+        snprintf(path, sizeof(path), "%s/%s", root, name);
+
+        struct stat st;
+        if (stat(path, &st)) continue;
+
+        if (S_ISDIR(st.st_mode))
+        {
+            collect(root, name);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode)) continue;
+
+        if (files.count == files.capacity)
+        {
+            files.capacity = files.capacity ? files.capacity * 2 : 64;
+            files.items = realloc(files.items, sizeof(file_t) * files.capacity);
+        }
+
+        files.items[files.count++] = (file_t) { strdup(name), strdup(path), pack_hash(name), (uint32_t) st.st_size };
+    }
+
+    closedir(dir);
+}
+
+static int compare_hash(const void* a, const void* b)
+{
+    uint64_t x = ((const file_t*) a)->hash, y = ((const file_t*) b)->hash;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t align(uint32_t offset)
+{
+    return (offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        printf("usage: pack content content/content.pak\n");
+        return 1;
+    }
+
+    collect(argv[1], "");
+    qsort(files.items, files.count, sizeof(file_t), compare_hash);
+
+    for (int i = 1; i < files.count; i++)
+    {
+        if (files.items[i].hash == files.items[i - 1].hash)
+        {
+            printf("hash collision: %s and %s, rename one of them\n", files.items[i - 1].name, files.items[i].name);
+            return 1;
+        }
+    }
+
+    // lay it out
+    pack_entry_t* entries = calloc(files.count ? files.count : 1, sizeof(pack_entry_t));
+    uint32_t offset = sizeof(pack_header_t) + sizeof(pack_entry_t) * files.count;
+
+    for (int i = 0; i < files.count; i++)
+    {
+        entries[i].hash = files.items[i].hash;
+        entries[i].name_offset = offset;
+        entries[i].name_length = strlen(files.items[i].name);
+        offset += entries[i].name_length + 1;
+    }
+
+    for (int i = 0; i < files.count; i++)
+    {
+        offset = align(offset);
+        entries[i].offset = offset;
+        entries[i].size = files.items[i].size;
+        offset += files.items[i].size + 1; // + '\0'
+    }
+
+    FILE* out = fopen(argv[2], "wb");
+    if (!out)
+    {
+        printf("cant open %s for writing\n", argv[2]);
+        return 1;
+    }
+
+    pack_header_t header = { PACK_MAGIC, PACK_VERSION, files.count, 0 };
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(entries, sizeof(pack_entry_t), files.count, out);
+
+    for (int i = 0; i < files.count; i++) fwrite(files.items[i].name, 1, entries[i].name_length + 1, out);
+
+    static const unsigned char zeros[PACK_ALIGN] = { 0 };
+    for (int i = 0; i < files.count; i++)
+    {
+        fwrite(zeros, 1, entries[i].offset - ftell(out), out);
+
+        FILE* in = fopen(files.items[i].path, "rb");
+        unsigned char* data = malloc(files.items[i].size + 1);
+        if (!in || fread(data, 1, files.items[i].size, in) != files.items[i].size)
+        {
+            printf("failed to read %s\n", files.items[i].path);
+            return 1;
+        }
+        fclose(in);
+
+        data[files.items[i].size] = '\0';
+        fwrite(data, 1, files.items[i].size + 1, out);
+        free(data);
+    }
+
+    fclose(out);
+    printf("%s: %i files, %u bytes\n", argv[2], files.count, offset);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// streambench: cpu cost of rqueue_flush when every draw has its own transform, so every one
+// of them streams a model block
+//
+// USAGE:
+// streambench [draws, default 300] [frames, default 1000]
+//
+// runs the same frames twice, once through the cpu copy of the stream ring and once persistently
+// mapped (if GL_ARB_buffer_storage is there), and prints the flush time plus a checksum of the
+// rendered pixels, which has to match between the two. build it at an older commit for a before.
+//
+// opens a hidden sdl window for the context. build with -DSTREAMBENCH_EGL -lEGL instead of
+// -lSDL2 for a headless context (mesa surfaceless), no display needed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "turan_choks.h"
+#include "rqueue.h"
+
+#ifdef STREAMBENCH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#define TARGET_SIZE 64
+#define WARMUP_FRAMES 20
+
+static const char* vertex_source =
+    "#version 400 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (std140) uniform mvp { mat4 model; vec4 decode_scale; vec4 decode_bias; };\n"
+    "layout (std140) uniform viewprojection { mat4 view; mat4 projection; };\n"
+    "void main() { gl_Position = projection * view * model * vec4(position * decode_scale.xyz + decode_bias.xyz, 1.0); }\n";
+
+static const char* fragment_source =
+    "#version 400 core\n"
+    "out vec4 color;\n"
+    "void main() { color = vec4(1.0); }\n";
+
+static double now_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static int create_context()
+{
+    #ifdef STREAMBENCH_EGL
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay display = get_platform_display ? get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (!eglInitialize(display, NULL, NULL)) return 0;
+    eglBindAPI(EGL_OPENGL_API);
+
+    EGLint attributes[] = { EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 0, EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (!context || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return 0;
+
+    return gladLoadGL((GLADloadfunc) eglGetProcAddress);
+    #else
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) return 0;
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+    SDL_Window* window = SDL_CreateWindow("streambench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, TARGET_SIZE, TARGET_SIZE, SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL);
+    if (!window || !SDL_GL_CreateContext(window)) return 0;
+
+    return gladLoadGL((GLADloadfunc) SDL_GL_GetProcAddress);
+    #endif
+}
+
+// setup_choks picks the stream path, so each run gets a fresh one
+static void run(const char* name, int draws, int frames)
+{
+    setup_choks();
+
+    unsigned int framebuffer, color;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TARGET_SIZE, TARGET_SIZE);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    choks_viewport(0, 0, TARGET_SIZE, TARGET_SIZE);
+
+    program_t program = program_load_from_source(vertex_source, fragment_source);
+    float triangle[] = { 0, 0, 0, 0, 0,   1, 0, 0, 1, 0,   0, 1, 0, 0, 1 };
+    primitive_t primitive = primitive_load(triangle, 3, GL_TRIANGLES);
+    set_view_and_projection_matrices(HMM_Mat4d(1.0f), HMM_Mat4d(1.0f));
+
+    double flush = 0.0;
+    unsigned long long checksum = 0;
+    for (int f = 0; f < WARMUP_FRAMES + frames; f++)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (int i = 0; i < draws; i++)
+        {
+            rqueue_item_t item = { 0 };
+            item.primitive = primitive;
+            item.program = program.id;
+            item.transform = HMM_Translate(HMM_Vec3((i % 20) * 0.01f, (i / 20) * 0.01f, (f % 100) * 0.001f));
+            item.depth = 1.0f + i;
+            rqueue_submit(&item);
+        }
+
+        double start = now_ms();
+        rqueue_flush();
+        if (f >= WARMUP_FRAMES) flush += now_ms() - start;
+
+        glFinish();
+        if (f == WARMUP_FRAMES + frames - 1)
+        {
+            static unsigned char pixels[TARGET_SIZE * TARGET_SIZE * 4];
+            glReadPixels(0, 0, TARGET_SIZE, TARGET_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            for (int p = 0; p < (int) sizeof(pixels); p++) checksum = checksum * 31 + pixels[p];
+        }
+        choks_end_frame();
+    }
+
+    printf("%-10s %5i draws: flush %.3f ms, pixels %016llx\n", name, draws, flush / frames, checksum);
+
+    primitive_free(&primitive);
+    program_free(program);
+    glDeleteRenderbuffers(1, &color);
+    glDeleteFramebuffers(1, &framebuffer);
+    rqueue_cleanup();
+    cleanup_choks();
+}
+
+int main(int argc, char** argv)
+{
+    int draws = argc > 1 ? atoi(argv[1]) : 300;
+    int frames = argc > 2 ? atoi(argv[2]) : 1000;
+
+    if (!create_context())
+    {
+        printf("no gl 4.0 core context.\n");
+        return 1;
+    }
+    printf("%s | %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    int persistent = GLAD_GL_ARB_buffer_storage;
+    GLAD_GL_ARB_buffer_storage = 0;
+    run("cpu copy", draws, frames);
+
+    GLAD_GL_ARB_buffer_storage = persistent;
+    if (persistent) run("persistent", draws, frames);
+    else printf("no GL_ARB_buffer_storage, skipping the persistent run\n");
+
+    return 0;
+}
@@ -0,0 +1,621 @@
+// texcook: bakes webp/png sources into .ctex (see src/ctex.h)
+//
+// USAGE:
+// texcook out.ctex in.webp                          2d texture
+// texcook -cube out.ctex in.webp                    6 frame animated webp (see skyboxfmt.txt)
+// texcook -cube out.ctex px.png nx.png py.png ny.png pz.png nz.png
+//
+// every output gets a full box filtered mip chain.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <webp/decode.h>
+#include <webp/demux.h>
+
+#include "../src/ctex.h"
+
+typedef struct
+{
+    unsigned char* pixels; // rgba8
+    int width, height;
+} face_t;
+
+static unsigned char* slurp_bytes(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned char* data = malloc(length ? length : 1);
+    if (data && fread(data, 1, length, file) != (size_t) length)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *size = length;
+    return data;
+}
+
+static int ends_with(const char* string, const char* suffix)
+{
+    size_t a = strlen(string), b = strlen(suffix);
+    return a >= b && !strcmp(string + a - b, suffix);
+}
+
+static void flip_rows(face_t* face)
+{
+    size_t stride = (size_t) face->width * 4;
+    unsigned char* row = malloc(stride);
+
+    for (int y = 0; y < face->height / 2; y++)
+    {
+        unsigned char* a = face->pixels + stride * y;
+        unsigned char* b = face->pixels + stride * (face->height - 1 - y);
+        memcpy(row, a, stride);
+        memcpy(a, b, stride);
+        memcpy(b, row, stride);
+    }
+
+    free(row);
+}
+
+// INFLATE
+// -------
+// just enough zlib for png, no dictionaries.
+typedef struct
+{
+    const unsigned char* data;
+    size_t size, pos;
+    uint32_t bits;
+    int bit_count;
+
+    unsigned char* out;
+    size_t out_size, out_pos;
+} inflate_t;
+
+typedef struct
+{
+    uint16_t counts[16];
+    uint16_t symbols[288];
+} huffman_t;
+
+static int inflate_bits(inflate_t* z, int count)
+{
+    while (z->bit_count < count)
+    {
+        if (z->pos >= z->size) return -1;
+        z->bits |= (uint32_t) z->data[z->pos++] << z->bit_count;
+        z->bit_count += 8;
+    }
+
+    int value = z->bits & ((1u << count) - 1);
+    z->bits >>= count;
+    z->bit_count -= count;
+    return value;
+}
+
+static int huffman_build(huffman_t* h, const unsigned char* lengths, int count)
+{
+    uint16_t offsets[16];
+    memset(h->counts, 0, sizeof(h->counts));
+
+    for (int i = 0; i < count; i++) h->counts[lengths[i]]++;
+    h->counts[0] = 0;
+
+    offsets[1] = 0;
+    for (int i = 1; i < 15; i++) offsets[i + 1] = offsets[i] + h->counts[i];
+
+    for (int i = 0; i < count; i++)
+    {
+        if (lengths[i]) h->symbols[offsets[lengths[i]]++] = i;
+    }
+    return 0;
+}
+
+// canonical decode one bit at a time, slow but these are tiny offline inputs
+static int huffman_decode(inflate_t* z, huffman_t* h)
+{
+    int code = 0, first = 0, index = 0;
+    for (int length = 1; length < 16; length++)
+    {
+        int bit = inflate_bits(z, 1);
+        if (bit < 0) return -1;
+
+        code |= bit;
+        int count = h->counts[length];
+        if (code - count < first) return h->symbols[index + (code - first)];
+
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static int inflate_codes(inflate_t* z, huffman_t* lengths, huffman_t* distances)
+{
+    static const uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    while (1)
+    {
+        int symbol = huffman_decode(z, lengths);
+        if (symbol < 0) return -1;
+
+        if (symbol < 256)
+        {
+            if (z->out_pos >= z->out_size) return -1;
+            z->out[z->out_pos++] = symbol;
+        }
+        else if (symbol == 256) return 0;
+        else
+        {
+            symbol -= 257;
+            if (symbol >= 29) return -1;
+            int length = length_base[symbol] + inflate_bits(z, length_extra[symbol]);
+
+            int d = huffman_decode(z, distances);
+            if (d < 0 || d >= 30) return -1;
+            size_t distance = distance_base[d] + inflate_bits(z, distance_extra[d]);
+
+            if (distance > z->out_pos || z->out_pos + length > z->out_size) return -1;
+            for (int i = 0; i < length; i++, z->out_pos++) z->out[z->out_pos] = z->out[z->out_pos - distance];
+        }
+    }
+}
+
+static int inflate_dynamic(inflate_t* z, huffman_t* lengths, huffman_t* distances)
+{
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    int literal_count = inflate_bits(z, 5) + 257;
+    int distance_count = inflate_bits(z, 5) + 1;
+    int code_count = inflate_bits(z, 4) + 4;
+
+    unsigned char code_lengths[19] = { 0 };
+    for (int i = 0; i < code_count; i++) code_lengths[order[i]] = inflate_bits(z, 3);
+
+    huffman_t codes;
+    huffman_build(&codes, code_lengths, 19);
+
+    unsigned char all[288 + 32] = { 0 };
+    int n = 0;
+    while (n < literal_count + distance_count)
+    {
+        int symbol = huffman_decode(z, &codes);
+        if (symbol < 0) return -1;
+
+        if (symbol < 16) all[n++] = symbol;
+        else
+        {
+            int repeat, value = 0;
+            if (symbol == 16)
+            {
+                if (!n) return -1;
+                value = all[n - 1];
+                repeat = 3 + inflate_bits(z, 2);
+            }
+            else if (symbol == 17) repeat = 3 + inflate_bits(z, 3);
+            else repeat = 11 + inflate_bits(z, 7);
+
+            if (n + repeat > literal_count + distance_count) return -1;
+            while (repeat--) all[n++] = value;
+        }
+    }
+
+    huffman_build(lengths, all, literal_count);
+    huffman_build(distances, all + literal_count, distance_count);
+    return 0;
+}
+
+static int inflate_zlib(const unsigned char* data, size_t size, unsigned char* out, size_t out_size)
+{
+    inflate_t z = { data, size, 2, 0, 0, out, out_size, 0 }; // skip the zlib header
+
+    if (size < 2 || (data[0] & 0x0f) != 8 || (data[1] & 0x20)) return -1;
+
+    int last = 0;
+    while (!last)
+    {
+        last = inflate_bits(&z, 1);
+        int type = inflate_bits(&z, 2);
+
+        if (type == 0)
+        {
+            // stored, drop to the byte boundary
+            z.bits = 0;
+            z.bit_count = 0;
+            if (z.pos + 4 > z.size) return -1;
+
+            size_t length = z.data[z.pos] | z.data[z.pos + 1] << 8;
+            z.pos += 4;
+            if (z.pos + length > z.size || z.out_pos + length > z.out_size) return -1;
+
+            memcpy(z.out + z.out_pos, z.data + z.pos, length);
+            z.pos += length;
+            z.out_pos += length;
+        }
+        else if (type == 1)
+        {
+            unsigned char lengths[288 + 32];
+            for (int i = 0; i < 144; i++) lengths[i] = 8;
+            for (int i = 144; i < 256; i++) lengths[i] = 9;
+            for (int i = 256; i < 280; i++) lengths[i] = 7;
+            for (int i = 280; i < 288; i++) lengths[i] = 8;
+            for (int i = 288; i < 320; i++) lengths[i] = 5;
+
+            huffman_t literal, distance;
+            huffman_build(&literal, lengths, 288);
+            huffman_build(&distance, lengths + 288, 32);
+            if (inflate_codes(&z, &literal, &distance)) return -1;
+        }
+        else if (type == 2)
+        {
+            huffman_t literal, distance;
+            if (inflate_dynamic(&z, &literal, &distance)) return -1;
+            if (inflate_codes(&z, &literal, &distance)) return -1;
+        }
+        else return -1;
+    }
+
+    return z.out_pos == out_size ? 0 : -1;
+}
+
+// PNG
+// ---
+// 8 bit gray/gray+alpha/rgb/rgba, non interlaced. thats what the cubemap tools spit out.
+static uint32_t read_be32(const unsigned char* p)
+{
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+static int load_png(const char* path, face_t* face)
+{
+    size_t size;
+    unsigned char* data = slurp_bytes(path, &size);
+    if (!data) return -1;
+
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+    if (size < 8 || memcmp(data, signature, 8))
+    {
+        free(data);
+        return -1;
+    }
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char* idat = NULL;
+    size_t idat_size = 0;
+
+    size_t pos = 8;
+    while (pos + 12 <= size)
+    {
+        uint32_t length = read_be32(data + pos);
+        const unsigned char* type = data + pos + 4;
+        const unsigned char* chunk = data + pos + 8;
+        if (pos + 12 + length > size) break;
+
+        if (!memcmp(type, "IHDR", 4))
+        {
+            width = read_be32(chunk);
+            height = read_be32(chunk + 4);
+            int depth = chunk[8], color = chunk[9], interlace = chunk[12];
+
+            if (depth != 8 || interlace)
+            {
+                printf("%s: only 8 bit non interlaced pngs are supported\n", path);
+                break;
+            }
+
+            channels = color == 0 ? 1 : color == 4 ? 2 : color == 2 ? 3 : color == 6 ? 4 : 0;
+            if (!channels)
+            {
+                printf("%s: unsupported png color type %i\n", path, color);
+                break;
+            }
+        }
+        else if (!memcmp(type, "IDAT", 4))
+        {
+            idat = realloc(idat, idat_size + length);
+            memcpy(idat + idat_size, chunk, length);
+            idat_size += length;
+        }
+        else if (!memcmp(type, "IEND", 4)) break;
+
+        pos += 12 + length;
+    }
+    free(data);
+
+    if (!channels || !idat)
+    {
+        free(idat);
+        return -1;
+    }
+
+    size_t stride = (size_t) width * channels;
+    unsigned char* raw = malloc((stride + 1) * height);
+    int result = inflate_zlib(idat, idat_size, raw, (stride + 1) * height);
+    free(idat);
+
+    if (result)
+    {
+        printf("%s: bad zlib stream\n", path);
+        free(raw);
+        return -1;
+    }
+
+    // unfilter in place, each row is prefixed with its filter type
+    unsigned char* prior = NULL;
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char* row = raw + (stride + 1) * y + 1;
+        int filter = row[-1];
+
+        for (size_t x = 0; x < stride; x++)
+        {
+            int a = x >= (size_t) channels ? row[x - channels] : 0;
+            int b = prior ? prior[x] : 0;
+            int c = prior && x >= (size_t) channels ? prior[x - channels] : 0;
+
+            switch (filter)
+            {
+                case 1: row[x] += a; break;
+                case 2: row[x] += b; break;
+                case 3: row[x] += (a + b) / 2; break;
+                case 4: row[x] += paeth(a, b, c); break;
+            }
+        }
+        prior = row;
+    }
+
+    face->width = width;
+    face->height = height;
+    face->pixels = malloc((size_t) width * height * 4);
+
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char* src = raw + (stride + 1) * y + 1;
+        unsigned char* dst = face->pixels + (size_t) width * 4 * y;
+
+        for (int x = 0; x < width; x++, src += channels, dst += 4)
+        {
+            int gray = channels < 3;
+            dst[0] = src[0];
+            dst[1] = src[gray ? 0 : 1];
+            dst[2] = src[gray ? 0 : 2];
+            dst[3] = channels == 2 ? src[1] : channels == 4 ? src[3] : 255;
+        }
+    }
+
+    free(raw);
+    return 0;
+}
+
+// WEBP
+// ----
+static int load_webp(const char* path, face_t* face)
+{
+    size_t size;
+    unsigned char* data = slurp_bytes(path, &size);
+    if (!data) return -1;
+
+    face->pixels = WebPDecodeRGBA(data, size, &face->width, &face->height);
+    free(data);
+
+    return face->pixels ? 0 : -1;
+}
+
+static int load_webp_cube(const char* path, face_t* faces)
+{
+    size_t size;
+    unsigned char* data = slurp_bytes(path, &size);
+    if (!data) return -1;
+
+    WebPData webp_data = { data, size };
+
+    WebPAnimDecoderOptions options;
+    WebPAnimDecoderOptionsInit(&options);
+    options.color_mode = MODE_RGBA;
+
+    WebPAnimDecoder* decoder = WebPAnimDecoderNew(&webp_data, &options);
+    if (!decoder)
+    {
+        free(data);
+        return -1;
+    }
+
+    WebPAnimInfo info;
+    WebPAnimDecoderGetInfo(decoder, &info);
+
+    int result = -1;
+    if (info.frame_count == 6)
+    {
+        size_t face_size = (size_t) info.canvas_width * info.canvas_height * 4;
+        for (int i = 0; i < 6 && WebPAnimDecoderHasMoreFrames(decoder); i++)
+        {
+            uint8_t* buf;
+            int timestamp;
+            WebPAnimDecoderGetNext(decoder, &buf, &timestamp);
+
+            faces[i].width = info.canvas_width;
+            faces[i].height = info.canvas_height;
+            faces[i].pixels = malloc(face_size);
+            memcpy(faces[i].pixels, buf, face_size); // the decoder reuses buf
+        }
+        result = 0;
+    }
+    else printf("%s: cubemap webp does not have EXACTLY 6 frames.\n", path);
+
+    WebPAnimDecoderDelete(decoder);
+    free(data);
+    return result;
+}
+
+static int load_image(const char* path, face_t* face)
+{
+    int result = ends_with(path, ".png") ? load_png(path, face) : load_webp(path, face);
+    if (result) printf("failed to load %s\n", path);
+    return result;
+}
+
+// MIPS
+// ----
+// 2x2 box filter, odd sizes clamp to the last row/column
+static face_t downsample(face_t* src)
+{
+    face_t dst;
+    dst.width = src->width > 1 ? src->width / 2 : 1;
+    dst.height = src->height > 1 ? src->height / 2 : 1;
+    dst.pixels = malloc((size_t) dst.width * dst.height * 4);
+
+    for (int y = 0; y < dst.height; y++)
+    {
+        int y0 = y * 2, y1 = y * 2 + 1 < src->height ? y * 2 + 1 : src->height - 1;
+        for (int x = 0; x < dst.width; x++)
+        {
+            int x0 = x * 2, x1 = x * 2 + 1 < src->width ? x * 2 + 1 : src->width - 1;
+
+            const unsigned char* a = src->pixels + ((size_t) y0 * src->width + x0) * 4;
+            const unsigned char* b = src->pixels + ((size_t) y0 * src->width + x1) * 4;
+            const unsigned char* c = src->pixels + ((size_t) y1 * src->width + x0) * 4;
+            const unsigned char* d = src->pixels + ((size_t) y1 * src->width + x1) * 4;
+            unsigned char* out = dst.pixels + ((size_t) y * dst.width + x) * 4;
+
+            for (int i = 0; i < 4; i++) out[i] = (a[i] + b[i] + c[i] + d[i] + 2) / 4;
+        }
+    }
+
+    return dst;
+}
+
+static int write_ctex(const char* path, ctex_type_t type, face_t* faces, int face_count)
+{
+    ctex_header_t header = { 0 };
+    header.magic = CTEX_MAGIC;
+    header.version = CTEX_VERSION;
+    header.type = type;
+    header.format = CTEX_FORMAT_RGBA8;
+    header.width = faces[0].width;
+    header.height = faces[0].height;
+    header.faces = face_count;
+
+    uint32_t largest = header.width > header.height ? header.width : header.height;
+    header.levels = 1;
+    while (largest >> header.levels) header.levels++;
+    if (header.levels > CTEX_MAX_LEVELS) header.levels = CTEX_MAX_LEVELS;
+
+    ctex_level_t table[CTEX_MAX_LEVELS * 6];
+    uint32_t offset = sizeof(header) + sizeof(ctex_level_t) * header.levels * face_count;
+
+    for (uint32_t level = 0; level < header.levels; level++)
+    {
+        uint32_t size = ctex_level_dimension(header.width, level) * ctex_level_dimension(header.height, level) * 4;
+        for (int face = 0; face < face_count; face++)
+        {
+            offset = (offset + CTEX_ALIGN - 1) / CTEX_ALIGN * CTEX_ALIGN;
+            table[level * face_count + face] = (ctex_level_t) { offset, size };
+            offset += size;
+        }
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("cant open %s for writing\n", path);
+        return -1;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(table, sizeof(ctex_level_t), header.levels * face_count, file);
+
+    // faces get replaced by their next level as we go
+    static const unsigned char zeros[CTEX_ALIGN] = { 0 };
+    for (uint32_t level = 0; level < header.levels; level++)
+    {
+        for (int face = 0; face < face_count; face++)
+        {
+            ctex_level_t* entry = &table[level * face_count + face];
+            long pad = (long) entry->offset - ftell(file);
+            fwrite(zeros, 1, pad, file);
+            fwrite(faces[face].pixels, 1, entry->size, file);
+
+            if (level + 1 < header.levels)
+            {
+                face_t next = downsample(&faces[face]);
+                free(faces[face].pixels);
+                faces[face] = next;
+            }
+        }
+    }
+
+    fclose(file);
+    printf("%s: %ux%u, %i face(s), %u levels, %u bytes\n", path, header.width, header.height, face_count, header.levels, offset);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int cube = argc > 1 && !strcmp(argv[1], "-cube");
+    char** args = argv + 1 + cube;
+    int count = argc - 1 - cube;
+
+    if (count != 2 && !(cube && count == 7))
+    {
+        printf("usage: texcook out.ctex in.webp\n");
+        printf("       texcook -cube out.ctex in.webp\n");
+        printf("       texcook -cube out.ctex px.png nx.png py.png ny.png pz.png nz.png\n");
+        return 1;
+    }
+
+    face_t faces[6] = { 0 };
+    int face_count = cube ? 6 : 1;
+
+    if (!cube)
+    {
+        if (load_image(args[1], &faces[0])) return 1;
+        flip_rows(&faces[0]); // 2d textures are bottom up, same as the runtime webp path
+    }
+    else if (count == 2)
+    {
+        if (load_webp_cube(args[1], faces)) return 1;
+    }
+    else
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            if (load_image(args[1 + i], &faces[i])) return 1;
+        }
+    }
+
+    for (int i = 1; i < face_count; i++)
+    {
+        if (faces[i].width != faces[0].width || faces[i].height != faces[0].height)
+        {
+            printf("cubemap faces need to be the same size\n");
+            return 1;
+        }
+    }
+
+    int result = write_ctex(args[0], cube ? CTEX_TYPE_CUBEMAP : CTEX_TYPE_2D, faces, face_count);
+
+    for (int i = 0; i < face_count; i++) free(faces[i].pixels);
+    return result ? 1 : 0;
+}